@@ -3,6 +3,7 @@ lines = [
     "# vmd -dispdev text -e QB_capsid.pgn",
     "package require psfgen",
     "topology top_all36_prot.rtf",
+    "topology top_all36_cgenff_CBD_template.rtf",
     "topology top_all36_cgenff_CBD.rtf",
     "pdbalias residue HIS HSE",
     "pdbalias atom ILE CD1 CD"
@@ -10,6 +10,7 @@ def generate_vmd_script():
         '# vmd -dispdev text -e TMV_all_out.pgn',
         'package require psfgen',
         'topology top_all36_prot.rtf',
+        'topology top_all36_cgenff_CBD_template.rtf',
         'topology top_all36_cgenff_CBD.rtf',
         'pdbalias residue HIS HSE',
         'pdbalias atom ILE CD1 CD',
@@ -0,0 +1,291 @@
+// AtomTypeRenamer.cpp
+#include "AtomTypeRenamer.h"
+#include "CharmmStream.h"
+#include "ICTable.h"
+#include "Logger.h"
+#include <cctype>
+#include <sstream>
+
+using namespace std;
+
+TypeRenameReport::TypeRenameReport()
+    : residueAtoms(0), atomsRenamed(0), impropersRemoved(0), parametersRemoved(0), permutationsAdded(0) {
+}
+
+// ── Protein atom types ───────────────────────────────────────────────────────
+
+struct AtomTypePair {
+    const char* name;
+    const char* type;
+};
+
+// Backbone, then side chain, then the CX/OX/NX/HX caps that noX removes
+static const AtomTypePair lysTypes[] = {
+    {"N", "NH1"},   {"CA", "CT1"},  {"C", "C"},     {"O", "O"},     {"H", "HN"},    {"HA", "HB1"},
+    {"CB", "CT2"},  {"CG", "CT2"},  {"CD", "CT2"},  {"CE", "CT2"},  {"NZ", "NH2"},  {"HZ", "H"},
+    {"HB1", "HB2"}, {"HB2", "HB2"}, {"HG1", "HB2"}, {"HG2", "HB2"}, {"HD1", "HB2"}, {"HD2", "HB2"},
+    {"HE1", "HB2"}, {"HE2", "HB2"}, {"CX", "C"},    {"OX", "O"},    {"NX", "NH2"},  {"HX1", "H"},
+    {"HX2", "H"},
+};
+
+static const AtomTypePair cysTypes[] = {
+    {"N", "NH1"},  {"CA", "CT1"},   {"C", "C"},     {"O", "O"},  {"H", "HN"},    {"HA", "HB1"},
+    {"CB", "CT2"}, {"SG", "S"},     {"HB1", "HB2"}, {"HB2", "HB2"}, {"CX", "C"}, {"OX", "O"},
+    {"NX", "NH2"}, {"HX1", "H"},    {"HX2", "H"},
+};
+
+static const AtomTypePair tyrTypes[] = {
+    {"N", "NH1"},  {"CA", "CT1"},  {"C", "C"},     {"O", "O"},     {"H", "HN"},    {"HA", "HB1"},
+    {"CB", "CT2"}, {"CG", "CA"},   {"CD1", "CA"},  {"CD2", "CA"},  {"CE1", "CA"},  {"CE2", "CA"},
+    {"CZ", "CA"},  {"OH", "OH1"},  {"HB1", "HB2"}, {"HB2", "HB2"}, {"HD1", "HP"},  {"HD2", "HP"},
+    {"HE1", "HP"}, {"HE2", "HP"},  {"CX", "C"},    {"OX", "O"},    {"NX", "NH2"},  {"HX1", "H"},
+    {"HX2", "H"},
+};
+
+static const AtomTypePair ntrmTypes[] = {
+    {"N", "NH1"},   {"CA", "CT1"},  {"C", "C"},     {"O", "O"},   {"HA", "HB1"},
+    {"CB", "CT3"},  {"HB1", "HA3"}, {"HB2", "HA3"}, {"HB3", "HA3"}, {"HN1", "H"},
+};
+
+template <size_t N>
+static void assignTypes(const AtomTypePair (&pairs)[N], map<string, string>& atomTypes) {
+    atomTypes.clear();
+    for (size_t i = 0; i < N; ++i) atomTypes[pairs[i].name] = pairs[i].type;
+}
+
+bool proteinAtomTypes(const string& aminoAcid, map<string, string>& atomTypes) {
+    if (aminoAcid == "lys") assignTypes(lysTypes, atomTypes);
+    else if (aminoAcid == "cys") assignTypes(cysTypes, atomTypes);
+    else if (aminoAcid == "tyr") assignTypes(tyrTypes, atomTypes);
+    else if (aminoAcid == "ntrm") assignTypes(ntrmTypes, atomTypes);
+    else return false;
+    return true;
+}
+
+// ── Line helpers ─────────────────────────────────────────────────────────────
+
+struct TokenSpan {
+    size_t begin, size;
+};
+
+// Tokens before any "!" comment
+static void tokenSpans(const string& line, vector<TokenSpan>& spans) {
+    spans.clear();
+    size_t end = line.find('!');
+    if (end == string::npos) end = line.size();
+    size_t p = 0;
+    while (p < end) {
+        while (p < end && isspace((unsigned char)line[p])) p++;
+        size_t begin = p;
+        while (p < end && !isspace((unsigned char)line[p])) p++;
+        if (p > begin) {
+            TokenSpan span = {begin, p - begin};
+            spans.push_back(span);
+        }
+    }
+}
+
+static bool tokenIs(const string& line, const TokenSpan& span, const char* word) {
+    size_t n = 0;
+    for (; word[n]; ++n) {
+        if (n >= span.size || toupper((unsigned char)line[span.begin + n]) != word[n]) return false;
+    }
+    return n == span.size;
+}
+
+static string tokenText(const string& line, const TokenSpan& span) {
+    return line.substr(span.begin, span.size);
+}
+
+// The token replaced by text, padded to the token's width so the columns
+// after it stay aligned
+static void replaceToken(string& line, const TokenSpan& span, const string& text) {
+    string padded = text;
+    if (padded.size() < span.size) padded.append(span.size - padded.size(), ' ');
+    line.replace(span.begin, span.size, padded);
+}
+
+static bool containsNoCase(const string& line, const char* text) {
+    string lower(line);
+    for (size_t i = 0; i < lower.size(); ++i) lower[i] = (char)tolower((unsigned char)lower[i]);
+    return lower.find(text) != string::npos;
+}
+
+// Types in a parameter entry for a section header, 0 if the line is not one
+static int sectionArity(const string& line, const vector<TokenSpan>& spans) {
+    if (spans.size() != 1) return 0;
+    if (tokenIs(line, spans[0], "BONDS")) return 2;
+    if (tokenIs(line, spans[0], "ANGLES")) return 3;
+    if (tokenIs(line, spans[0], "DIHEDRALS") || tokenIs(line, spans[0], "IMPROPERS")) return 4;
+    return 0;
+}
+
+// ── Renaming ─────────────────────────────────────────────────────────────────
+
+static void buildTypeRenameMap(const StrModel& model, const map<string, string>& atomTypes, TypeRenameReport& report) {
+    TypeRenameMap& typeMap = report.map;
+    set<string> proteinSide, drugSide;
+    for (size_t r = 0; r < model.residues.size(); ++r) {
+        const vector<StrAtomRecord>& atoms = model.residues[r].atoms;
+        report.residueAtoms += (int)atoms.size();
+        for (size_t a = 0; a < atoms.size(); ++a) {
+            string type = atoms[a].type.str();
+            map<string, string>::const_iterator it = atomTypes.find(atoms[a].name.str());
+            if (it == atomTypes.end()) {
+                drugSide.insert(type);
+                continue;
+            }
+            typeMap.charmmTypes[type].insert(it->second);
+            typeMap.proteinTypes.insert(it->second);
+            proteinSide.insert(type);
+        }
+    }
+    for (set<string>::const_iterator it = proteinSide.begin(); it != proteinSide.end(); ++it) {
+        if (drugSide.count(*it)) typeMap.ambiguous.insert(*it);
+    }
+}
+
+// Every reading of a parameter line's types: protein-side CGenFF types
+// become their CHARMM36 types, ambiguous ones may also stay; first field
+// varying slowest
+static void typePermutations(const vector<string>& types, const TypeRenameMap& typeMap,
+                             vector<vector<string> >& permutations) {
+    vector<vector<string> > options(types.size());
+    for (size_t i = 0; i < types.size(); ++i) {
+        map<string, set<string> >::const_iterator it = typeMap.charmmTypes.find(types[i]);
+        if (it == typeMap.charmmTypes.end()) {
+            options[i].push_back(types[i]);
+            continue;
+        }
+        options[i].assign(it->second.begin(), it->second.end());
+        if (typeMap.ambiguous.count(types[i])) options[i].push_back(types[i]);
+    }
+
+    permutations.clear();
+    vector<size_t> choice(types.size(), 0);
+    while (true) {
+        vector<string> permutation(types.size());
+        for (size_t i = 0; i < types.size(); ++i) permutation[i] = options[i][choice[i]];
+        permutations.push_back(permutation);
+
+        size_t i = types.size();
+        while (i > 0 && ++choice[i - 1] == options[i - 1].size()) choice[--i] = 0;
+        if (i == 0) break;
+    }
+}
+
+string renameAtomTypes(const string& strText, const map<string, string>& atomTypes, TypeRenameReport& report) {
+    report = TypeRenameReport();
+    StrModel model;
+    parseCharmmStream(strText.data(), strText.size(), model);
+    buildTypeRenameMap(model, atomTypes, report);
+    const TypeRenameMap& typeMap = report.map;
+
+    string out;
+    out.reserve(strText.size() + strText.size() / 8);
+    bool inParams = false, inResidue = false;
+    int arity = 0;                  // current parameter section, 0 outside one
+    vector<TokenSpan> spans;
+    vector<vector<string> > permutations;
+
+    size_t pos = 0;
+    while (pos < strText.size()) {
+        size_t newline = strText.find('\n', pos);
+        size_t next = newline == string::npos ? strText.size() : newline + 1;
+        string line = strText.substr(pos, (newline == string::npos ? strText.size() : newline) - pos);
+        string ending = strText.substr(pos + line.size(), next - pos - line.size());
+        pos = next;
+
+        tokenSpans(line, spans);
+        if (containsNoCase(line, "read param")) inParams = true;
+        if (!spans.empty() && tokenIs(line, spans[0], "RESI")) inResidue = true;
+        bool endLine = spans.size() == 1 && (tokenIs(line, spans[0], "END") || tokenIs(line, spans[0], "RETURN"));
+        if (endLine) {
+            if (!inParams) inResidue = false;
+            arity = 0;
+        }
+
+        if (inResidue && !inParams && spans.size() >= 3 && tokenIs(line, spans[0], "ATOM")) {
+            map<string, string>::const_iterator it = atomTypes.find(tokenText(line, spans[1]));
+            if (it != atomTypes.end() && tokenText(line, spans[2]) != it->second) {
+                replaceToken(line, spans[2], it->second);
+                report.atomsRenamed++;
+            }
+        } else if (inResidue && !inParams && !spans.empty() && tokenIs(line, spans[0], "IMPR")) {
+            // Impropers on the cap atoms, which noX removes
+            bool cap = false;
+            for (size_t i = 1; i < spans.size() && !cap; ++i) {
+                string atom = tokenText(line, spans[i]);
+                cap = atom.find("HX") != string::npos || atom.find("CX") != string::npos ||
+                      atom.find("OX") != string::npos || atom.find("NX") != string::npos;
+            }
+            if (cap) {
+                report.impropersRemoved++;
+                continue;
+            }
+        } else if (sectionArity(line, spans) > 0) {
+            arity = sectionArity(line, spans);
+        } else if (inParams && arity > 0 && spans.size() >= (size_t)arity + 2) {
+            vector<string> types(arity);
+            for (int i = 0; i < arity; ++i) types[i] = tokenText(line, spans[i]);
+            typePermutations(types, typeMap, permutations);
+
+            // The first reading replaces the line; the others follow it
+            bool first = true;
+            for (size_t p = 0; p < permutations.size(); ++p) {
+                bool proteinOnly = true;
+                for (int i = 0; i < arity && proteinOnly; ++i) proteinOnly = typeMap.proteinTypes.count(permutations[p][i]) > 0;
+                if (proteinOnly) continue;
+
+                string renamed = line;
+                for (int i = arity - 1; i >= 0; --i) {
+                    if (permutations[p][i] != types[i]) replaceToken(renamed, spans[i], permutations[p][i]);
+                }
+                out += renamed;
+                out += ending.empty() ? "\n" : ending;
+                if (!first) report.permutationsAdded++;
+                first = false;
+            }
+            if (first) report.parametersRemoved++;
+            continue;
+        }
+        out += line;
+        out += ending;
+    }
+    return out;
+}
+
+bool renameAtomTypesInFile(const string& aminoAcid, const string& strFile, TypeRenameReport& report) {
+    map<string, string> atomTypes;
+    if (!proteinAtomTypes(aminoAcid, atomTypes)) {
+        LOG_ERROR("Unknown amino acid '" << aminoAcid << "' (lys, cys, tyr or ntrm)");
+        return false;
+    }
+    string strText;
+    if (!readTextFile(strFile, strText)) return false;
+    string renamed = renameAtomTypes(strText, atomTypes, report);
+    if (report.residueAtoms == 0) {
+        LOG_ERROR("No RESI atoms in " << strFile);
+        return false;
+    }
+    if (!writeTextFile(strFile, renamed)) return false;
+    LOG_INFO(strFile << ": " << report.atomsRenamed << " atom types renamed, " << report.parametersRemoved
+                     << " protein-only parameters removed, " << report.permutationsAdded << " permutations added");
+    return true;
+}
+
+void writeTypeRenameReport(const TypeRenameReport& report, ostream& out) {
+    out << "RESI atoms: " << report.residueAtoms << "\n";
+    out << "CGenFF -> CHARMM36 types:\n";
+    const map<string, set<string> >& types = report.map.charmmTypes;
+    for (map<string, set<string> >::const_iterator it = types.begin(); it != types.end(); ++it) {
+        out << "  " << it->first << " ->";
+        for (set<string>::const_iterator t = it->second.begin(); t != it->second.end(); ++t) out << " " << *t;
+        if (report.map.ambiguous.count(it->first)) out << "  (also on the drug side)";
+        out << "\n";
+    }
+    out << "Topology: " << report.atomsRenamed << " atom types renamed, " << report.impropersRemoved
+        << " cap impropers removed\n";
+    out << "Parameters: " << report.parametersRemoved << " protein-only lines removed, " << report.permutationsAdded
+        << " permutation lines added\n";
+}
@@ -0,0 +1,56 @@
+// AtomTypeRenamer.h
+#ifndef ATOMTYPERENAMER_H
+#define ATOMTYPERENAMER_H
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// CGenFF to CHARMM36 atom types for the protein side of a novel amino acid
+// stream file (nad.str, ntrm_clean.str), so the residue bonds into the
+// protein with CHARMM36 parameters:
+//
+//   topology    ATOM types renamed by atom name (N -> NH1, CA -> CT1, ...);
+//               IMPR records naming the HX/CX/OX/NX cap atoms removed
+//   parameters  protein-side types renamed in the type columns. A CGenFF
+//               type used on both sides (ambiguous) gets one line per
+//               reading; lines left with only protein types are removed
+//               as already in CHARMM36.
+//
+// The type map is built once from the parsed RESI atoms, then every line is
+// rewritten in one pass. Types are matched as whole tokens in their CHARMM
+// columns and replaced in place, padded to the old width.
+
+struct TypeRenameMap {
+    std::map<std::string, std::set<std::string> > charmmTypes;     // CGenFF type -> CHARMM36 types
+    std::set<std::string> ambiguous;        // CGenFF types on protein and drug atoms
+    std::set<std::string> proteinTypes;     // CHARMM36 types after renaming
+};
+
+struct TypeRenameReport {
+    int residueAtoms;
+    int atomsRenamed;
+    int impropersRemoved;
+    int parametersRemoved;      // protein-only after renaming
+    int permutationsAdded;      // extra lines for ambiguous types
+    TypeRenameMap map;
+
+    TypeRenameReport();
+};
+
+// Atom name -> CHARMM36 type for lys, cys, tyr or ntrm; false for others
+bool proteinAtomTypes(const std::string& aminoAcid, std::map<std::string, std::string>& atomTypes);
+
+// Rename the types of strText (a CGenFF stream file) in one pass
+std::string renameAtomTypes(const std::string& strText, const std::map<std::string, std::string>& atomTypes,
+                            TypeRenameReport& report);
+
+// Rename strFile in place for aminoAcid
+bool renameAtomTypesInFile(const std::string& aminoAcid, const std::string& strFile, TypeRenameReport& report);
+
+// The type map and counts, one item per line
+void writeTypeRenameReport(const TypeRenameReport& report, std::ostream& out);
+
+#endif // ATOMTYPERENAMER_H
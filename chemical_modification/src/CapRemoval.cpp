@@ -0,0 +1,221 @@
+// CapRemoval.cpp
+#include "CapRemoval.h"
+#include "Logger.h"
+#include "PdbReader.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+CapRemovalReport::CapRemovalReport()
+    : capAtoms(0), atomsRemoved(0), bondsRemoved(0), chargeMoved(false), movedCharge(0.0), newCharge(0.0) {
+}
+
+CapRemovalJob CapRemovalJob::defaults(ResidueKind kind, const string& aminoAcid) {
+    CapRemovalJob job;
+    if (kind == ResidueNtrm) {
+        job.aminoAcid = "ntrm";
+        job.pdbFile = "ntrm_fixed.pdb";
+        job.strFile = "ntrm.str";
+        job.outFile = "ntrm_clean.str";
+        job.chargeFrom = "HX";
+        job.chargeTo = "C";
+    } else {
+        job.aminoAcid = aminoAcid;
+        job.pdbFile = "naa.pdb";
+        job.strFile = "naa.str";
+        job.outFile = "nad.str";
+    }
+    return job;
+}
+
+// ── Line helpers ─────────────────────────────────────────────────────────────
+
+static bool startsWith(const string& line, const char* prefix) {
+    return line.compare(0, strlen(prefix), prefix) == 0;
+}
+
+struct Token {
+    size_t begin, size;
+};
+
+static vector<Token> tokens(const string& line) {
+    vector<Token> found;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && isspace((unsigned char)line[pos])) pos++;
+        size_t begin = pos;
+        while (pos < line.size() && !isspace((unsigned char)line[pos])) pos++;
+        if (pos > begin) {
+            Token token = {begin, pos - begin};
+            found.push_back(token);
+        }
+    }
+    return found;
+}
+
+static string tokenText(const string& line, const Token& token) {
+    return line.substr(token.begin, token.size);
+}
+
+// The line at pos, newline included, and pos moved past it; false at the end
+static bool nextLine(const string& text, size_t& pos, string& line) {
+    if (pos >= text.size()) return false;
+    size_t newline = text.find('\n', pos);
+    size_t next = newline == string::npos ? text.size() : newline + 1;
+    line.assign(text, pos, next - pos);
+    pos = next;
+    return true;
+}
+
+// ── Cap removal ──────────────────────────────────────────────────────────────
+
+bool capAtomPositions(const string& pdbFile, set<size_t>& positions) {
+    PdbAtoms atoms;
+    if (!readPdbFile(pdbFile, atoms)) return false;
+    positions.clear();
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        if (atoms.name(i).find('X') != string::npos) positions.insert(i + 1);
+    }
+    return true;
+}
+
+string removeCapAtoms(const string& strText, const set<size_t>& positions, CapRemovalReport& report) {
+    report.capAtoms = (int)positions.size();
+    string line;
+
+    // Names of the ATOM records at positions
+    size_t pos = 0, atom = 0;
+    while (nextLine(strText, pos, line)) {
+        if (!startsWith(line, "ATOM") || !positions.count(++atom)) continue;
+        vector<Token> fields = tokens(line);
+        if (fields.size() >= 2) report.removedNames.insert(tokenText(line, fields[1]));
+    }
+
+    string out;
+    out.reserve(strText.size());
+    pos = 0;
+    atom = 0;
+    while (nextLine(strText, pos, line)) {
+        if (startsWith(line, "RESI")) {
+            for (size_t at = line.find("naa.pdb"); at != string::npos; at = line.find("naa.pdb", at + 3)) {
+                line.replace(at, 7, "NAA");
+            }
+        }
+        if (startsWith(line, "ATOM") && positions.count(++atom)) {
+            report.atomsRemoved++;
+            continue;
+        }
+        if (startsWith(line, "BOND")) {
+            vector<Token> fields = tokens(line);
+            bool named = false;
+            for (size_t i = 1; i < fields.size() && !named; ++i) {
+                named = report.removedNames.count(tokenText(line, fields[i])) > 0;
+            }
+            if (named) {
+                report.bondsRemoved++;
+                continue;
+            }
+        }
+        out += line;
+    }
+    return out;
+}
+
+// ── Charge transfer ──────────────────────────────────────────────────────────
+
+// Start of the ATOM record for atom in text and its charge token; false if
+// there is none
+static bool findAtomCharge(const string& text, const string& atom, size_t& lineStart, Token& charge) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t newline = text.find('\n', pos);
+        size_t end = newline == string::npos ? text.size() : newline;
+        string line = text.substr(pos, end - pos);
+        if (startsWith(line, "ATOM")) {
+            vector<Token> fields = tokens(line);
+            if (fields.size() >= 4 && tokenText(line, fields[1]) == atom) {
+                lineStart = pos;
+                charge = fields[3];
+                return true;
+            }
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+bool moveAtomCharge(const string& sourceText, const string& fromAtom, string& strText, const string& toAtom,
+                    CapRemovalReport& report) {
+    size_t sourceLine, targetLine;
+    Token sourceCharge, targetCharge;
+    if (!findAtomCharge(sourceText, fromAtom, sourceLine, sourceCharge)) {
+        LOG_ERROR("Could not find atom " << fromAtom << " to move its charge");
+        return false;
+    }
+    if (!findAtomCharge(strText, toAtom, targetLine, targetCharge)) {
+        LOG_ERROR("Could not find atom " << toAtom << " to move the " << fromAtom << " charge to");
+        return false;
+    }
+    report.movedCharge = atof(sourceText.substr(sourceLine + sourceCharge.begin, sourceCharge.size).c_str());
+    double current = atof(strText.substr(targetLine + targetCharge.begin, targetCharge.size).c_str());
+    report.newCharge = current + report.movedCharge;
+
+    char formatted[32];
+    snprintf(formatted, sizeof(formatted), "%.3f", report.newCharge);
+    strText.replace(targetLine + targetCharge.begin, targetCharge.size, formatted);
+    report.chargeMoved = true;
+    return true;
+}
+
+// ── Whole chain ──────────────────────────────────────────────────────────────
+
+bool removeCaps(const CapRemovalJob& job, CapRemovalReport& report) {
+    report = CapRemovalReport();
+    map<string, string> atomTypes;
+    if (!proteinAtomTypes(job.aminoAcid, atomTypes)) {
+        LOG_ERROR("Unknown amino acid '" << job.aminoAcid << "' (lys, cys, tyr or ntrm)");
+        return false;
+    }
+
+    set<size_t> positions;
+    string strText;
+    if (!capAtomPositions(job.pdbFile, positions) || !readTextFile(job.strFile, strText)) return false;
+    if (positions.empty()) LOG_WARN("No cap atoms (names with X) in " << job.pdbFile);
+
+    string cleaned = removeCapAtoms(strText, positions, report);
+    if (!job.chargeFrom.empty() && !moveAtomCharge(strText, job.chargeFrom, cleaned, job.chargeTo, report)) {
+        return false;
+    }
+    string renamed = renameAtomTypes(cleaned, atomTypes, report.types);
+    if (report.types.residueAtoms == 0) {
+        LOG_ERROR("No RESI atoms in " << job.strFile);
+        return false;
+    }
+    if (!writeTextFile(job.outFile, renamed)) return false;
+
+    LOG_INFO(job.strFile << " -> " << job.outFile << ": " << report.atomsRemoved << " cap atoms and "
+                         << report.bondsRemoved << " bonds removed, " << report.types.atomsRenamed
+                         << " atom types renamed");
+    return true;
+}
+
+void writeCapRemovalReport(const CapRemovalReport& report, ostream& out) {
+    out << "Cap atoms in the PDB: " << report.capAtoms << "\n";
+    out << "Removed:";
+    for (set<string>::const_iterator it = report.removedNames.begin(); it != report.removedNames.end(); ++it) {
+        out << " " << *it;
+    }
+    out << "\n";
+    out << "Records removed: " << report.atomsRemoved << " ATOM, " << report.bondsRemoved << " BOND\n";
+    if (report.chargeMoved) {
+        char line[96];
+        snprintf(line, sizeof(line), "Charge moved: %.3f, new charge %.3f\n", report.movedCharge, report.newCharge);
+        out << line;
+    }
+    writeTypeRenameReport(report.types, out);
+}
@@ -0,0 +1,65 @@
+// CapRemoval.h
+#ifndef CAPREMOVAL_H
+#define CAPREMOVAL_H
+
+#include "AtomTypeRenamer.h"
+#include "ICTable.h"
+#include <ostream>
+#include <set>
+#include <string>
+
+// The capped residue's stream file turned into the one psfgen reads, as one
+// in-memory chain with a single write:
+//
+//   remove caps   the ATOM records at the positions of the PDB atoms whose
+//                 names contain X, and every BOND record naming them
+//                 ("naa.pdb" on the RESI line becomes "NAA")
+//   move charge   ntrm only: the charge HX had before removal is added to C
+//   rename types  protein-side CGenFF types to CHARMM36 (AtomTypeRenamer.h)
+//
+// naa: naa.pdb + naa.str -> nad.str; ntrm: ntrm_fixed.pdb + ntrm.str ->
+// ntrm_clean.str.
+
+struct CapRemovalJob {
+    std::string aminoAcid;      // lys, cys, tyr or ntrm, for the type renaming
+    std::string pdbFile;        // the capped residue
+    std::string strFile;        // its CGenFF stream file
+    std::string outFile;        // the cleaned stream file
+    std::string chargeFrom;     // cap atom whose charge moves, empty for none
+    std::string chargeTo;
+
+    // The file names the GUI workflow uses for kind (naa or ntrm)
+    static CapRemovalJob defaults(ResidueKind kind, const std::string& aminoAcid);
+};
+
+struct CapRemovalReport {
+    int capAtoms;                       // PDB atoms named with X
+    int atomsRemoved;
+    int bondsRemoved;
+    std::set<std::string> removedNames; // their names in the stream file
+    bool chargeMoved;
+    double movedCharge;
+    double newCharge;
+    TypeRenameReport types;
+
+    CapRemovalReport();
+};
+
+// 1-based positions of the PDB atoms whose names contain X
+bool capAtomPositions(const std::string& pdbFile, std::set<size_t>& positions);
+
+// strText without the ATOM records at positions and the BOND records naming them
+std::string removeCapAtoms(const std::string& strText, const std::set<size_t>& positions, CapRemovalReport& report);
+
+// Add the charge fromAtom has in sourceText to toAtom's charge in strText,
+// written with three decimals; false if either atom is missing
+bool moveAtomCharge(const std::string& sourceText, const std::string& fromAtom, std::string& strText,
+                    const std::string& toAtom, CapRemovalReport& report);
+
+// The whole chain for job; outFile is written once, at the end
+bool removeCaps(const CapRemovalJob& job, CapRemovalReport& report);
+
+// Counts, one item per line, then the type renaming report
+void writeCapRemovalReport(const CapRemovalReport& report, std::ostream& out);
+
+#endif // CAPREMOVAL_H
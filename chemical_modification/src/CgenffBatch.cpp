@@ -0,0 +1,254 @@
+// CgenffBatch.cpp
+#include "CgenffBatch.h"
+#include "ICTable.h"
+#include "Logger.h"
+#include "Subprocess.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace std;
+
+BatchSettings::BatchSettings() : cgenffPath("./cgenff"), outputDir("cgenff_batch"), jobs(0) {
+}
+
+static bool hasMol2Extension(const string& name) {
+    if (name.size() < 5) return false;
+    string ext = name.substr(name.size() - 5);
+    for (size_t i = 0; i < ext.size(); ++i) ext[i] = (char)tolower((unsigned char)ext[i]);
+    return ext == ".mol2";
+}
+
+bool collectMol2Files(const vector<string>& inputs, vector<string>& files) {
+    files.clear();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        struct stat info;
+        if (stat(inputs[i].c_str(), &info) != 0) {
+            LOG_ERROR("Cannot find " << inputs[i]);
+            return false;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            files.push_back(inputs[i]);
+            continue;
+        }
+
+        DIR* dir = opendir(inputs[i].c_str());
+        if (!dir) {
+            LOG_ERROR("Cannot open directory " << inputs[i]);
+            return false;
+        }
+        vector<string> found;
+        while (struct dirent* entry = readdir(dir)) {
+            if (hasMol2Extension(entry->d_name)) found.push_back(inputs[i] + "/" + entry->d_name);
+        }
+        closedir(dir);
+        sort(found.begin(), found.end());
+        if (found.empty()) LOG_WARN("No .mol2 files in " << inputs[i]);
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return true;
+}
+
+static bool makeDirectory(const string& path) {
+    if (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST) return true;
+    LOG_ERROR("Cannot create directory " << path << ": " << strerror(errno));
+    return false;
+}
+
+// File name without directory or extension
+static string baseName(const string& path) {
+    size_t slash = path.find_last_of("/\\");
+    string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+// Folder names, made unique when two inputs share a base name
+static vector<string> ligandNames(const vector<string>& files) {
+    vector<string> names;
+    map<string, int> seen;
+    for (size_t i = 0; i < files.size(); ++i) {
+        string name = baseName(files[i]);
+        int count = ++seen[name];
+        if (count > 1) {
+            ostringstream unique;
+            unique << name << "_" << count;
+            name = unique.str();
+        }
+        names.push_back(name);
+    }
+    return names;
+}
+
+static string base36(size_t n, size_t width) {
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    string text(width, '0');
+    for (size_t i = width; i-- > 0; n /= 36) text[i] = digits[n % 36];
+    return text;
+}
+
+// Unique RESI names of at most four characters for the folder names
+static vector<string> residueNames(const vector<string>& names) {
+    vector<string> resiNames;
+    set<string> taken;
+    size_t serial = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+        string letters;
+        for (size_t c = 0; c < names[i].size(); ++c) {
+            if (isalnum((unsigned char)names[i][c])) letters += (char)toupper((unsigned char)names[i][c]);
+        }
+        string resi = letters;
+        if (resi.size() > 4) {
+            // Leading letters and up to three trailing digits
+            size_t digits = letters.size() - (letters.find_last_not_of("0123456789") + 1);
+            digits = min(digits, (size_t)3);
+            resi = letters.substr(0, 4 - digits) + letters.substr(letters.size() - digits);
+        }
+        while (resi.empty() || taken.count(resi)) {
+            resi = serial < 36 * 36 * 36 ? "L" + base36(serial, 3) : base36(serial, 4);
+            serial++;
+        }
+        taken.insert(resi);
+        resiNames.push_back(resi);
+    }
+    return resiNames;
+}
+
+static void parameterizeLigand(BatchLigand& ligand, const BatchSettings& settings) {
+    string folder = settings.outputDir + "/" + ligand.name;
+
+    string mol2Text;
+    vector<ICAtom> atoms;
+    if (!readTextFile(ligand.mol2File, mol2Text) || !readMol2Atoms(mol2Text, atoms)) {
+        ligand.message = "no atoms read from the .mol2 file";
+        return;
+    }
+    ligand.atoms = (int)atoms.size();
+
+    vector<string> argv;
+    argv.push_back(settings.cgenffPath);
+    argv.push_back(ligand.mol2File);
+    ProcessResult run;
+    if (!runProcess(argv, run)) {
+        ligand.message = "could not start " + settings.cgenffPath;
+        return;
+    }
+    ligand.cgenffSeconds = run.seconds;
+
+    if (!makeDirectory(folder)) {
+        ligand.message = "cannot create " + folder;
+        return;
+    }
+    if (!run.errors.empty()) writeTextFile(folder + "/cgenff.log", run.errors);
+    if (run.exitCode != 0) {
+        ostringstream message;
+        message << "cgenff exited with code " << run.exitCode;
+        ligand.message = message.str();
+        return;
+    }
+
+    string strText;
+    strText.swap(run.output);
+    setCgenffResidueName(strText, ligand.resiName);
+    cgenffPenalties(strText, ligand.parameterPenalty, ligand.chargePenalty);
+
+    vector<string> residueLines = residueTopologyLines(strText);
+    if (residueLines.empty()) {
+        ligand.message = "no RESI block in the cgenff output";
+        writeTextFile(folder + "/" + ligand.name + ".str", strText);
+        return;
+    }
+
+    // The residue on its own: RESI block, IC table, END
+    string rtf = insertResidueTopology("", residueLines, atoms, ResidueFixed);
+    size_t pos = 0;
+    while ((pos = rtf.find("\nIC ", pos)) != string::npos) {
+        ligand.icEntries++;
+        pos++;
+    }
+
+    if (!writeTextFile(folder + "/" + ligand.name + ".str", strText) ||
+        !writeTextFile(folder + "/" + ligand.name + ".rtf", rtf)) {
+        ligand.message = "cannot write the output files";
+        return;
+    }
+    ligand.ok = true;
+}
+
+int runCgenffBatch(const vector<string>& mol2Files, const BatchSettings& settings, vector<BatchLigand>& results) {
+    vector<string> names = ligandNames(mol2Files);
+    vector<string> resiNames = residueNames(names);
+    results.assign(mol2Files.size(), BatchLigand());
+    for (size_t i = 0; i < mol2Files.size(); ++i) {
+        BatchLigand& ligand = results[i];
+        ligand.mol2File = mol2Files[i];
+        ligand.name = names[i];
+        ligand.resiName = resiNames[i];
+        ligand.ok = false;
+        ligand.cgenffSeconds = ligand.totalSeconds = 0.0;
+        ligand.parameterPenalty = ligand.chargePenalty = -1.0;
+        ligand.atoms = ligand.icEntries = 0;
+    }
+    if (mol2Files.empty()) return 0;
+    if (!makeDirectory(settings.outputDir)) {
+        for (size_t i = 0; i < results.size(); ++i) results[i].message = "no output directory";
+        return (int)results.size();
+    }
+
+    int jobs = settings.jobs > 0 ? settings.jobs : (int)thread::hardware_concurrency();
+    jobs = max(1, min(jobs, (int)mol2Files.size()));
+    LOG_INFO("Parameterizing " << mol2Files.size() << " ligands with " << jobs << " concurrent cgenff runs");
+
+    // Workers take the next ligand until none are left
+    atomic<size_t> next(0);
+    atomic<int> finished(0);
+    vector<thread> workers;
+    for (int w = 0; w < jobs; ++w) {
+        workers.push_back(thread([&]() {
+            for (size_t i = next++; i < results.size(); i = next++) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                parameterizeLigand(results[i], settings);
+                results[i].totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                int done = ++finished;
+                if (results[i].ok) {
+                    LOG_INFO("[" << done << "/" << results.size() << "] " << results[i].name << " done in "
+                             << results[i].totalSeconds << " s");
+                } else {
+                    LOG_WARN("[" << done << "/" << results.size() << "] " << results[i].name << " failed: "
+                             << results[i].message);
+                }
+            }
+        }));
+    }
+    for (size_t w = 0; w < workers.size(); ++w) workers[w].join();
+
+    int failures = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok) failures++;
+    }
+    return failures;
+}
+
+bool writeBatchSummary(const string& filename, const vector<BatchLigand>& results) {
+    ostringstream out;
+    out << "ligand\tresi\tstatus\tcgenff_s\ttotal_s\tparam_penalty\tcharge_penalty\tatoms\tic_entries\tmol2\tmessage\n";
+    char numbers[160];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BatchLigand& r = results[i];
+        snprintf(numbers, sizeof(numbers), "%.3f\t%.3f\t%.3f\t%.3f\t%d\t%d", r.cgenffSeconds, r.totalSeconds,
+                 r.parameterPenalty, r.chargePenalty, r.atoms, r.icEntries);
+        out << r.name << "\t" << r.resiName << "\t" << (r.ok ? "ok" : "failed") << "\t" << numbers << "\t" << r.mol2File << "\t"
+            << r.message << "\n";
+    }
+    return writeTextFile(filename, out.str());
+}
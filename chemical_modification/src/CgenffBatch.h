@@ -0,0 +1,54 @@
+// CgenffBatch.h
+#ifndef CGENFFBATCH_H
+#define CGENFFBATCH_H
+
+#include <string>
+#include <vector>
+
+// Batch CGenFF parameterization of many candidate payloads. Every .mol2 file
+// is run through the local cgenff executable by a bounded pool of workers,
+// and each ligand gets its own folder under the output directory:
+//
+//   <output>/<ligand>/<ligand>.str   cgenff stream file, RESI renamed
+//   <output>/<ligand>/<ligand>.rtf   RESI block with its IC table
+//   <output>/<ligand>/cgenff.log     cgenff stderr, when there is any
+//   <output>/summary.tsv             one row per ligand, in input order
+//
+// Each ligand's RESI name is unique within the batch and at most four
+// uppercase characters: the folder name when it fits, else its leading
+// letters and trailing digits (candidate_12 -> CA12), else L and a
+// base-36 serial number (L000, L001, ...). summary.tsv lists them.
+
+struct BatchSettings {
+    std::string cgenffPath;     // default ./cgenff
+    std::string outputDir;      // default cgenff_batch
+    int jobs;                   // concurrent cgenff processes, 0 = one per core
+
+    BatchSettings();
+};
+
+struct BatchLigand {
+    std::string mol2File;
+    std::string name;           // output folder name
+    std::string resiName;       // RESI name in its .str and .rtf
+    bool ok;
+    std::string message;        // failure reason
+    double cgenffSeconds;
+    double totalSeconds;
+    double parameterPenalty;    // from the RESI line, -1 if absent
+    double chargePenalty;
+    int atoms;
+    int icEntries;
+};
+
+// Expand directories (their *.mol2 files, sorted) and keep plain files
+bool collectMol2Files(const std::vector<std::string>& inputs, std::vector<std::string>& files);
+
+// Parameterize every file; results are in input order. Returns the number
+// of ligands that failed.
+int runCgenffBatch(const std::vector<std::string>& mol2Files, const BatchSettings& settings,
+                   std::vector<BatchLigand>& results);
+
+bool writeBatchSummary(const std::string& filename, const std::vector<BatchLigand>& results);
+
+#endif // CGENFFBATCH_H
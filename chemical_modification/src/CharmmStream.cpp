@@ -0,0 +1,467 @@
+// CharmmStream.cpp
+#include "CharmmStream.h"
+#include "Logger.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ── Tokens ───────────────────────────────────────────────────────────────────
+
+bool TokenRef::equals(const TokenRef& other) const {
+    return size == other.size && (size == 0 || memcmp(data, other.data, size) == 0);
+}
+
+bool TokenRef::equals(const char* text) const {
+    size_t n = strlen(text);
+    return size == n && memcmp(data, text, n) == 0;
+}
+
+bool TokenRef::equalsNoCase(const char* text) const {
+    size_t n = strlen(text);
+    if (size != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (toupper((unsigned char)data[i]) != toupper((unsigned char)text[i])) return false;
+    }
+    return true;
+}
+
+// CHARMM keyword match: the first four letters (or the whole keyword if it
+// is shorter), and the token may not be shorter than that
+static bool isKeyword(const TokenRef& token, const char* keyword) {
+    size_t n = strlen(keyword);
+    size_t prefix = n < 4 ? n : 4;
+    if (token.size < prefix) return false;
+    if (n < 4 && token.size != n) return false;
+    for (size_t i = 0; i < prefix; ++i) {
+        if (toupper((unsigned char)token.data[i]) != keyword[i]) return false;
+    }
+    return true;
+}
+
+static bool parseNumber(const TokenRef& token, double& value) {
+    char field[64];
+    if (token.size == 0 || token.size >= sizeof(field)) return false;
+    memcpy(field, token.data, token.size);
+    field[token.size] = '\0';
+    char* stop = NULL;
+    value = strtod(field, &stop);
+    return stop == field + token.size;
+}
+
+static bool isNumber(const TokenRef& token) {
+    double value;
+    return parseNumber(token, value);
+}
+
+// ── Model ────────────────────────────────────────────────────────────────────
+
+int StrResidue::findAtom(const TokenRef& atomName) const {
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        if (atoms[i].name.equals(atomName)) return (int)i;
+    }
+    return -1;
+}
+
+void StrModel::clear() {
+    masses.clear();
+    residues.clear();
+    bondParams.clear();
+    angleParams.clear();
+    dihedralParams.clear();
+    improperParams.clear();
+    sections.clear();
+    problems.clear();
+}
+
+const StrMassRecord* StrModel::findMass(const string& type) const {
+    for (size_t i = 0; i < masses.size(); ++i) {
+        if (masses[i].type.equals(type.c_str())) return &masses[i];
+    }
+    return NULL;
+}
+
+const StrResidue* StrModel::findResidue(const string& name) const {
+    for (size_t i = 0; i < residues.size(); ++i) {
+        if (residues[i].name.equals(name.c_str())) return &residues[i];
+    }
+    return NULL;
+}
+
+// ── Parser ───────────────────────────────────────────────────────────────────
+
+enum ParamBlock { BlockNone, BlockBonds, BlockAngles, BlockDihedrals, BlockImpropers, BlockOther };
+
+// Parameter block header, or BlockNone if the token is not one
+static ParamBlock paramHeader(const TokenRef& token) {
+    if (isKeyword(token, "BOND")) return BlockBonds;
+    if (isKeyword(token, "ANGL") || isKeyword(token, "THET")) return BlockAngles;
+    if (isKeyword(token, "DIHE") || isKeyword(token, "PHI")) return BlockDihedrals;
+    if (isKeyword(token, "IMPR") || isKeyword(token, "IMPH")) return BlockImpropers;
+    if (isKeyword(token, "CMAP") || isKeyword(token, "NONB") || isKeyword(token, "NBON") ||
+        isKeyword(token, "NBFI") || isKeyword(token, "HBON") || isKeyword(token, "ATOM")) {
+        return BlockOther;
+    }
+    return BlockNone;
+}
+
+// Headers that only occur in parameter files, used to recognize a PRM file
+// that has no "read param" line
+static bool isParamOnlyHeader(const TokenRef& token) {
+    return token.equalsNoCase("BONDS") || token.equalsNoCase("ANGLES") || token.equalsNoCase("THETAS") ||
+           token.equalsNoCase("DIHEDRALS") || token.equalsNoCase("IMPROPERS") || token.equalsNoCase("IMPROPER") ||
+           token.equalsNoCase("NONBONDED") || token.equalsNoCase("NBFIX");
+}
+
+static bool isTopologyKeyword(const TokenRef& token) {
+    return isKeyword(token, "RESI") || isKeyword(token, "PRES") || isKeyword(token, "MASS") ||
+           isKeyword(token, "DECL") || isKeyword(token, "DEFA") || isKeyword(token, "AUTO");
+}
+
+struct ParserState {
+    const char* data;
+    StrModel* model;
+    int mode;               // -1 outside a section, else StrSection::Kind
+    ParamBlock block;
+    int residue;            // open residue, -1 if none
+    size_t lineNumber;
+    bool ok;
+
+    void problem(const string& what) {
+        ostringstream message;
+        message << "line " << lineNumber << ": " << what;
+        model->problems.push_back(message.str());
+        ok = false;
+    }
+
+    void closeResidue(size_t offset) {
+        if (residue >= 0) {
+            StrResidue& r = model->residues[residue];
+            r.text.size = (size_t)(data + offset - r.text.data);
+            residue = -1;
+        }
+    }
+
+    void openSection(StrSection::Kind kind, size_t begin) {
+        StrSection section;
+        section.kind = kind;
+        section.begin = begin;
+        section.end = section.after = 0;
+        section.closed = false;
+        model->sections.push_back(section);
+        mode = kind;
+        block = BlockNone;
+    }
+
+    void closeSection(size_t end, size_t after) {
+        closeResidue(end);
+        if (mode >= 0) {
+            model->sections.back().end = end;
+            model->sections.back().after = after;
+            model->sections.back().closed = true;
+        }
+        mode = -1;
+        block = BlockNone;
+    }
+};
+
+static void topologyRecord(ParserState& state, const vector<TokenRef>& t, const TokenRef& comment,
+                           size_t lineStart, size_t lineEnd) {
+    StrModel& model = *state.model;
+    if (isKeyword(t[0], "MASS")) {
+        StrMassRecord mass;
+        double number;
+        if (t.size() < 4 || !parseNumber(t[1], number) || !parseNumber(t[3], mass.mass)) {
+            state.problem("MASS needs a number, a type and a mass");
+            return;
+        }
+        mass.number = (int)number;
+        mass.type = t[2];
+        if (t.size() > 4) mass.element = t[4];
+        size_t end = lineEnd;
+        if (end > lineStart && state.data[end - 1] == '\r') end--;
+        mass.text = TokenRef(state.data + lineStart, end - lineStart);
+        model.masses.push_back(mass);
+        return;
+    }
+    if (isKeyword(t[0], "RESI") || isKeyword(t[0], "PRES")) {
+        state.closeResidue(lineStart);
+        StrResidue residue;
+        residue.patch = isKeyword(t[0], "PRES");
+        residue.charge = 0.0;
+        if (t.size() < 2) {
+            state.problem("residue without a name");
+            return;
+        }
+        residue.name = t[1];
+        if (t.size() > 2 && !parseNumber(t[2], residue.charge)) state.problem("bad residue charge");
+        residue.comment = comment;
+        residue.text = TokenRef(state.data + lineStart, 0);
+        model.residues.push_back(residue);
+        state.residue = (int)model.residues.size() - 1;
+        return;
+    }
+    if (state.residue < 0) return;   // DECL, DEFA, AUTO and the version line
+    StrResidue& r = model.residues[state.residue];
+
+    if (isKeyword(t[0], "ATOM")) {
+        StrAtomRecord atom;
+        if (t.size() < 4 || !parseNumber(t[3], atom.charge)) {
+            state.problem("ATOM needs a name, a type and a charge");
+            return;
+        }
+        atom.name = t[1];
+        atom.type = t[2];
+        r.atoms.push_back(atom);
+    } else if (isKeyword(t[0], "BOND") || isKeyword(t[0], "DOUB") || isKeyword(t[0], "TRIP") ||
+               isKeyword(t[0], "AROM")) {
+        int order = isKeyword(t[0], "BOND") ? 1 : isKeyword(t[0], "DOUB") ? 2 : isKeyword(t[0], "TRIP") ? 3 : 4;
+        if (t.size() % 2 != 1) state.problem("bond record with an odd number of atoms");
+        for (size_t k = 1; k + 1 < t.size(); k += 2) {
+            StrBondRecord bond;
+            bond.atoms[0] = t[k];
+            bond.atoms[1] = t[k + 1];
+            bond.order = order;
+            r.bonds.push_back(bond);
+        }
+    } else if (isKeyword(t[0], "IMPR") || isKeyword(t[0], "IMPH")) {
+        if ((t.size() - 1) % 4 != 0) state.problem("improper record with a partial quadruple");
+        for (size_t k = 1; k + 3 < t.size(); k += 4) {
+            StrImproperRecord improper;
+            for (int a = 0; a < 4; ++a) improper.atoms[a] = t[k + a];
+            r.impropers.push_back(improper);
+        }
+    } else if (isKeyword(t[0], "CMAP")) {
+        if (t.size() != 9) {
+            state.problem("CMAP needs eight atoms");
+            return;
+        }
+        StrCmapRecord cmap;
+        for (int a = 0; a < 8; ++a) cmap.atoms[a] = t[1 + a];
+        r.cmaps.push_back(cmap);
+    } else if (isKeyword(t[0], "IC") || isKeyword(t[0], "BILD")) {
+        StrICRecord ic;
+        bool good = t.size() == 10;
+        for (int a = 0; good && a < 4; ++a) ic.atoms[a] = t[1 + a];
+        for (int v = 0; good && v < 5; ++v) good = parseNumber(t[5 + v], ic.values[v]);
+        if (!good) {
+            state.problem("IC needs four atoms and five values");
+            return;
+        }
+        ic.improper = ic.atoms[2].size > 1 && ic.atoms[2].data[0] == '*';
+        if (ic.improper) {
+            ic.atoms[2].data++;
+            ic.atoms[2].size--;
+        }
+        r.ics.push_back(ic);
+    }
+}
+
+static void parameterRecord(ParserState& state, const vector<TokenRef>& t) {
+    StrModel& model = *state.model;
+    ParamBlock header = paramHeader(t[0]);
+    if (header != BlockNone && (t.size() == 1 || !isNumber(t[1]))) {
+        state.block = header;
+        return;
+    }
+
+    switch (state.block) {
+        case BlockBonds: {
+            StrBondParam p;
+            if (t.size() < 4 || !parseNumber(t[2], p.kb) || !parseNumber(t[3], p.b0)) {
+                state.problem("bond parameter needs two types, Kb and b0");
+                return;
+            }
+            p.types[0] = t[0];
+            p.types[1] = t[1];
+            p.line = state.lineNumber;
+            model.bondParams.push_back(p);
+            break;
+        }
+        case BlockAngles: {
+            StrAngleParam p;
+            p.kub = p.s0 = 0.0;
+            if (t.size() < 5 || !parseNumber(t[3], p.ktheta) || !parseNumber(t[4], p.theta0) ||
+                (t.size() >= 7 && (!parseNumber(t[5], p.kub) || !parseNumber(t[6], p.s0)))) {
+                state.problem("angle parameter needs three types, Ktheta and theta0");
+                return;
+            }
+            for (int k = 0; k < 3; ++k) p.types[k] = t[k];
+            p.line = state.lineNumber;
+            model.angleParams.push_back(p);
+            break;
+        }
+        case BlockDihedrals: {
+            StrDihedralParam p;
+            double n;
+            if (t.size() < 7 || !parseNumber(t[4], p.kchi) || !parseNumber(t[5], n) || !parseNumber(t[6], p.delta)) {
+                state.problem("dihedral parameter needs four types, Kchi, n and delta");
+                return;
+            }
+            for (int k = 0; k < 4; ++k) p.types[k] = t[k];
+            p.multiplicity = (int)n;
+            p.line = state.lineNumber;
+            model.dihedralParams.push_back(p);
+            break;
+        }
+        case BlockImpropers: {
+            StrImproperParam p;
+            if (t.size() < 7 || !parseNumber(t[4], p.kpsi) || !parseNumber(t[6], p.psi0)) {
+                state.problem("improper parameter needs four types, Kpsi, 0 and psi0");
+                return;
+            }
+            for (int k = 0; k < 4; ++k) p.types[k] = t[k];
+            p.line = state.lineNumber;
+            model.improperParams.push_back(p);
+            break;
+        }
+        default:
+            break;   // CMAP grids, nonbonded, NBFIX, HBOND, MASS
+    }
+}
+
+bool parseCharmmStream(const char* data, size_t size, StrModel& model) {
+    model.clear();
+    ParserState state;
+    state.data = data;
+    state.model = &model;
+    state.mode = -1;
+    state.block = BlockNone;
+    state.residue = -1;
+    state.lineNumber = 0;
+    state.ok = true;
+
+    vector<TokenRef> tokens;
+    size_t lineStart = 0;
+    while (lineStart < size) {
+        const char* newline = (const char*)memchr(data + lineStart, '\n', size - lineStart);
+        size_t lineEnd = newline ? (size_t)(newline - data) : size;
+        size_t next = newline ? lineEnd + 1 : size;
+        state.lineNumber++;
+
+        // Content before the comment, and the comment itself
+        const char* bang = (const char*)memchr(data + lineStart, '!', lineEnd - lineStart);
+        size_t contentEnd = bang ? (size_t)(bang - data) : lineEnd;
+        TokenRef comment;
+        if (bang) {
+            size_t c = contentEnd + 1;
+            size_t e = lineEnd;
+            while (e > c && isspace((unsigned char)data[e - 1])) e--;
+            comment = TokenRef(data + c, e - c);
+        }
+
+        tokens.clear();
+        size_t p = lineStart;
+        while (p < contentEnd) {
+            while (p < contentEnd && isspace((unsigned char)data[p])) p++;
+            size_t begin = p;
+            while (p < contentEnd && !isspace((unsigned char)data[p])) p++;
+            if (p > begin) tokens.push_back(TokenRef(data + begin, p - begin));
+        }
+
+        if (!tokens.empty() && tokens[0].data[0] != '*') {
+            const TokenRef& t0 = tokens[0];
+            if (t0.equalsNoCase("END")) {
+                state.closeSection(lineStart, next);
+            } else if (isKeyword(t0, "READ")) {
+                state.closeSection(lineStart, lineStart);
+                if (tokens.size() > 1 && isKeyword(tokens[1], "RTF")) state.openSection(StrSection::Topology, next);
+                else if (tokens.size() > 1 && isKeyword(tokens[1], "PARA")) state.openSection(StrSection::Parameters, next);
+            } else if (state.mode != StrSection::Parameters && tokens.size() == 1 && isParamOnlyHeader(t0)) {
+                // A parameter file without "read param"
+                state.closeResidue(lineStart);
+                if (state.mode == StrSection::Topology) model.sections.back().kind = StrSection::Parameters;
+                else state.openSection(StrSection::Parameters, lineStart);
+                state.mode = StrSection::Parameters;
+                parameterRecord(state, tokens);
+            } else if (state.mode == StrSection::Parameters) {
+                parameterRecord(state, tokens);
+            } else {
+                // A topology file without "read rtf"
+                if (state.mode < 0 && isTopologyKeyword(t0)) state.openSection(StrSection::Topology, lineStart);
+                if (state.mode == StrSection::Topology) topologyRecord(state, tokens, comment, lineStart, lineEnd);
+            }
+        }
+        lineStart = next;
+    }
+
+    state.closeResidue(size);
+    if (state.mode >= 0) {
+        model.sections.back().end = model.sections.back().after = size;
+    }
+    return state.ok;
+}
+
+// ── CharmmStream ─────────────────────────────────────────────────────────────
+
+CharmmStream::CharmmStream() : mapped(NULL), bytes(NULL), length(0) {
+}
+
+CharmmStream::~CharmmStream() {
+    release();
+}
+
+void CharmmStream::release() {
+    if (mapped) munmap(mapped, length);
+    mapped = NULL;
+    bytes = NULL;
+    length = 0;
+    owned.clear();
+    parsed.clear();
+}
+
+bool CharmmStream::open(const string& filename) {
+    if (!map(filename)) return false;
+    parseCharmmStream(bytes, length, parsed);
+    for (size_t i = 0; i < parsed.problems.size(); ++i) {
+        LOG_WARN(filename << " " << parsed.problems[i]);
+    }
+    return true;
+}
+
+bool CharmmStream::map(const string& filename) {
+    release();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Could not open " << filename);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        LOG_ERROR("Could not stat " << filename);
+        close(fd);
+        return false;
+    }
+    length = (size_t)info.st_size;
+    if (length > 0) {
+        void* region = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (region == MAP_FAILED) {
+            LOG_ERROR("Could not map " << filename);
+            close(fd);
+            length = 0;
+            return false;
+        }
+        mapped = region;
+        bytes = (const char*)region;
+    }
+    close(fd);
+    return true;
+}
+
+bool CharmmStream::parse(const string& text) {
+    release();
+    owned = text;
+    bytes = owned.data();
+    length = owned.size();
+    parseCharmmStream(bytes, length, parsed);
+    for (size_t i = 0; i < parsed.problems.size(); ++i) {
+        LOG_WARN(parsed.problems[i]);
+    }
+    return true;
+}
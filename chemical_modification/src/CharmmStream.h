@@ -0,0 +1,179 @@
+// CharmmStream.h
+#ifndef CHARMMSTREAM_H
+#define CHARMMSTREAM_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Single-pass tokenizer for CHARMM stream (STR), topology (RTF) and
+// parameter (PRM) files. One pass fills an in-memory model:
+//
+//   topology    MASS, and RESI/PRES with ATOM, BOND/DOUB/TRIP/AROM, IMPR/IMPH,
+//               CMAP and IC records
+//   parameters  BONDS, ANGLES, DIHEDRALS and IMPROPERS entries
+//
+// Keywords are matched as whole tokens on their first four letters, case
+// insensitive, after the "!" comment is removed, so a name or comment that
+// merely contains "RESI" or "END" is not mistaken for a record.
+//
+// Tokens are TokenRefs into the parsed buffer, which for CharmmStream::open
+// is the mmapped file itself; nothing is copied. The model is only valid
+// while its CharmmStream (or buffer) is alive.
+
+// ── Tokens ───────────────────────────────────────────────────────────────────
+
+struct TokenRef {
+    const char* data;
+    size_t size;
+
+    TokenRef() : data(NULL), size(0) {}
+    TokenRef(const char* d, size_t n) : data(d), size(n) {}
+
+    bool empty() const { return size == 0; }
+    std::string str() const { return std::string(data, size); }
+    bool equals(const TokenRef& other) const;
+    bool equals(const char* text) const;
+    bool equalsNoCase(const char* text) const;
+};
+
+// ── Topology records ─────────────────────────────────────────────────────────
+
+struct StrMassRecord {
+    TokenRef type;
+    int number;             // -1 in current files: numbered on read
+    double mass;
+    TokenRef element;       // empty in old-style files
+    TokenRef text;          // the whole line, without its newline
+};
+
+struct StrAtomRecord {
+    TokenRef name, type;
+    double charge;
+};
+
+struct StrBondRecord {
+    TokenRef atoms[2];
+    int order;              // 1 BOND, 2 DOUB, 3 TRIP, 4 AROM
+};
+
+struct StrImproperRecord {
+    TokenRef atoms[4];
+};
+
+struct StrCmapRecord {
+    TokenRef atoms[8];
+};
+
+struct StrICRecord {
+    TokenRef atoms[4];      // third name without its "*"
+    bool improper;
+    double values[5];       // R(1,2 or 1,3), theta, phi, theta, R(3,4)
+};
+
+struct StrResidue {
+    TokenRef name;
+    double charge;
+    bool patch;             // PRES
+    TokenRef comment;       // after "!" on the RESI line (CGenFF penalties)
+    TokenRef text;          // the RESI line up to the next RESI/PRES/END line
+    std::vector<StrAtomRecord> atoms;
+    std::vector<StrBondRecord> bonds;
+    std::vector<StrImproperRecord> impropers;
+    std::vector<StrCmapRecord> cmaps;
+    std::vector<StrICRecord> ics;
+
+    // Index of the atom called name, -1 if there is none
+    int findAtom(const TokenRef& name) const;
+};
+
+// ── Parameter records ────────────────────────────────────────────────────────
+
+struct StrBondParam {
+    TokenRef types[2];
+    double kb, b0;
+    size_t line;
+};
+
+struct StrAngleParam {
+    TokenRef types[3];
+    double ktheta, theta0;
+    double kub, s0;         // Urey-Bradley, 0 when absent
+    size_t line;
+};
+
+struct StrDihedralParam {
+    TokenRef types[4];
+    double kchi;
+    int multiplicity;
+    double delta;
+    size_t line;
+};
+
+struct StrImproperParam {
+    TokenRef types[4];
+    double kpsi, psi0;
+    size_t line;
+};
+
+// ── Model ────────────────────────────────────────────────────────────────────
+
+struct StrSection {
+    enum Kind { Topology, Parameters };
+
+    Kind kind;
+    size_t begin;           // first byte of the section's first line
+    size_t end;             // first byte of its END line (buffer size if none)
+    size_t after;           // first byte after the END line
+    bool closed;            // an END line was found
+};
+
+struct StrModel {
+    std::vector<StrMassRecord> masses;
+    std::vector<StrResidue> residues;
+    std::vector<StrBondParam> bondParams;
+    std::vector<StrAngleParam> angleParams;
+    std::vector<StrDihedralParam> dihedralParams;
+    std::vector<StrImproperParam> improperParams;
+    std::vector<StrSection> sections;
+    std::vector<std::string> problems;      // malformed records, with line numbers
+
+    void clear();
+    const StrMassRecord* findMass(const std::string& type) const;
+    const StrResidue* findResidue(const std::string& name) const;
+};
+
+// Parse [data, data + size) into model; false if any record was malformed
+bool parseCharmmStream(const char* data, size_t size, StrModel& model);
+
+// A parsed file, mmapped read-only, or a private copy of an in-memory text.
+// open() fails only if the file cannot be mapped; malformed records are
+// logged as warnings and kept in model().problems.
+class CharmmStream {
+public:
+    CharmmStream();
+    ~CharmmStream();
+
+    bool open(const std::string& filename);
+    bool parse(const std::string& text);
+    // Map the file without parsing it; model() stays empty
+    bool map(const std::string& filename);
+
+    const StrModel& model() const { return parsed; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    CharmmStream(const CharmmStream&);
+    CharmmStream& operator=(const CharmmStream&);
+    void release();
+
+    void* mapped;
+    const char* bytes;
+    size_t length;
+    std::string owned;
+    StrModel parsed;
+};
+
+#endif // CHARMMSTREAM_H
@@ -0,0 +1,145 @@
+// GeometryCache.cpp
+#include "GeometryCache.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+static void crossProduct(const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static double dotProduct(const double a[3], const double b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+int neighborSlot(const BondGraph& graph, int atom, int neighbor) {
+    const vector<int>& nb = graph.neighbors[atom];
+    vector<int>::const_iterator it = lower_bound(nb.begin(), nb.end(), neighbor);
+    return (it != nb.end() && *it == neighbor) ? (int)(it - nb.begin()) : -1;
+}
+
+double dihedralFromVectors(const double b1[3], const double b2[3], const double b3[3]) {
+    double n1[3], n2[3];
+    crossProduct(b1, b2, n1);
+    crossProduct(b2, b3, n2);
+    double x = dotProduct(n1, n2);
+    double y = sqrt(dotProduct(b2, b2)) * dotProduct(b1, n2);
+    return atan2(y, x) * 180.0 / M_PI;
+}
+
+void GeometryCache::build(const vector<ICAtom>& atoms, const BondGraph& graph) {
+    size_t numAtoms = atoms.size();
+    offset.assign(numAtoms + 1, 0);
+    angleOffset.assign(numAtoms + 1, 0);
+    for (size_t i = 0; i < numAtoms; ++i) {
+        size_t degree = graph.neighbors[i].size();
+        offset[i + 1] = offset[i] + degree;
+        angleOffset[i + 1] = angleOffset[i] + degree * degree;
+    }
+    length.resize(offset[numAtoms]);
+    unit.resize(3 * offset[numAtoms]);
+    angle.resize(angleOffset[numAtoms]);
+
+    // Each bond is measured once and stored in both directions
+    for (size_t i = 0; i < numAtoms; ++i) {
+        const vector<int>& nb = graph.neighbors[i];
+        for (size_t s = 0; s < nb.size(); ++s) {
+            int j = nb[s];
+            if (j < (int)i) continue;
+            double d[3];
+            for (int k = 0; k < 3; ++k) d[k] = atoms[j].coords[k] - atoms[i].coords[k];
+            double r = sqrt(dotProduct(d, d));
+            size_t forward = offset[i] + s;
+            size_t backward = offset[j] + neighborSlot(graph, j, (int)i);
+            length[forward] = r;
+            length[backward] = r;
+            for (int k = 0; k < 3; ++k) {
+                unit[3 * forward + k] = d[k] / r;
+                unit[3 * backward + k] = -d[k] / r;
+            }
+        }
+    }
+
+    // Angles between every pair of bonds at each atom; atan2(|u x v|, u . v)
+    // stays accurate near 0 and 180 degrees
+    for (size_t i = 0; i < numAtoms; ++i) {
+        size_t degree = graph.neighbors[i].size();
+        double* table = degree ? &angle[angleOffset[i]] : NULL;
+        for (size_t s = 0; s < degree; ++s) {
+            table[s * degree + s] = 0.0;
+            const double* u = bondUnit((int)i, (int)s);
+            for (size_t t = s + 1; t < degree; ++t) {
+                const double* v = bondUnit((int)i, (int)t);
+                double c[3];
+                crossProduct(u, v, c);
+                double theta = atan2(sqrt(dotProduct(c, c)), dotProduct(u, v)) * 180.0 / M_PI;
+                table[s * degree + t] = theta;
+                table[t * degree + s] = theta;
+            }
+        }
+    }
+}
+
+void neighborPairs(const vector<ICAtom>& atoms, double cutoff, vector<pair<int, int> >& pairs,
+                   vector<double>& distance) {
+    pairs.clear();
+    distance.clear();
+    if (atoms.empty()) return;
+
+    double low[3], high[3];
+    for (int k = 0; k < 3; ++k) low[k] = high[k] = atoms[0].coords[k];
+    for (size_t i = 1; i < atoms.size(); ++i) {
+        for (int k = 0; k < 3; ++k) {
+            low[k] = min(low[k], atoms[i].coords[k]);
+            high[k] = max(high[k], atoms[i].coords[k]);
+        }
+    }
+
+    // Cells of edge >= cutoff, so partners lie in the 27 surrounding cells
+    int dims[3];
+    for (int k = 0; k < 3; ++k) dims[k] = max(1, min(1024, (int)((high[k] - low[k]) / cutoff) + 1));
+    size_t numCells = (size_t)dims[0] * dims[1] * dims[2];
+
+    vector<int> cellOf(atoms.size());
+    vector<size_t> cellStart(numCells + 1, 0);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        int c[3];
+        for (int k = 0; k < 3; ++k) c[k] = min(dims[k] - 1, (int)((atoms[i].coords[k] - low[k]) / cutoff));
+        cellOf[i] = (c[2] * dims[1] + c[1]) * dims[0] + c[0];
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 0; c < numCells; ++c) cellStart[c + 1] += cellStart[c];
+    vector<int> cellAtoms(atoms.size());
+    vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < atoms.size(); ++i) cellAtoms[fill[cellOf[i]]++] = (int)i;
+
+    double cutoff2 = cutoff * cutoff;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        int cx = cellOf[i] % dims[0];
+        int cy = (cellOf[i] / dims[0]) % dims[1];
+        int cz = cellOf[i] / (dims[0] * dims[1]);
+        for (int z = max(0, cz - 1); z <= min(dims[2] - 1, cz + 1); ++z) {
+            for (int y = max(0, cy - 1); y <= min(dims[1] - 1, cy + 1); ++y) {
+                for (int x = max(0, cx - 1); x <= min(dims[0] - 1, cx + 1); ++x) {
+                    int cell = (z * dims[1] + y) * dims[0] + x;
+                    for (size_t n = cellStart[cell]; n < cellStart[cell + 1]; ++n) {
+                        int j = cellAtoms[n];
+                        if (j <= (int)i) continue;
+                        double d2 = 0.0;
+                        for (int k = 0; k < 3; ++k) {
+                            double d = atoms[j].coords[k] - atoms[i].coords[k];
+                            d2 += d * d;
+                        }
+                        if (d2 < cutoff2) {
+                            pairs.push_back(make_pair((int)i, j));
+                            distance.push_back(sqrt(d2));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
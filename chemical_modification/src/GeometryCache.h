@@ -0,0 +1,47 @@
+// GeometryCache.h
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include <utility>
+#include <vector>
+#include "InternalCoordinates.h"
+
+// Per-molecule geometry shared by the IC writer. Bond lengths and unit bond
+// vectors are computed once per bond, and every bond angle once per pair of
+// neighbours at its centre, so each IC entry only costs its dihedral (see
+// batchDihedrals in GeometryKernels.h). Angles come from the cached unit
+// vectors with atan2.
+//
+// Slots follow graph.neighbors: slot s of atom i is the bond i -> neighbors[i][s].
+
+struct GeometryCache {
+    std::vector<size_t> offset;         // first slot of atom i in the flat tables
+    std::vector<double> length;         // |neighbor - atom|
+    std::vector<double> unit;           // (neighbor - atom) / length, xyz per slot
+    std::vector<size_t> angleOffset;    // first angle of atom i
+    std::vector<double> angle;          // deg x deg angles (degrees) at atom i
+
+    void build(const std::vector<ICAtom>& atoms, const BondGraph& graph);
+
+    double bondLength(int atom, int slot) const { return length[offset[atom] + slot]; }
+    const double* bondUnit(int atom, int slot) const { return &unit[3 * (offset[atom] + slot)]; }
+    // Angle neighbor(slot1) - atom - neighbor(slot2)
+    double bondAngle(int atom, int slot1, int slot2) const {
+        size_t degree = offset[atom + 1] - offset[atom];
+        return angle[angleOffset[atom] + slot1 * degree + slot2];
+    }
+};
+
+// Slot of neighbour in atom's adjacency list, -1 if they are not bonded
+int neighborSlot(const BondGraph& graph, int atom, int neighbor);
+
+// Dihedral (degrees, IUPAC sign) of the chain with bond vectors b1, b2, b3;
+// the vectors need not be unit length
+double dihedralFromVectors(const double b1[3], const double b2[3], const double b3[3]);
+
+// Pairs of atoms closer than cutoff, found with a uniform cell grid.
+// pairs holds i < j index pairs, distance the matching lengths.
+void neighborPairs(const std::vector<ICAtom>& atoms, double cutoff,
+                   std::vector<std::pair<int, int> >& pairs, std::vector<double>& distance);
+
+#endif // GEOMETRYCACHE_H
@@ -0,0 +1,248 @@
+// GeometryKernels.cpp
+#include "GeometryKernels.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Tuples per gathered block; small enough for the scratch arrays to stay in L1
+static const size_t blockSize = 64;
+
+static const double degreesPerRadian = 180.0 / M_PI;
+
+void CoordinateArrays::assign(const vector<ICAtom>& atoms) {
+    x.resize(atoms.size());
+    y.resize(atoms.size());
+    z.resize(atoms.size());
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        x[i] = atoms[i].coords[0];
+        y[i] = atoms[i].coords[1];
+        z[i] = atoms[i].coords[2];
+    }
+}
+
+// ── Batch kernels ────────────────────────────────────────────────────────────
+
+void batchDistances(const double* x, const double* y, const double* z, const int* pairs, size_t count,
+                    double* distances) {
+    double dx[blockSize], dy[blockSize], dz[blockSize];
+    for (size_t start = 0; start < count; start += blockSize) {
+        size_t n = min(blockSize, count - start);
+        const int* t = pairs + 2 * start;
+        for (size_t k = 0; k < n; ++k) {
+            int a = t[2 * k], b = t[2 * k + 1];
+            dx[k] = x[b] - x[a];
+            dy[k] = y[b] - y[a];
+            dz[k] = z[b] - z[a];
+        }
+        double* out = distances + start;
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = sqrt(dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k]);
+        }
+    }
+}
+
+void batchAngles(const double* x, const double* y, const double* z, const int* triples, size_t count,
+                 double* degrees) {
+    double ux[blockSize], uy[blockSize], uz[blockSize];
+    double vx[blockSize], vy[blockSize], vz[blockSize];
+    double sinPart[blockSize], cosPart[blockSize];
+    for (size_t start = 0; start < count; start += blockSize) {
+        size_t n = min(blockSize, count - start);
+        const int* t = triples + 3 * start;
+
+        // Gather: u = a - b, v = c - b
+        for (size_t k = 0; k < n; ++k) {
+            int a = t[3 * k], b = t[3 * k + 1], c = t[3 * k + 2];
+            ux[k] = x[a] - x[b];
+            uy[k] = y[a] - y[b];
+            uz[k] = z[a] - z[b];
+            vx[k] = x[c] - x[b];
+            vy[k] = y[c] - y[b];
+            vz[k] = z[c] - z[b];
+        }
+        for (size_t k = 0; k < n; ++k) {
+            double cx = uy[k] * vz[k] - uz[k] * vy[k];
+            double cy = uz[k] * vx[k] - ux[k] * vz[k];
+            double cz = ux[k] * vy[k] - uy[k] * vx[k];
+            sinPart[k] = sqrt(cx * cx + cy * cy + cz * cz);
+            cosPart[k] = ux[k] * vx[k] + uy[k] * vy[k] + uz[k] * vz[k];
+        }
+        double* out = degrees + start;
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = atan2(sinPart[k], cosPart[k]) * degreesPerRadian;
+        }
+    }
+}
+
+void batchDihedrals(const double* x, const double* y, const double* z, const int* quads, size_t count,
+                    double* degrees) {
+    double b1x[blockSize], b1y[blockSize], b1z[blockSize];
+    double b2x[blockSize], b2y[blockSize], b2z[blockSize];
+    double b3x[blockSize], b3y[blockSize], b3z[blockSize];
+    double sinPart[blockSize], cosPart[blockSize];
+    for (size_t start = 0; start < count; start += blockSize) {
+        size_t n = min(blockSize, count - start);
+        const int* t = quads + 4 * start;
+
+        // Gather the three bond vectors a->b, b->c, c->d
+        for (size_t k = 0; k < n; ++k) {
+            int a = t[4 * k], b = t[4 * k + 1], c = t[4 * k + 2], d = t[4 * k + 3];
+            b1x[k] = x[b] - x[a];
+            b1y[k] = y[b] - y[a];
+            b1z[k] = z[b] - z[a];
+            b2x[k] = x[c] - x[b];
+            b2y[k] = y[c] - y[b];
+            b2z[k] = z[c] - z[b];
+            b3x[k] = x[d] - x[c];
+            b3y[k] = y[d] - y[c];
+            b3z[k] = z[d] - z[c];
+        }
+        // n1 = b1 x b2, n2 = b2 x b3; x = n1 . n2, y = |b2| b1 . n2
+        for (size_t k = 0; k < n; ++k) {
+            double n1x = b1y[k] * b2z[k] - b1z[k] * b2y[k];
+            double n1y = b1z[k] * b2x[k] - b1x[k] * b2z[k];
+            double n1z = b1x[k] * b2y[k] - b1y[k] * b2x[k];
+            double n2x = b2y[k] * b3z[k] - b2z[k] * b3y[k];
+            double n2y = b2z[k] * b3x[k] - b2x[k] * b3z[k];
+            double n2z = b2x[k] * b3y[k] - b2y[k] * b3x[k];
+            double b2Length = sqrt(b2x[k] * b2x[k] + b2y[k] * b2y[k] + b2z[k] * b2z[k]);
+            cosPart[k] = n1x * n2x + n1y * n2y + n1z * n2z;
+            sinPart[k] = b2Length * (b1x[k] * n2x + b1y[k] * n2y + b1z[k] * n2z);
+        }
+        double* out = degrees + start;
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = atan2(sinPart[k], cosPart[k]) * degreesPerRadian;
+        }
+    }
+}
+
+// ── Scalar references ────────────────────────────────────────────────────────
+
+static ICAtom atomAt(const double* x, const double* y, const double* z, int i) {
+    ICAtom atom;
+    atom.coords[0] = x[i];
+    atom.coords[1] = y[i];
+    atom.coords[2] = z[i];
+    return atom;
+}
+
+void distancesReference(const double* x, const double* y, const double* z, const int* pairs, size_t count,
+                        double* distances) {
+    for (size_t k = 0; k < count; ++k) {
+        const int* t = pairs + 2 * k;
+        distances[k] = icDistance(atomAt(x, y, z, t[0]), atomAt(x, y, z, t[1]));
+    }
+}
+
+void anglesReference(const double* x, const double* y, const double* z, const int* triples, size_t count,
+                     double* degrees) {
+    for (size_t k = 0; k < count; ++k) {
+        const int* t = triples + 3 * k;
+        degrees[k] = icAngle(atomAt(x, y, z, t[0]), atomAt(x, y, z, t[1]), atomAt(x, y, z, t[2]));
+    }
+}
+
+void dihedralsReference(const double* x, const double* y, const double* z, const int* quads, size_t count,
+                        double* degrees) {
+    for (size_t k = 0; k < count; ++k) {
+        const int* t = quads + 4 * k;
+        degrees[k] = icDihedral(atomAt(x, y, z, t[0]), atomAt(x, y, z, t[1]), atomAt(x, y, z, t[2]),
+                                atomAt(x, y, z, t[3]));
+    }
+}
+
+// ── Self-check ───────────────────────────────────────────────────────────────
+
+// Deterministic uniform numbers in [-1, 1)
+static double nextUniform(unsigned long long& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(state >> 11) / (double)(1ULL << 52) - 1.0;
+}
+
+// Largest difference, dihedrals compared on the circle
+static double largestDifference(const vector<double>& a, const vector<double>& b, bool periodic) {
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        double d = fabs(a[i] - b[i]);
+        if (periodic) d = min(d, 360.0 - d);
+        worst = max(worst, d);
+    }
+    return worst;
+}
+
+bool checkGeometryKernels(double tolerance) {
+    const int numAtoms = 512;
+    const size_t numTuples = 20000;
+    unsigned long long state = 12345;
+
+    CoordinateArrays coords;
+    coords.x.resize(numAtoms);
+    coords.y.resize(numAtoms);
+    coords.z.resize(numAtoms);
+    for (int i = 0; i < numAtoms; ++i) {
+        coords.x[i] = 10.0 * nextUniform(state);
+        coords.y[i] = 10.0 * nextUniform(state);
+        coords.z[i] = 10.0 * nextUniform(state);
+    }
+    // Near-degenerate geometry: atoms 0-3 almost collinear, 4-7 almost planar
+    const double nearLine[4][3] = {{0, 0, 0}, {1.5, 1e-7, 0}, {3.0, 0, 1e-7}, {4.5, 2e-7, 0}};
+    const double nearPlane[4][3] = {{0, 1, 0}, {0, 0, 0}, {1.5, 0, 0}, {1.5, -1, 1e-8}};
+    for (int i = 0; i < 4; ++i) {
+        coords.x[i] = nearLine[i][0];
+        coords.y[i] = nearLine[i][1];
+        coords.z[i] = nearLine[i][2];
+        coords.x[4 + i] = nearPlane[i][0];
+        coords.y[4 + i] = nearPlane[i][1];
+        coords.z[4 + i] = nearPlane[i][2];
+    }
+
+    // Random tuples of distinct atoms, led by the degenerate ones
+    vector<int> quads(4 * numTuples);
+    for (int k = 0; k < 4; ++k) {
+        quads[k] = k;
+        quads[4 + k] = 4 + k;
+    }
+    for (size_t t = 2; t < numTuples; ++t) {
+        int* q = &quads[4 * t];
+        for (int k = 0; k < 4; ++k) {
+            bool repeated = true;
+            while (repeated) {
+                q[k] = (int)((nextUniform(state) + 1.0) * 0.5 * numAtoms) % numAtoms;
+                repeated = false;
+                for (int m = 0; m < k; ++m) repeated = repeated || q[m] == q[k];
+            }
+        }
+    }
+    // Pairs and triples are the leading atoms of the same tuples
+    vector<int> pairs(2 * numTuples), triples(3 * numTuples);
+    for (size_t t = 0; t < numTuples; ++t) {
+        for (int k = 0; k < 2; ++k) pairs[2 * t + k] = quads[4 * t + k];
+        for (int k = 0; k < 3; ++k) triples[3 * t + k] = quads[4 * t + k];
+    }
+
+    const double* x = &coords.x[0];
+    const double* y = &coords.y[0];
+    const double* z = &coords.z[0];
+    vector<double> batch(numTuples), reference(numTuples);
+
+    batchDistances(x, y, z, &pairs[0], numTuples, &batch[0]);
+    distancesReference(x, y, z, &pairs[0], numTuples, &reference[0]);
+    double distanceError = largestDifference(batch, reference, false);
+
+    batchAngles(x, y, z, &triples[0], numTuples, &batch[0]);
+    anglesReference(x, y, z, &triples[0], numTuples, &reference[0]);
+    double angleError = largestDifference(batch, reference, false);
+
+    batchDihedrals(x, y, z, &quads[0], numTuples, &batch[0]);
+    dihedralsReference(x, y, z, &quads[0], numTuples, &reference[0]);
+    double dihedralError = largestDifference(batch, reference, true);
+
+    LOG_INFO("Geometry kernels on " << numTuples << " tuples, largest difference from the scalar reference: "
+             << "distance " << distanceError << " A, angle " << angleError << " deg, dihedral "
+             << dihedralError << " deg");
+    bool ok = distanceError <= tolerance && angleError <= tolerance && dihedralError <= tolerance;
+    if (!ok) LOG_ERROR("Geometry kernels differ from the scalar reference by more than " << tolerance);
+    return ok;
+}
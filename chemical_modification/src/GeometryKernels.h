@@ -0,0 +1,48 @@
+// GeometryKernels.h
+#ifndef GEOMETRYKERNELS_H
+#define GEOMETRYKERNELS_H
+
+#include <cstddef>
+#include <vector>
+#include "InternalCoordinates.h"
+
+// Batch distances, angles and dihedrals over index tuples into structure-of-
+// arrays coordinates (x[i], y[i], z[i]; PdbAtoms stores them this way).
+// Tuples are flat: pairs[2n], triples[3n], quads[4n]. Results are in
+// Angstroms and degrees, one per tuple.
+//
+// The kernels gather a block of tuples into local arrays, then run the
+// arithmetic as straight-line loops the compiler can vectorize: no branches,
+// no acos, one cross product per angle and two per dihedral. Angles are
+// atan2(|u x v|, u . v); dihedrals use the IUPAC sign of icDihedral.
+//
+// The *Reference functions are the one-tuple-at-a-time versions the batch
+// results are checked against.
+
+struct CoordinateArrays {
+    std::vector<double> x, y, z;
+
+    void assign(const std::vector<ICAtom>& atoms);
+    size_t size() const { return x.size(); }
+};
+
+void batchDistances(const double* x, const double* y, const double* z, const int* pairs, size_t count,
+                    double* distances);
+void batchAngles(const double* x, const double* y, const double* z, const int* triples, size_t count,
+                 double* degrees);
+void batchDihedrals(const double* x, const double* y, const double* z, const int* quads, size_t count,
+                    double* degrees);
+
+void distancesReference(const double* x, const double* y, const double* z, const int* pairs, size_t count,
+                        double* distances);
+void anglesReference(const double* x, const double* y, const double* z, const int* triples, size_t count,
+                     double* degrees);
+void dihedralsReference(const double* x, const double* y, const double* z, const int* quads, size_t count,
+                        double* degrees);
+
+// Compare the batch kernels, the references and icDistance/icAngle/
+// icDihedral on random and near-degenerate geometry. Prints the largest
+// differences; false if any exceeds tolerance (degrees or Angstroms).
+bool checkGeometryKernels(double tolerance = 1e-9);
+
+#endif // GEOMETRYKERNELS_H
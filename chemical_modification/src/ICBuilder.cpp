@@ -0,0 +1,272 @@
+// ICBuilder.cpp
+#include "ICBuilder.h"
+#include "CharmmStream.h"
+#include "Logger.h"
+#include <cmath>
+#include <map>
+
+using namespace std;
+
+static const double radiansPerDegree = M_PI / 180.0;
+
+// ── NeRF placement ───────────────────────────────────────────────────────────
+
+// Atom d bonded to c at distance bond, with angle b-c-d and dihedral a-b-c-d
+// (degrees). False if a, b and c are (nearly) collinear.
+static bool placeAtom(const double a[3], const double b[3], const double c[3], double bond, double angle,
+                      double torsion, double d[3]) {
+    double bc[3], ab[3];
+    for (int k = 0; k < 3; ++k) {
+        bc[k] = c[k] - b[k];
+        ab[k] = b[k] - a[k];
+    }
+    double bcLength = sqrt(bc[0] * bc[0] + bc[1] * bc[1] + bc[2] * bc[2]);
+    if (bcLength < 1e-8) return false;
+    for (int k = 0; k < 3; ++k) bc[k] /= bcLength;
+
+    double n[3] = {ab[1] * bc[2] - ab[2] * bc[1], ab[2] * bc[0] - ab[0] * bc[2], ab[0] * bc[1] - ab[1] * bc[0]};
+    double nLength = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (nLength < 1e-8) return false;
+    for (int k = 0; k < 3; ++k) n[k] /= nLength;
+    double m[3] = {n[1] * bc[2] - n[2] * bc[1], n[2] * bc[0] - n[0] * bc[2], n[0] * bc[1] - n[1] * bc[0]};
+
+    double theta = angle * radiansPerDegree;
+    double phi = torsion * radiansPerDegree;
+    double local[3] = {-bond * cos(theta), bond * sin(theta) * cos(phi), bond * sin(theta) * sin(phi)};
+    for (int k = 0; k < 3; ++k) d[k] = c[k] + local[0] * bc[k] + local[1] * m[k] + local[2] * n[k];
+    return true;
+}
+
+// ── Rebuild ──────────────────────────────────────────────────────────────────
+
+static pair<int, int> bondKey(int a, int b) {
+    return a < b ? make_pair(a, b) : make_pair(b, a);
+}
+
+// Bond length from any entry that has it, 0 if none does
+static double tableBond(const map<pair<int, int>, double>& bonds, int a, int b) {
+    map<pair<int, int>, double>::const_iterator it = bonds.find(bondKey(a, b));
+    return it == bonds.end() ? 0.0 : it->second;
+}
+
+// Place the angle a-b-c in the xy plane: b at the origin, c on +x
+static void seedAngle(ICRebuild& rebuild, int a, int b, int c, double ab, double bc, double angle) {
+    double theta = angle * radiansPerDegree;
+    double* pa = rebuild.atoms[a].coords;
+    double* pb = rebuild.atoms[b].coords;
+    double* pc = rebuild.atoms[c].coords;
+    pb[0] = pb[1] = pb[2] = 0.0;
+    pc[0] = bc;
+    pc[1] = pc[2] = 0.0;
+    pa[0] = ab * cos(theta);
+    pa[1] = ab * sin(theta);
+    pa[2] = 0.0;
+    rebuild.placed[a] = rebuild.placed[b] = rebuild.placed[c] = true;
+}
+
+bool rebuildFromIC(const vector<string>& names, const vector<ICEntry>& entries, ICRebuild& rebuild) {
+    size_t n = names.size();
+    rebuild.atoms.assign(n, ICAtom());
+    rebuild.placed.assign(n, false);
+    rebuild.unplaced.clear();
+    rebuild.rmsd = -1.0;
+    rebuild.compared = 0;
+    for (size_t i = 0; i < n; ++i) {
+        rebuild.atoms[i].name = names[i];
+        rebuild.atoms[i].coords[0] = rebuild.atoms[i].coords[1] = rebuild.atoms[i].coords[2] = 0.0;
+    }
+
+    // Every bond length the table states; an improper's first bond is I-K
+    map<pair<int, int>, double> bonds;
+    for (size_t e = 0; e < entries.size(); ++e) {
+        const ICEntry& entry = entries[e];
+        if (entry.bond1 > 0.0) bonds[bondKey(entry.atoms[0], entry.atoms[entry.improper ? 2 : 1])] = entry.bond1;
+        if (entry.bond2 > 0.0) bonds[bondKey(entry.atoms[2], entry.atoms[3])] = entry.bond2;
+    }
+
+    // Seed with the first angle whose two bonds are known
+    bool seeded = false;
+    for (size_t e = 0; e < entries.size() && !seeded; ++e) {
+        const ICEntry& entry = entries[e];
+        int i = entry.atoms[0], j = entry.atoms[1], k = entry.atoms[2], l = entry.atoms[3];
+        double jk = tableBond(bonds, j, k);
+        if (jk <= 0.0) continue;
+        if (entry.angle1 > 0.0 && entry.bond1 > 0.0) {
+            // Proper: angle I-J-K; improper: angle I-K-J
+            if (entry.improper) seedAngle(rebuild, i, k, j, entry.bond1, jk, entry.angle1);
+            else seedAngle(rebuild, i, j, k, entry.bond1, jk, entry.angle1);
+            seeded = true;
+        } else if (entry.angle2 > 0.0 && entry.bond2 > 0.0) {
+            seedAngle(rebuild, l, k, j, entry.bond2, jk, entry.angle2);
+            seeded = true;
+        }
+    }
+
+    // Place atoms until no entry adds one
+    bool progress = seeded;
+    while (progress) {
+        progress = false;
+        for (size_t e = 0; e < entries.size(); ++e) {
+            const ICEntry& entry = entries[e];
+            int i = entry.atoms[0], j = entry.atoms[1], k = entry.atoms[2], l = entry.atoms[3];
+            const vector<bool>& known = rebuild.placed;
+            vector<ICAtom>& at = rebuild.atoms;
+            if (known[i] && known[j] && known[k] && !known[l]) {
+                if (entry.bond2 > 0.0 && entry.angle2 > 0.0 &&
+                    placeAtom(at[i].coords, at[j].coords, at[k].coords, entry.bond2, entry.angle2, entry.dihedral,
+                              at[l].coords)) {
+                    rebuild.placed[l] = progress = true;
+                }
+            } else if (!known[i] && known[j] && known[k] && known[l]) {
+                if (entry.bond1 <= 0.0 || entry.angle1 <= 0.0) continue;
+                bool ok = entry.improper
+                    // Bonded to K with angle J-K-I; dihedral L-J-K-I is -phi
+                    ? placeAtom(at[l].coords, at[j].coords, at[k].coords, entry.bond1, entry.angle1, -entry.dihedral,
+                                at[i].coords)
+                    : placeAtom(at[l].coords, at[k].coords, at[j].coords, entry.bond1, entry.angle1, entry.dihedral,
+                                at[i].coords);
+                if (ok) rebuild.placed[i] = progress = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!rebuild.placed[i]) rebuild.unplaced.push_back(names[i]);
+    }
+    LOG_DEBUG("IC rebuild placed " << n - rebuild.unplaced.size() << " of " << n << " atoms from "
+              << entries.size() << " entries");
+    return rebuild.complete();
+}
+
+bool rebuildFromIC(const StrResidue& residue, ICRebuild& rebuild) {
+    vector<string> names;
+    for (size_t a = 0; a < residue.atoms.size(); ++a) names.push_back(residue.atoms[a].name.str());
+
+    // IC records between atoms of this residue
+    vector<ICEntry> entries;
+    for (size_t r = 0; r < residue.ics.size(); ++r) {
+        const StrICRecord& ic = residue.ics[r];
+        ICEntry entry;
+        bool inside = true;
+        for (int k = 0; k < 4 && inside; ++k) {
+            entry.atoms[k] = residue.findAtom(ic.atoms[k]);
+            inside = entry.atoms[k] >= 0;
+        }
+        if (!inside) continue;
+        entry.improper = ic.improper;
+        entry.bond1 = ic.values[0];
+        entry.angle1 = ic.values[1];
+        entry.dihedral = ic.values[2];
+        entry.angle2 = ic.values[3];
+        entry.bond2 = ic.values[4];
+        entries.push_back(entry);
+    }
+    return rebuildFromIC(names, entries, rebuild);
+}
+
+// ── Superposition ────────────────────────────────────────────────────────────
+
+// Cyclic Jacobi diagonalisation of a symmetric 4x4 matrix; the eigenvalues
+// are left on the diagonal of a
+static void jacobiEigenvalues4(double a[4][4]) {
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        double off = 0.0;
+        for (int p = 0; p < 3; ++p)
+            for (int q = p + 1; q < 4; ++q)
+                off += a[p][q] * a[p][q];
+        if (off < 1e-30) break;
+
+        for (int p = 0; p < 3; ++p) {
+            for (int q = p + 1; q < 4; ++q) {
+                if (fabs(a[p][q]) < 1e-300) continue;
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+                for (int k = 0; k < 4; ++k) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 4; ++k) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+            }
+        }
+    }
+}
+
+double superposedRmsd(const vector<ICAtom>& a, const vector<ICAtom>& b) {
+    size_t n = a.size();
+    if (n == 0 || n != b.size()) return -1.0;
+
+    double centroidA[3] = {0.0, 0.0, 0.0}, centroidB[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < n; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            centroidA[k] += a[i].coords[k];
+            centroidB[k] += b[i].coords[k];
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        centroidA[k] /= n;
+        centroidB[k] /= n;
+    }
+
+    // Cross-covariance of the centred coordinates
+    double S[3][3] = {{0.0}};
+    double sumSq = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double u[3], v[3];
+        for (int k = 0; k < 3; ++k) {
+            u[k] = a[i].coords[k] - centroidA[k];
+            v[k] = b[i].coords[k] - centroidB[k];
+            sumSq += u[k] * u[k] + v[k] * v[k];
+        }
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                S[r][c] += u[r] * v[c];
+    }
+
+    // Horn's matrix; its largest eigenvalue gives the best proper rotation
+    double N[4][4] = {
+        {S[0][0] + S[1][1] + S[2][2], S[1][2] - S[2][1], S[2][0] - S[0][2], S[0][1] - S[1][0]},
+        {S[1][2] - S[2][1], S[0][0] - S[1][1] - S[2][2], S[0][1] + S[1][0], S[2][0] + S[0][2]},
+        {S[2][0] - S[0][2], S[0][1] + S[1][0], -S[0][0] + S[1][1] - S[2][2], S[1][2] + S[2][1]},
+        {S[0][1] - S[1][0], S[2][0] + S[0][2], S[1][2] + S[2][1], -S[0][0] - S[1][1] + S[2][2]}
+    };
+    jacobiEigenvalues4(N);
+    double largest = N[0][0];
+    for (int i = 1; i < 4; ++i) largest = max(largest, N[i][i]);
+
+    double msd = (sumSq - 2.0 * largest) / n;
+    return msd > 0.0 ? sqrt(msd) : 0.0;
+}
+
+bool compareToReference(ICRebuild& rebuild, const vector<ICAtom>& reference) {
+    map<string, int> index;
+    for (size_t i = 0; i < reference.size(); ++i) index[reference[i].name] = (int)i;
+
+    vector<ICAtom> built, expected;
+    for (size_t i = 0; i < rebuild.atoms.size(); ++i) {
+        if (!rebuild.placed[i]) continue;
+        map<string, int>::const_iterator it = index.find(rebuild.atoms[i].name);
+        if (it == index.end()) continue;
+        built.push_back(rebuild.atoms[i]);
+        expected.push_back(reference[it->second]);
+    }
+    rebuild.compared = (int)built.size();
+    rebuild.rmsd = -1.0;
+    if (built.size() < 3) return false;
+    rebuild.rmsd = superposedRmsd(built, expected);
+    return true;
+}
+
+bool validateICTable(const vector<ICAtom>& atoms, const vector<ICEntry>& entries, ICRebuild& rebuild) {
+    vector<string> names(atoms.size());
+    for (size_t i = 0; i < atoms.size(); ++i) names[i] = atoms[i].name;
+    bool complete = rebuildFromIC(names, entries, rebuild);
+    compareToReference(rebuild, atoms);
+    return complete;
+}
@@ -0,0 +1,55 @@
+// ICBuilder.h
+#ifndef ICBUILDER_H
+#define ICBUILDER_H
+
+#include <string>
+#include <vector>
+#include "InternalCoordinates.h"
+
+struct StrResidue;
+
+// Cartesian rebuild of a residue from its IC table (NeRF: natural extension
+// reference frame), the in-process equivalent of psfgen's guesscoord. Used
+// to check that a generated IC table is complete and consistent without
+// launching VMD.
+//
+// Three atoms are seeded from the first angle whose two bond lengths are
+// in the table; the rest are placed one IC entry at a time whenever three
+// of its four atoms are known:
+//
+//   proper   I J K L     L from I,J,K   or   I from L,K,J
+//   improper I J *K L    L from I,J,K   or   I from L,J,K (bonded to K)
+//
+// Entries naming atoms outside the residue (+N, -C) and bond lengths or
+// angles of 0 (values CHARMM fills from the parameters) are not used.
+
+struct ICRebuild {
+    std::vector<ICAtom> atoms;          // residue order; coords valid where placed
+    std::vector<bool> placed;
+    std::vector<std::string> unplaced;  // names of atoms no entry could place
+    double rmsd;                        // to the reference after superposition, -1 if not compared
+    int compared;                       // atoms in the RMSD
+
+    bool complete() const { return unplaced.empty(); }
+};
+
+// Rebuild from entries whose atom indices refer to names. True if every
+// atom was placed.
+bool rebuildFromIC(const std::vector<std::string>& names, const std::vector<ICEntry>& entries, ICRebuild& rebuild);
+// Rebuild a parsed RESI block from its IC records
+bool rebuildFromIC(const StrResidue& residue, ICRebuild& rebuild);
+
+// RMSD of the placed atoms to the reference atoms with the same names after
+// optimal rotation (Horn's quaternion method). False if fewer than three
+// atoms are in common.
+bool compareToReference(ICRebuild& rebuild, const std::vector<ICAtom>& reference);
+
+// Minimum RMSD between two paired atom lists (same size) over rotations and
+// translations; -1 for empty or mismatched lists
+double superposedRmsd(const std::vector<ICAtom>& a, const std::vector<ICAtom>& b);
+
+// Rebuild atoms from entries and compare the result with atoms themselves:
+// the IC generator's output checked against its own input
+bool validateICTable(const std::vector<ICAtom>& atoms, const std::vector<ICEntry>& entries, ICRebuild& rebuild);
+
+#endif // ICBUILDER_H
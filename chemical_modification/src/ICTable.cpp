@@ -0,0 +1,357 @@
+// ICTable.cpp
+#include "ICTable.h"
+#include "CharmmStream.h"
+#include "ICBuilder.h"
+#include "Logger.h"
+#include "PdbReader.h"
+#include "Subprocess.h"
+#include "TopologyOverlay.h"
+#include "TopologyStore.h"
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+// Backbone IC lines of a residue bonded into a peptide chain
+static const char* const peptideICLines[] = {
+    "IC -C   CA   *N   HN    1.3482 123.5700  180.0000 115.1100  0.9988",
+    "IC -C   N    CA   C     1.3482 123.5700  180.0000 107.2900  1.5187",
+    "IC N    CA   C    +N    1.4504 107.2900  180.0000 117.2700  1.3478",
+    "IC +N   CA   *C   O     1.3478 117.2700  180.0000 120.7900  1.2277",
+    "IC CA   C    +N   +CA   1.5187 117.2700  180.0000 124.9100  1.4487",
+};
+
+static bool isPeptideResidue(ResidueKind kind) {
+    return kind == ResidueNaa || kind == ResidueNtrm;
+}
+
+bool parseResidueKind(const string& name, ResidueKind& kind) {
+    if (name == "naa") kind = ResidueNaa;
+    else if (name == "ntrm") kind = ResidueNtrm;
+    else if (name == "fixed") kind = ResidueFixed;
+    else if (name == "cgenff") kind = ResidueCgenff;
+    else return false;
+    return true;
+}
+
+const char* residueKindName(ResidueKind kind) {
+    switch (kind) {
+        case ResidueNaa: return "naa";
+        case ResidueNtrm: return "ntrm";
+        case ResidueFixed: return "fixed";
+        case ResidueCgenff: return "cgenff";
+    }
+    return "unknown";
+}
+
+ICTableJob ICTableJob::defaults(ResidueKind kind) {
+    ICTableJob job;
+    job.kind = kind;
+    job.topologyFile = "top_all36_cgenff_CBD.rtf";
+    job.baseTopologyFile = "top_all36_cgenff_CBD_template.rtf";
+    switch (kind) {
+        case ResidueNaa:
+            job.strFile = "nad.str";
+            job.pdbFile = "nad.pdb";
+            break;
+        case ResidueNtrm:
+            job.strFile = "ntrm_clean.str";
+            job.pdbFile = "ntrm_clean.pdb";
+            break;
+        case ResidueFixed:
+            job.strFile = "one.str";
+            job.pdbFile = "one.pdb";
+            break;
+        case ResidueCgenff:
+            job.mol2File = "one.mol2";
+            job.strFile = "one.str";
+            job.pdbFile = "one.pdb";
+            job.topologyFile = "top_all27_prot_na_CBD2.inp";
+            job.baseTopologyFile.clear();
+            break;
+    }
+    return job;
+}
+
+// Lines of text, without their newlines
+static void appendLines(const char* begin, const char* end, vector<string>& lines) {
+    while (begin < end) {
+        const char* newline = begin;
+        while (newline < end && *newline != '\n') newline++;
+        lines.push_back(string(begin, newline));
+        begin = newline + 1;
+    }
+}
+
+vector<string> residueTopologyLines(const string& strText) {
+    vector<string> lines;
+    StrModel model;
+    parseCharmmStream(strText.data(), strText.size(), model);
+    if (model.residues.empty()) return lines;
+
+    // Every residue of the section holding the first one
+    const char* begin = model.residues[0].text.data;
+    const char* end = begin;
+    for (size_t r = 0; r < model.residues.size(); ++r) {
+        const TokenRef& text = model.residues[r].text;
+        if (text.data != end && r > 0) break;
+        end = text.data + text.size;
+    }
+    appendLines(begin, end, lines);
+    return lines;
+}
+
+// Trimmed names and coordinates of a parsed PDB
+static void toICAtoms(const PdbAtoms& pdb, vector<ICAtom>& atoms) {
+    atoms.resize(pdb.size());
+    for (size_t i = 0; i < pdb.size(); ++i) {
+        atoms[i].name = pdb.name(i);
+        atoms[i].coords[0] = pdb.x[i];
+        atoms[i].coords[1] = pdb.y[i];
+        atoms[i].coords[2] = pdb.z[i];
+    }
+}
+
+bool readResidueAtoms(const string& pdbText, vector<ICAtom>& atoms) {
+    PdbAtoms pdb;
+    if (!readPdbAtoms(pdbText, pdb)) return false;
+    toICAtoms(pdb, atoms);
+    return !atoms.empty();
+}
+
+string insertResidueTopology(const char* topologyData, size_t topologySize, const vector<string>& residueLines,
+                             const vector<ICAtom>& atoms, ResidueKind kind) {
+    // The residue replaces the END line of the first topology section
+    StrModel model;
+    parseCharmmStream(topologyData, topologySize, model);
+    size_t end = topologySize, after = topologySize;
+    for (size_t i = 0; i < model.sections.size(); ++i) {
+        if (model.sections[i].kind == StrSection::Topology && model.sections[i].closed) {
+            end = model.sections[i].end;
+            after = model.sections[i].after;
+            break;
+        }
+    }
+
+    ostringstream out;
+    out.write(topologyData, end);
+    if (end > 0 && topologyData[end - 1] != '\n') out << "\n";
+
+    for (size_t i = 0; i < residueLines.size(); ++i) {
+        out << residueLines[i] << "\n";
+    }
+    if (isPeptideResidue(kind)) out << "BOND C    +N\n";
+
+    // Bonds from the residue's BOND records, or from the geometry if it has none
+    BondGraph graph;
+    if (!bondGraphFromTopology(residueLines, atoms, graph)) {
+        LOG_INFO("No BOND records for the residue, perceiving bonds from distances");
+        bondGraphFromDistances(atoms, graph);
+    }
+    vector<ICEntry> entries;
+    buildInternalCoordinates(atoms, graph, entries);
+    writeICEntries(atoms, entries, out);
+
+    // Rebuilding the residue from the table catches gaps before psfgen does
+    ICRebuild rebuild;
+    if (!validateICTable(atoms, entries, rebuild)) {
+        ostringstream names;
+        for (size_t i = 0; i < rebuild.unplaced.size(); ++i) names << " " << rebuild.unplaced[i];
+        LOG_WARN("The IC table cannot place" << names.str());
+    }
+    if (rebuild.rmsd >= 0.0) LOG_INFO("IC table rebuilds the PDB coordinates to " << rebuild.rmsd << " A RMSD");
+
+    if (isPeptideResidue(kind)) {
+        for (size_t i = 0; i < sizeof(peptideICLines) / sizeof(peptideICLines[0]); ++i) {
+            out << peptideICLines[i] << "\n";
+        }
+    }
+    out << "END\n";
+
+    // Everything after the replaced END line
+    out.write(topologyData + after, topologySize - after);
+    if (after < topologySize && topologyData[topologySize - 1] != '\n') out << "\n";
+    return out.str();
+}
+
+string insertResidueTopology(const string& topologyText, const vector<string>& residueLines,
+                             const vector<ICAtom>& atoms, ResidueKind kind) {
+    return insertResidueTopology(topologyText.data(), topologyText.size(), residueLines, atoms, kind);
+}
+
+// First three letters of the file name, without directory or extension
+static string resiNameFromFile(const string& filename) {
+    size_t lastSlash = filename.find_last_of("/\\");
+    size_t start = (lastSlash == string::npos) ? 0 : lastSlash + 1;
+    size_t lastDot = filename.find_last_of(".");
+    size_t end = (lastDot == string::npos || lastDot < start) ? filename.size() : lastDot;
+    return filename.substr(start, end - start).substr(0, 3);
+}
+
+void setCgenffResidueName(string& strText, const string& resiName) {
+    // cgenff names the residue after its input
+    size_t resiPos = strText.find("RESI input.pdb");
+    if (resiPos != string::npos) {
+        strText.replace(resiPos + 4, 10, " " + resiName);
+    } else {
+        LOG_WARN("RESI line not found in the cgenff output.");
+    }
+}
+
+void renameCgenffResidue(string& strText, const string& mol2File) {
+    setCgenffResidueName(strText, resiNameFromFile(mol2File));
+}
+
+bool runCgenff(const string& mol2File, string& strText, const string& cgenffPath) {
+    vector<string> argv;
+    argv.push_back(cgenffPath);
+    argv.push_back(mol2File);
+    ProcessResult result;
+    if (!runProcess(argv, result)) {
+        LOG_ERROR("Failed to run cgenff executable.");
+        return false;
+    }
+    if (result.exitCode != 0) {
+        LOG_ERROR("cgenff process returned a non-zero exit code." << (result.errors.empty() ? "" : " ")
+                  << result.errors);
+        return false;
+    }
+    strText.swap(result.output);
+    renameCgenffResidue(strText, mol2File);
+    return true;
+}
+
+bool cgenffPenalties(const string& strText, double& parameterPenalty, double& chargePenalty) {
+    StrModel model;
+    parseCharmmStream(strText.data(), strText.size(), model);
+    if (model.residues.empty()) return false;
+    string comment = model.residues[0].comment.str();
+    size_t param = comment.find("param penalty=");
+    size_t charge = comment.find("charge penalty=");
+    if (param == string::npos || charge == string::npos) return false;
+    parameterPenalty = atof(comment.c_str() + param + 14);
+    chargePenalty = atof(comment.c_str() + charge + 15);
+    return true;
+}
+
+bool readMol2Atoms(const string& mol2Text, vector<ICAtom>& atoms) {
+    atoms.clear();
+    istringstream in(mol2Text);
+    string line;
+    bool inAtoms = false;
+    while (getline(in, line)) {
+        if (line.compare(0, 9, "@<TRIPOS>") == 0) {
+            if (inAtoms) break;
+            inAtoms = (line.compare(0, 13, "@<TRIPOS>ATOM") == 0);
+            continue;
+        }
+        if (!inAtoms) continue;
+        istringstream fields(line);
+        int id;
+        ICAtom atom;
+        if (!(fields >> id)) continue;   // blank line
+        if (!(fields >> atom.name >> atom.coords[0] >> atom.coords[1] >> atom.coords[2])) {
+            LOG_ERROR("Bad MOL2 atom record: " << line);
+            return false;
+        }
+        atoms.push_back(atom);
+    }
+    return !atoms.empty();
+}
+
+bool readTextFile(const string& filename, string& text) {
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in) {
+        LOG_ERROR("Could not open " << filename);
+        return false;
+    }
+    ostringstream buffer;
+    buffer << in.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+bool writeTextFile(const string& filename, const string& text) {
+    string tempName = filename + ".tmp";
+    {
+        ofstream out(tempName.c_str(), ios::out | ios::binary);
+        if (!out || !out.write(text.data(), text.size())) {
+            LOG_ERROR("Could not write " << tempName);
+            return false;
+        }
+    }
+    if (rename(tempName.c_str(), filename.c_str()) != 0) {
+        LOG_ERROR("Renaming " << tempName << " to " << filename << " failed.");
+        return false;
+    }
+    return true;
+}
+
+bool generateICTable(const ICTableJob& job) {
+    string strText;
+
+    if (job.kind == ResidueCgenff) {
+        if (!runCgenff(job.mol2File, strText)) {
+            LOG_ERROR("Failed to generate .str file.");
+            return false;
+        }
+        // Kept on disk for the renaming scripts that run afterwards
+        if (!writeTextFile(job.strFile, strText)) return false;
+    } else if (!readTextFile(job.strFile, strText)) {
+        return false;
+    }
+
+    // A standalone topology file is mapped, not read: only the new residue is
+    // copied. An overlay is small and read whole; the base is only indexed.
+    CharmmStream topology;
+    TopologyStore base;
+    string overlayText;
+    if (job.baseTopologyFile.empty()) {
+        if (!topology.open(job.topologyFile)) return false;
+    } else {
+        if (!base.open(job.baseTopologyFile)) return false;
+        ifstream existing(job.topologyFile.c_str());
+        if (!existing) {
+            LOG_INFO("Starting " << job.topologyFile << " as an overlay on " << job.baseTopologyFile);
+            overlayText = emptyOverlay(job.baseTopologyFile);
+        } else if (!readTextFile(job.topologyFile, overlayText)) {
+            return false;
+        }
+    }
+
+    PdbAtoms pdb;
+    if (!readPdbFile(job.pdbFile, pdb)) {
+        LOG_ERROR("Reading " << job.pdbFile << " failed.");
+        return false;
+    }
+    if (pdb.size() == 0) {
+        LOG_ERROR("No atoms read from " << job.pdbFile);
+        return false;
+    }
+    vector<ICAtom> atoms;
+    toICAtoms(pdb, atoms);
+    LOG_INFO("Number of atoms read: " << atoms.size());
+
+    vector<string> residueLines = residueTopologyLines(strText);
+    if (residueLines.empty()) {
+        LOG_ERROR("No RESI block in " << job.strFile);
+        return false;
+    }
+    LOG_INFO("Topology information read");
+
+    string composed;
+    if (job.baseTopologyFile.empty()) {
+        composed = insertResidueTopology(topology.data(), topology.size(), residueLines, atoms, job.kind);
+    } else {
+        composed = insertResidueTopology(overlayText, residueLines, atoms, job.kind);
+        if (!validateOverlay(base, composed, job.topologyFile)) {
+            LOG_ERROR(job.topologyFile << " was not written: it would redefine names in " << job.baseTopologyFile);
+            return false;
+        }
+    }
+    if (!writeTextFile(job.topologyFile, composed)) return false;
+    LOG_INFO("Topology information inserted into " << job.topologyFile);
+    return true;
+}
@@ -0,0 +1,82 @@
+// ICTable.h
+#ifndef ICTABLE_H
+#define ICTABLE_H
+
+#include <string>
+#include <vector>
+#include "InternalCoordinates.h"
+
+// IC table generation for a new residue: the RESI block of a CGenFF stream
+// file is merged into a topology file together with an IC table computed
+// from the residue's PDB coordinates. Used by the IC_table tool and called
+// in-process by chem_GUI.
+//
+// Residue kinds:
+//   naa     novel amino acid (nad.str / nad.pdb), with the peptide backbone
+//           IC lines and "BOND C    +N"
+//   ntrm    N-terminal conjugate (ntrm_clean.str / ntrm_clean.pdb), same
+//           backbone lines as naa
+//   fixed   free small molecule (one.str / one.pdb), no backbone lines
+//   cgenff  free small molecule whose stream file is first generated by
+//           running ./cgenff on a .mol2 file
+
+enum ResidueKind { ResidueNaa, ResidueNtrm, ResidueFixed, ResidueCgenff };
+
+bool parseResidueKind(const std::string& name, ResidueKind& kind);
+const char* residueKindName(ResidueKind kind);
+
+struct ICTableJob {
+    ResidueKind kind;
+    std::string strFile;        // CGenFF stream file with the RESI block
+    std::string pdbFile;        // coordinates of the residue
+    std::string topologyFile;   // RTF the residue is inserted into
+    std::string baseTopologyFile;   // if set, topologyFile is an overlay on it
+                                    // (TopologyOverlay.h); never written
+    std::string mol2File;       // cgenff only
+
+    // The file names the GUI workflow uses for kind
+    static ICTableJob defaults(ResidueKind kind);
+};
+
+// ── In-memory stages ────────────────────────────────────────────────────────
+
+// Lines of the residues in the topology section holding the first RESI: from
+// that RESI line up to (not including) the section's END line
+std::vector<std::string> residueTopologyLines(const std::string& strText);
+
+// ATOM/HETATM records of a PDB text: trimmed name and coordinates. False on a
+// malformed record (see PdbReader.h) or when there are no atoms.
+bool readResidueAtoms(const std::string& pdbText, std::vector<ICAtom>& atoms);
+
+// Topology text with the residue inserted in place of the END line of its
+// first topology section: RESI block, [BOND C +N], IC table, [backbone IC
+// lines], END, then the rest
+std::string insertResidueTopology(const std::string& topologyText, const std::vector<std::string>& residueLines,
+                                  const std::vector<ICAtom>& atoms, ResidueKind kind);
+std::string insertResidueTopology(const char* topologyData, size_t topologySize,
+                                  const std::vector<std::string>& residueLines, const std::vector<ICAtom>& atoms,
+                                  ResidueKind kind);
+
+// Run cgenff on mol2File and return its stream file with the RESI name set
+// to the first three letters of the .mol2 file name
+bool runCgenff(const std::string& mol2File, std::string& strText, const std::string& cgenffPath = "./cgenff");
+void renameCgenffResidue(std::string& strText, const std::string& mol2File);
+// Replace the "input.pdb" residue name cgenff writes with resiName
+void setCgenffResidueName(std::string& strText, const std::string& resiName);
+
+// "param penalty" and "charge penalty" from the RESI line of a CGenFF stream
+bool cgenffPenalties(const std::string& strText, double& parameterPenalty, double& chargePenalty);
+
+// Atom names and coordinates of the @<TRIPOS>ATOM section
+bool readMol2Atoms(const std::string& mol2Text, std::vector<ICAtom>& atoms);
+
+// ── File-level driver ────────────────────────────────────────────────────────
+
+bool readTextFile(const std::string& filename, std::string& text);
+// Written to a temporary file first, then renamed over filename
+bool writeTextFile(const std::string& filename, const std::string& text);
+
+// Run every stage of job; returns false on the first failure
+bool generateICTable(const ICTableJob& job);
+
+#endif // ICTABLE_H
@@ -0,0 +1,67 @@
+#include <iostream>       // Input-output stream library
+#include <string>         // String library
+#include "GeometryKernels.h" // Batch angle/dihedral kernels
+#include "ICTable.h"      // IC table generation
+#include "Logger.h"       // Leveled logging
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <naa|ntrm|fixed|cgenff> [options]\n"
+         << "       " << program << " --self-check   compare the batch geometry kernels with the scalar code\n"
+         << "  --str file       CGenFF stream file with the RESI block\n"
+         << "  --pdb file       residue coordinates\n"
+         << "  --topology file  topology file to insert the residue into\n"
+         << "  --base file      base topology the --topology file is an overlay on\n"
+         << "  --standalone     insert into the --topology file itself, with no base\n"
+         << "  --mol2 file      cgenff input (cgenff mode)\n"
+         << "Defaults: naa nad.str/nad.pdb, ntrm ntrm_clean.str/ntrm_clean.pdb,\n"
+         << "          fixed and cgenff one.str/one.pdb (cgenff from one.mol2);\n"
+         << "          topology top_all36_cgenff_CBD.rtf as an overlay on base\n"
+         << "          top_all36_cgenff_CBD_template.rtf (cgenff: top_all27_prot_na_CBD2.inp,\n"
+         << "          standalone)\n";
+}
+
+//Run using: g++ -std=c++11 -o IC_table IC_table.cpp ICTable.cpp ICBuilder.cpp CharmmStream.cpp TopologyStore.cpp TopologyOverlay.cpp PdbReader.cpp Subprocess.cpp InternalCoordinates.cpp GeometryCache.cpp GeometryKernels.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc == 2 && string(argv[1]) == "--self-check") {
+        return checkGeometryKernels() ? 0 : 1;
+    }
+
+    ResidueKind kind;
+    if (argc < 2 || !parseResidueKind(argv[1], kind)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    ICTableJob job = ICTableJob::defaults(kind);
+
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--standalone") {
+            job.baseTopologyFile.clear();
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Error: Missing value for " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--str") job.strFile = value;
+        else if (arg == "--pdb") job.pdbFile = value;
+        else if (arg == "--topology") job.topologyFile = value;
+        else if (arg == "--base") job.baseTopologyFile = value;
+        else if (arg == "--mol2") job.mol2File = value;
+        else {
+            cerr << "Error: Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    return generateICTable(job) ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+#include "InternalCoordinates.h"
+#include "CharmmStream.h"
+#include "GeometryCache.h"
+#include "GeometryKernels.h"
+#include "Logger.h"
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+int BondGraph::numBonds() const {
+    size_t degreeSum = 0;
+    for (size_t i = 0; i < neighbors.size(); ++i) degreeSum += neighbors[i].size();
+    return (int)(degreeSum / 2);
+}
+
+static void addBond(BondGraph& graph, int a, int b) {
+    if (a == b) return;
+    vector<int>& na = graph.neighbors[a];
+    if (find(na.begin(), na.end(), b) != na.end()) return;
+    na.push_back(b);
+    graph.neighbors[b].push_back(a);
+}
+
+static void sortNeighbors(BondGraph& graph) {
+    for (size_t i = 0; i < graph.neighbors.size(); ++i) {
+        sort(graph.neighbors[i].begin(), graph.neighbors[i].end());
+    }
+}
+
+static string upperCase(string s) {
+    for (size_t i = 0; i < s.size(); ++i) s[i] = (char)toupper((unsigned char)s[i]);
+    return s;
+}
+
+bool bondGraphFromTopology(const vector<string>& topologyLines, const vector<ICAtom>& atoms, BondGraph& graph) {
+    graph.neighbors.assign(atoms.size(), vector<int>());
+
+    map<string, int> index;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        index[upperCase(atoms[i].name)] = (int)i;
+    }
+
+    string text;
+    for (size_t l = 0; l < topologyLines.size(); ++l) {
+        text += topologyLines[l];
+        text += '\n';
+    }
+    StrModel model;
+    parseCharmmStream(text.data(), text.size(), model);
+
+    int records = 0;
+    for (size_t r = 0; r < model.residues.size(); ++r) {
+        const vector<StrBondRecord>& bonds = model.residues[r].bonds;
+        records += (int)bonds.size();
+        for (size_t k = 0; k < bonds.size(); ++k) {
+            string first = bonds[k].atoms[0].str();
+            string second = bonds[k].atoms[1].str();
+            if (first[0] == '+' || first[0] == '-' || second[0] == '+' || second[0] == '-') continue;
+            map<string, int>::const_iterator a = index.find(upperCase(first));
+            map<string, int>::const_iterator b = index.find(upperCase(second));
+            if (a == index.end() || b == index.end()) {
+                LOG_WARN("Bond " << first << " " << second << " names an atom not in the PDB");
+                continue;
+            }
+            addBond(graph, a->second, b->second);
+        }
+    }
+
+    sortNeighbors(graph);
+    return records > 0 && graph.numBonds() > 0;
+}
+
+// Single-bond covalent radius (Angstroms) from an atom name
+static double covalentRadius(const string& name) {
+    string upper = upperCase(name);
+    if (upper.compare(0, 2, "CL") == 0) return 1.02;
+    if (upper.compare(0, 2, "BR") == 0) return 1.20;
+    for (size_t i = 0; i < upper.size(); ++i) {
+        switch (upper[i]) {
+            case 'H': return 0.31;
+            case 'C': return 0.76;
+            case 'N': return 0.71;
+            case 'O': return 0.66;
+            case 'F': return 0.57;
+            case 'P': return 1.07;
+            case 'S': return 1.05;
+            case 'I': return 1.39;
+            default:
+                if (isalpha((unsigned char)upper[i])) return 0.77;
+        }
+    }
+    return 0.77;
+}
+
+void bondGraphFromDistances(const vector<ICAtom>& atoms, BondGraph& graph, double tolerance) {
+    graph.neighbors.assign(atoms.size(), vector<int>());
+    vector<double> radius(atoms.size());
+    double maxRadius = 0.0;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        radius[i] = covalentRadius(atoms[i].name);
+        maxRadius = max(maxRadius, radius[i]);
+    }
+
+    // Only pairs within the largest possible cut-off are tested
+    vector<pair<int, int> > pairs;
+    vector<double> distance;
+    neighborPairs(atoms, 2.0 * maxRadius + tolerance, pairs, distance);
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        int i = pairs[p].first, j = pairs[p].second;
+        double cutoff = radius[i] + radius[j] + tolerance;
+        if (distance[p] > 0.0 && distance[p] < cutoff) addBond(graph, i, j);
+    }
+    sortNeighbors(graph);
+}
+
+double icDistance(const ICAtom& a, const ICAtom& b) {
+    double dx = b.coords[0] - a.coords[0];
+    double dy = b.coords[1] - a.coords[1];
+    double dz = b.coords[2] - a.coords[2];
+    return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+double icAngle(const ICAtom& a, const ICAtom& b, const ICAtom& c) {
+    double u[3], v[3];
+    for (int k = 0; k < 3; ++k) {
+        u[k] = a.coords[k] - b.coords[k];
+        v[k] = c.coords[k] - b.coords[k];
+    }
+    double cross[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+    double sinPart = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+    double cosPart = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+    // atan2 stays accurate near 0 and 180 degrees, where acos does not
+    return atan2(sinPart, cosPart) * 180.0 / M_PI;
+}
+
+double icDihedral(const ICAtom& a, const ICAtom& b, const ICAtom& c, const ICAtom& d) {
+    double b1[3], b2[3], b3[3];
+    for (int k = 0; k < 3; ++k) {
+        b1[k] = b.coords[k] - a.coords[k];
+        b2[k] = c.coords[k] - b.coords[k];
+        b3[k] = d.coords[k] - c.coords[k];
+    }
+    double n1[3] = {b1[1] * b2[2] - b1[2] * b2[1], b1[2] * b2[0] - b1[0] * b2[2], b1[0] * b2[1] - b1[1] * b2[0]};
+    double n2[3] = {b2[1] * b3[2] - b2[2] * b3[1], b2[2] * b3[0] - b2[0] * b3[2], b2[0] * b3[1] - b2[1] * b3[0]};
+    double b2Length = sqrt(b2[0] * b2[0] + b2[1] * b2[1] + b2[2] * b2[2]);
+
+    double x = n1[0] * n2[0] + n1[1] * n2[1] + n1[2] * n2[2];
+    double y = b2Length * (b1[0] * n2[0] + b1[1] * n2[1] + b1[2] * n2[2]);
+    return atan2(y, x) * 180.0 / M_PI;
+}
+
+#ifdef CHEM_ENABLE_TRACE
+// Payload of a TraceICEntry record
+struct ICTraceRecord {
+    int32_t atoms[4];
+    int32_t improper;
+    double values[5];
+};
+#endif
+
+// Trace one finished entry (when compiled in)
+static void traceEntry(const vector<ICAtom>& atoms, const ICEntry& e) {
+    LOG_TRACE("IC " << atoms[e.atoms[0]].name << " " << atoms[e.atoms[1]].name << " "
+              << (e.improper ? "*" : "") << atoms[e.atoms[2]].name << " " << atoms[e.atoms[3]].name << " "
+              << e.bond1 << " " << e.angle1 << " " << e.dihedral << " " << e.angle2 << " " << e.bond2);
+#ifdef CHEM_ENABLE_TRACE
+    ICTraceRecord record;
+    for (int k = 0; k < 4; ++k) record.atoms[k] = e.atoms[k];
+    record.improper = e.improper ? 1 : 0;
+    record.values[0] = e.bond1;
+    record.values[1] = e.angle1;
+    record.values[2] = e.dihedral;
+    record.values[3] = e.angle2;
+    record.values[4] = e.bond2;
+    TRACE_RECORD(TraceICEntry, &record, sizeof(record));
+#else
+    (void)atoms;
+    (void)e;
+#endif
+}
+
+void buildInternalCoordinates(const vector<ICAtom>& atoms, const BondGraph& graph, vector<ICEntry>& entries) {
+    entries.clear();
+    const vector<vector<int> >& nb = graph.neighbors;
+
+    // Bond lengths and angles, each computed once; the dihedrals are batched below
+    GeometryCache cache;
+    cache.build(atoms, graph);
+
+    // Proper entries: every path A-B-C-D, each central bond B-C taken once (B < C)
+    for (int b = 0; b < (int)atoms.size(); ++b) {
+        for (size_t ci = 0; ci < nb[b].size(); ++ci) {
+            int c = nb[b][ci];
+            if (c < b) continue;
+            int bi = neighborSlot(graph, c, b);
+            for (size_t ai = 0; ai < nb[b].size(); ++ai) {
+                int a = nb[b][ai];
+                if (a == c) continue;
+                for (size_t di = 0; di < nb[c].size(); ++di) {
+                    int d = nb[c][di];
+                    if (d == b || d == a) continue;   // d == a closes a three-ring
+                    ICEntry e;
+                    e.atoms[0] = a;
+                    e.atoms[1] = b;
+                    e.atoms[2] = c;
+                    e.atoms[3] = d;
+                    e.improper = false;
+                    e.bond1 = cache.bondLength(b, (int)ai);
+                    e.angle1 = cache.bondAngle(b, (int)ai, (int)ci);
+                    e.dihedral = 0.0;
+                    e.angle2 = cache.bondAngle(c, bi, (int)di);
+                    e.bond2 = cache.bondLength(c, (int)di);
+                    entries.push_back(e);
+                }
+            }
+        }
+    }
+
+    // Improper entries: at a centre K with neighbours n0 < n1 < ..., one
+    // "IC n0 n1 *K nm" for every further neighbour nm
+    for (int k = 0; k < (int)atoms.size(); ++k) {
+        if (nb[k].size() < 3) continue;
+        int i = nb[k][0], j = nb[k][1];
+        for (size_t m = 2; m < nb[k].size(); ++m) {
+            int l = nb[k][m];
+            ICEntry e;
+            e.atoms[0] = i;
+            e.atoms[1] = j;
+            e.atoms[2] = k;
+            e.atoms[3] = l;
+            e.improper = true;
+            e.bond1 = cache.bondLength(k, 0);
+            e.angle1 = cache.bondAngle(k, 0, 1);
+            e.dihedral = 0.0;
+            e.angle2 = cache.bondAngle(k, 1, (int)m);
+            e.bond2 = cache.bondLength(k, (int)m);
+            entries.push_back(e);
+        }
+    }
+
+    // Every dihedral in one batch; an improper's is that of the chain I-J-K-L
+    if (!entries.empty()) {
+        vector<int> quads(4 * entries.size());
+        for (size_t n = 0; n < entries.size(); ++n) {
+            for (int x = 0; x < 4; ++x) quads[4 * n + x] = entries[n].atoms[x];
+        }
+        CoordinateArrays coords;
+        coords.assign(atoms);
+        vector<double> dihedrals(entries.size());
+        batchDihedrals(&coords.x[0], &coords.y[0], &coords.z[0], &quads[0], entries.size(), &dihedrals[0]);
+        for (size_t n = 0; n < entries.size(); ++n) {
+            entries[n].dihedral = dihedrals[n];
+            traceEntry(atoms, entries[n]);
+        }
+    }
+
+    LOG_DEBUG(entries.size() << " IC entries from " << graph.numBonds() << " bonds");
+}
+
+void writeICEntries(const vector<ICAtom>& atoms, const vector<ICEntry>& entries, ostream& out) {
+    char line[128];
+    for (size_t n = 0; n < entries.size(); ++n) {
+        const ICEntry& e = entries[n];
+        string third = (e.improper ? "*" : "") + atoms[e.atoms[2]].name;
+        // Same columns as the hand-written peptide IC lines
+        snprintf(line, sizeof(line), "IC %-4s %-4s %-4s %-4s%8.4f %8.4f %9.4f %8.4f %7.4f",
+                 atoms[e.atoms[0]].name.c_str(), atoms[e.atoms[1]].name.c_str(), third.c_str(),
+                 atoms[e.atoms[3]].name.c_str(), e.bond1, e.angle1, e.dihedral, e.angle2, e.bond2);
+        out << line << "\n";
+    }
+}
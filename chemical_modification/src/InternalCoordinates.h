@@ -0,0 +1,67 @@
+#ifndef INTERNALCOORDINATES_H
+#define INTERNALCOORDINATES_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+// Internal coordinate (IC) tables for CHARMM/CGenFF residue topologies.
+//
+// The IC entries are generated from the bond graph rather than by testing
+// every 4-tuple of atoms: one entry per bonded path A-B-C-D (a proper
+// dihedral) and one per extra branch at every atom with three or more
+// neighbours (an improper, written "IC I J *K L"). With deg the largest
+// number of neighbours this is O(N * deg^3) instead of O(N^4).
+
+// ── Data structures ──────────────────────────────────────────────────────────
+
+struct ICAtom {
+    std::string name;      // trimmed PDB atom name, e.g. "C1", "HN"
+    double coords[3];
+};
+
+// Adjacency lists, neighbours of each atom in ascending index order
+struct BondGraph {
+    std::vector<std::vector<int> > neighbors;
+
+    int numBonds() const;
+};
+
+// One IC line. For a proper entry the values are R(A,B), theta(A,B,C),
+// phi(A,B,C,D), theta(B,C,D), R(C,D); for an improper (C is the centre)
+// they are R(A,C), theta(A,C,B), phi(A,B,C,D), theta(B,C,D), R(C,D).
+struct ICEntry {
+    int atoms[4];
+    bool improper;
+    double bond1, angle1, dihedral, angle2, bond2;   // Angstroms and degrees
+};
+
+// ── Bond graph ───────────────────────────────────────────────────────────────
+
+// Bonds from the BOND/DOUBLE/TRIPLE/AROMATIC records of the RESI blocks in
+// RTF/STR lines (parsed by CharmmStream). Names with a +/- prefix (the neighbouring residue) are skipped. Returns
+// false if the lines hold no usable bond record.
+bool bondGraphFromTopology(const std::vector<std::string>& topologyLines,
+                           const std::vector<ICAtom>& atoms, BondGraph& graph);
+
+// Bonds between atoms closer than the sum of their covalent radii plus
+// tolerance (element from the atom name)
+void bondGraphFromDistances(const std::vector<ICAtom>& atoms, BondGraph& graph, double tolerance = 0.45);
+
+// ── Geometry (degrees) ───────────────────────────────────────────────────────
+
+double icDistance(const ICAtom& a, const ICAtom& b);
+double icAngle(const ICAtom& a, const ICAtom& b, const ICAtom& c);
+// IUPAC sign convention: positive for clockwise rotation looking down B->C
+double icDihedral(const ICAtom& a, const ICAtom& b, const ICAtom& c, const ICAtom& d);
+
+// ── IC tables ────────────────────────────────────────────────────────────────
+
+// Every proper path and improper centre of the graph, in atom order
+void buildInternalCoordinates(const std::vector<ICAtom>& atoms, const BondGraph& graph,
+                              std::vector<ICEntry>& entries);
+
+// Write entries as RTF "IC" lines
+void writeICEntries(const std::vector<ICAtom>& atoms, const std::vector<ICEntry>& entries, std::ostream& out);
+
+#endif // INTERNALCOORDINATES_H
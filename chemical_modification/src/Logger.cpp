@@ -0,0 +1,136 @@
+// Logger.cpp
+#include "Logger.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+using namespace std;
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : level(LogInfo), rateLimit(20), traceFile(NULL) {
+}
+
+Logger::~Logger() {
+    flushSuppressed();
+    closeTrace();
+}
+
+void Logger::configureFromEnvironment() {
+    const char* value = getenv("CHEM_LOG_LEVEL");
+    if (value) {
+        string name(value);
+        if (name == "error") setLevel(LogError);
+        else if (name == "warn") setLevel(LogWarn);
+        else if (name == "info") setLevel(LogInfo);
+        else if (name == "debug") setLevel(LogDebug);
+        else if (name == "trace") setLevel(LogTrace);
+        else LOG_WARN("Unknown CHEM_LOG_LEVEL \"" << name << "\", using info");
+    }
+
+    value = getenv("CHEM_LOG_RATE");
+    if (value) setRateLimit(atoi(value));
+
+    value = getenv("CHEM_TRACE_FILE");
+    if (value && *value) openTrace(value);
+
+#ifndef CHEM_ENABLE_TRACE
+    if (level == LogTrace || tracing()) {
+        LOG_WARN("Trace output was not compiled in; rebuild with -DCHEM_ENABLE_TRACE");
+    }
+#endif
+}
+
+void Logger::setLevel(LogLevel newLevel) {
+    level = newLevel;
+}
+
+void Logger::setRateLimit(int perSecond) {
+    lock_guard<std::mutex> lock(mutex);
+    rateLimit = perSecond < 0 ? 0 : perSecond;
+}
+
+void Logger::write(LogLevel messageLevel, const string& message) {
+    switch (messageLevel) {
+        case LogError: cerr << "Error: " << message << endl; break;
+        case LogWarn: cerr << "Warning: " << message << '\n'; break;
+        case LogInfo: cout << message << '\n'; break;
+        case LogDebug: cout << "Debug: " << message << '\n'; break;
+        case LogTrace: cout << "Trace: " << message << '\n'; break;
+    }
+}
+
+void Logger::log(LogLevel messageLevel, const char* site, const string& message) {
+    lock_guard<std::mutex> lock(mutex);
+    if (messageLevel == LogError || rateLimit == 0) {
+        write(messageLevel, message);
+        return;
+    }
+
+    long now = (long)time(NULL);
+    SiteState& state = sites.insert(make_pair(string(site), SiteState())).first->second;
+    if (state.count == 0 || now != state.window) {
+        if (state.suppressed > 0) {
+            ostringstream note;
+            note << state.suppressed << " similar message(s) from " << site << " suppressed";
+            write(messageLevel, note.str());
+            state.suppressed = 0;
+        }
+        state.window = now;
+        state.count = 0;
+    }
+    if (state.count < rateLimit) {
+        state.count++;
+        write(messageLevel, message);
+    } else {
+        state.suppressed++;
+    }
+}
+
+void Logger::flushSuppressed() {
+    lock_guard<std::mutex> lock(mutex);
+    for (map<string, SiteState>::iterator it = sites.begin(); it != sites.end(); ++it) {
+        if (it->second.suppressed > 0) {
+            cerr << "Warning: " << it->second.suppressed << " similar message(s) from " << it->first
+                 << " suppressed" << endl;
+            it->second.suppressed = 0;
+        }
+    }
+    cout.flush();
+}
+
+bool Logger::openTrace(const string& filename) {
+    lock_guard<std::mutex> lock(mutex);
+    if (traceFile) fclose(traceFile);
+    traceFile = fopen(filename.c_str(), "wb");
+    if (!traceFile) {
+        cerr << "Error: Could not open trace file " << filename << endl;
+        return false;
+    }
+    fwrite("CHEMTRC1", 1, 8, traceFile);
+    return true;
+}
+
+void Logger::closeTrace() {
+    lock_guard<std::mutex> lock(mutex);
+    if (traceFile) {
+        fclose(traceFile);
+        traceFile = NULL;
+    }
+}
+
+void Logger::traceRecord(uint16_t kind, const void* data, uint32_t size) {
+    lock_guard<std::mutex> lock(mutex);
+    if (!traceFile) return;
+    unsigned char header[8];
+    uint16_t reserved = 0;
+    memcpy(header, &kind, 2);
+    memcpy(header + 2, &reserved, 2);
+    memcpy(header + 4, &size, 4);
+    fwrite(header, 1, 8, traceFile);
+    fwrite(data, 1, size, traceFile);
+}
@@ -0,0 +1,109 @@
+// Logger.h
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+// Leveled logging for the chemical_modification tools.
+//
+//   LOG_ERROR / LOG_WARN  -> stderr ("Error: ..." / "Warning: ...")
+//   LOG_INFO / LOG_DEBUG  -> stdout
+//   LOG_TRACE             -> stdout, compiled in only with -DCHEM_ENABLE_TRACE
+//
+// The level, the per-call-site rate limit and the binary trace file are read
+// from the environment by configureFromEnvironment():
+//   CHEM_LOG_LEVEL   error | warn | info | debug | trace   (default info)
+//   CHEM_LOG_RATE    messages per call site per second, 0 = unlimited (default 20)
+//   CHEM_TRACE_FILE  write binary trace records to this file
+//
+// Without CHEM_ENABLE_TRACE the LOG_TRACE and TRACE_RECORD call sites expand
+// to nothing, so per-tuple loops do no logging work at all.
+
+enum LogLevel { LogError = 0, LogWarn, LogInfo, LogDebug, LogTrace };
+
+// Binary trace record kinds
+enum TraceKind : uint16_t { TraceICEntry = 1 };
+
+class Logger {
+public:
+    static Logger& instance();
+
+    void configureFromEnvironment();
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const { return level; }
+    bool enabled(LogLevel messageLevel) const { return messageLevel <= level; }
+
+    // Messages per call site per second before the rest are counted and
+    // dropped; 0 disables the limit. Errors are never dropped.
+    void setRateLimit(int perSecond);
+
+    void log(LogLevel messageLevel, const char* site, const std::string& message);
+
+    // Binary trace: an 8-byte "CHEMTRC1" header, then per record
+    // uint16 kind, uint16 reserved, uint32 size, size payload bytes
+    bool openTrace(const std::string& filename);
+    void closeTrace();
+    bool tracing() const { return traceFile != NULL; }
+    void traceRecord(uint16_t kind, const void* data, uint32_t size);
+
+    // Report messages still held back by the rate limit
+    void flushSuppressed();
+
+    ~Logger();
+
+private:
+    Logger();
+    Logger(const Logger&);
+    Logger& operator=(const Logger&);
+
+    struct SiteState {
+        long window;        // second the current window started
+        int count;          // messages written in this window
+        long suppressed;    // messages dropped since the last report
+    };
+
+    void write(LogLevel messageLevel, const std::string& message);
+
+    LogLevel level;
+    int rateLimit;
+    std::map<std::string, SiteState> sites;
+    FILE* traceFile;
+    std::mutex mutex;
+};
+
+#define CHEM_LOG_STRINGIFY2(x) #x
+#define CHEM_LOG_STRINGIFY(x) CHEM_LOG_STRINGIFY2(x)
+#define CHEM_LOG_SITE __FILE__ ":" CHEM_LOG_STRINGIFY(__LINE__)
+
+// The message is only formatted when its level is enabled
+#define CHEM_LOG(level, expr)                                                        \
+    do {                                                                             \
+        if (Logger::instance().enabled(level)) {                                     \
+            std::ostringstream chemLogStream;                                        \
+            chemLogStream << expr;                                                   \
+            Logger::instance().log(level, CHEM_LOG_SITE, chemLogStream.str());       \
+        }                                                                            \
+    } while (0)
+
+#define LOG_ERROR(expr) CHEM_LOG(LogError, expr)
+#define LOG_WARN(expr) CHEM_LOG(LogWarn, expr)
+#define LOG_INFO(expr) CHEM_LOG(LogInfo, expr)
+#define LOG_DEBUG(expr) CHEM_LOG(LogDebug, expr)
+
+#ifdef CHEM_ENABLE_TRACE
+#define LOG_TRACE(expr) CHEM_LOG(LogTrace, expr)
+#define TRACE_RECORD(kind, data, size)                                               \
+    do {                                                                             \
+        if (Logger::instance().tracing()) Logger::instance().traceRecord(kind, data, size); \
+    } while (0)
+#else
+#define LOG_TRACE(expr) do {} while (0)
+#define TRACE_RECORD(kind, data, size) do {} while (0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,236 @@
+// ParameterCheck.cpp
+#include "ParameterCheck.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+// ── Type tuple keys ──────────────────────────────────────────────────────────
+
+// Up to four 16-bit type indices, first type in the high bits; a tuple and
+// its reverse share the smaller key
+static const size_t maxTypes = 0xFFFF;
+
+static uint64_t tupleKey(const uint32_t* atoms, size_t arity, const vector<uint32_t>& atomType) {
+    uint64_t forward = 0, reverse = 0;
+    for (size_t i = 0; i < arity; ++i) {
+        forward = (forward << 16) | atomType[atoms[i]];
+        reverse = (reverse << 16) | atomType[atoms[arity - 1 - i]];
+    }
+    return min(forward, reverse);
+}
+
+static vector<string> tupleTypes(uint64_t key, size_t arity, const vector<uint32_t>& typeString,
+                                 const PsfFile& psf) {
+    vector<string> types(arity);
+    for (size_t i = arity; i-- > 0; key >>= 16) types[i] = psf.text(typeString[key & 0xFFFF]);
+    return types;
+}
+
+// types may come back reversed from the PSF order; lookup() tries every
+// wildcard pattern in both orientations, so either is found
+static bool defined(ParameterSection section, const vector<string>& types,
+                    const vector<const ParameterStore*>& stores) {
+    vector<const ParameterEntry*> found;
+    for (size_t s = 0; s < stores.size(); ++s) {
+        if (stores[s]->lookup(section, types, found)) return true;
+    }
+    return false;
+}
+
+static vector<string> residueNames(const set<uint32_t>& ids, const PsfFile& psf) {
+    vector<string> names;
+    for (set<uint32_t>::const_iterator it = ids.begin(); it != ids.end(); ++it) names.push_back(psf.text(*it));
+    sort(names.begin(), names.end());
+    return names;
+}
+
+// ── Checking ─────────────────────────────────────────────────────────────────
+
+bool findMissingParameters(const PsfFile& psf, const vector<const ParameterStore*>& stores,
+                           ParameterCheckReport& report) {
+    report = ParameterCheckReport();
+
+    // Dense indices for the atom types, in order of first use
+    vector<uint32_t> typeIndex(psf.stringCount(), UINT32_MAX);
+    vector<uint32_t> typeString;
+    vector<uint32_t> atomType(psf.atomCount());
+    for (size_t a = 0; a < psf.atomCount(); ++a) {
+        uint32_t& index = typeIndex[psf.types[a]];
+        if (index == UINT32_MAX) {
+            index = (uint32_t)typeString.size();
+            typeString.push_back(psf.types[a]);
+        }
+        atomType[a] = index;
+    }
+    if (typeString.size() > maxTypes) {
+        LOG_ERROR("Too many atom types to check: " << typeString.size());
+        return false;
+    }
+
+    // Nonbonded: one entry per atom type
+    for (size_t t = 0; t < typeString.size(); ++t) {
+        vector<string> types(1, psf.text(typeString[t]));
+        report.tuplesChecked++;
+        if (defined(ParamNonbonded, types, stores)) continue;
+
+        MissingParameter term;
+        term.section = ParamNonbonded;
+        term.types = types;
+        set<uint32_t> residues;
+        for (size_t a = 0; a < psf.atomCount(); ++a) {
+            if (atomType[a] != t) continue;
+            if (term.uses++ == 0) term.example = psf.describeAtom((uint32_t)a);
+            residues.insert(psf.resnames[a]);
+        }
+        term.residues = residueNames(residues, psf);
+        report.missing.push_back(term);
+    }
+
+    const ParameterSection sections[] = {ParamBonds, ParamAngles, ParamDihedrals, ParamImpropers};
+    const vector<uint32_t>* lists[] = {&psf.bonds, &psf.angles, &psf.dihedrals, &psf.impropers};
+    for (size_t s = 0; s < 4; ++s) {
+        const ParameterSection section = sections[s];
+        const vector<uint32_t>& atoms = *lists[s];
+        const size_t arity = (size_t)parameterArity(section);
+        const size_t terms = atoms.size() / arity;
+
+        // Distinct tuples, in order of first use
+        unordered_set<uint64_t> seen;
+        vector<uint64_t> tuples;
+        for (size_t i = 0; i < terms; ++i) {
+            uint64_t key = tupleKey(&atoms[i * arity], arity, atomType);
+            if (seen.insert(key).second) tuples.push_back(key);
+        }
+        report.tuplesChecked += tuples.size();
+
+        unordered_map<uint64_t, size_t> missingIndex;
+        vector<set<uint32_t> > residues;
+        for (size_t k = 0; k < tuples.size(); ++k) {
+            vector<string> types = tupleTypes(tuples[k], arity, typeString, psf);
+            if (defined(section, types, stores)) continue;
+            missingIndex[tuples[k]] = report.missing.size();
+            residues.push_back(set<uint32_t>());
+            MissingParameter term;
+            term.section = section;
+            term.types = types;
+            report.missing.push_back(term);
+        }
+        if (missingIndex.empty()) continue;
+
+        // Trace only the missing tuples back to their atoms
+        const size_t first = report.missing.size() - residues.size();
+        for (size_t i = 0; i < terms; ++i) {
+            const uint32_t* term = &atoms[i * arity];
+            unordered_map<uint64_t, size_t>::const_iterator it = missingIndex.find(tupleKey(term, arity, atomType));
+            if (it == missingIndex.end()) continue;
+            MissingParameter& missing = report.missing[it->second];
+            if (missing.uses++ == 0) {
+                for (size_t j = 0; j < arity; ++j) {
+                    if (j) missing.example += " - ";
+                    missing.example += psf.describeAtom(term[j]);
+                }
+            }
+            for (size_t j = 0; j < arity; ++j) residues[it->second - first].insert(psf.resnames[term[j]]);
+        }
+        for (size_t m = 0; m < residues.size(); ++m) report.missing[first + m].residues = residueNames(residues[m], psf);
+    }
+    return true;
+}
+
+string describeMissingParameter(const MissingParameter& term) {
+    ostringstream out;
+    out << parameterSectionName(term.section);
+    for (size_t i = 0; i < term.types.size(); ++i) out << " " << term.types[i];
+    out << "  (" << term.uses << (term.uses == 1 ? " use" : " uses");
+    for (size_t i = 0; i < term.residues.size(); ++i) out << (i ? ", " : ": ") << term.residues[i];
+    if (!term.example.empty()) out << "; e.g. " << term.example;
+    out << ")";
+    return out.str();
+}
+
+// ── NAMD configuration ───────────────────────────────────────────────────────
+
+// $name and ${name} of earlier "set" commands
+static string substituteVariables(const string& value, const map<string, string>& variables) {
+    string result;
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] != '$') {
+            result += value[i];
+            continue;
+        }
+        size_t begin = i + 1, end;
+        bool braced = begin < value.size() && value[begin] == '{';
+        if (braced) {
+            end = value.find('}', ++begin);
+            if (end == string::npos) return value;
+        } else {
+            end = begin;
+            while (end < value.size() && (isalnum((unsigned char)value[end]) || value[end] == '_')) end++;
+        }
+        map<string, string>::const_iterator it = variables.find(value.substr(begin, end - begin));
+        if (it == variables.end()) return value;
+        result += it->second;
+        i = braced ? end : end - 1;
+    }
+    return result;
+}
+
+bool namdInputFiles(const string& confFile, string& structureFile, vector<string>& parameterFiles) {
+    ifstream in(confFile.c_str());
+    if (!in) {
+        LOG_ERROR("Could not open " << confFile);
+        return false;
+    }
+    structureFile.clear();
+    parameterFiles.clear();
+    map<string, string> variables;
+    string line;
+    while (getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        istringstream fields(line);
+        string keyword, value;
+        if (!(fields >> keyword >> value)) continue;
+        transform(keyword.begin(), keyword.end(), keyword.begin(), ::tolower);
+        if (keyword == "set") {
+            string setting;
+            if (fields >> setting) variables[value] = substituteVariables(setting, variables);
+        } else if (keyword == "structure") {
+            structureFile = substituteVariables(value, variables);
+        } else if (keyword == "parameters") {
+            parameterFiles.push_back(substituteVariables(value, variables));
+        }
+    }
+    return true;
+}
+
+bool checkStructureParameters(const string& psfFile, const vector<string>& parameterFiles,
+                              ParameterCheckReport& report) {
+    PsfFile psf;
+    if (!psf.load(psfFile)) return false;
+
+    vector<ParameterStore> stores(parameterFiles.size());
+    vector<const ParameterStore*> storeList;
+    for (size_t i = 0; i < parameterFiles.size(); ++i) {
+        if (!stores[i].load(parameterFiles[i])) return false;
+        storeList.push_back(&stores[i]);
+    }
+
+    if (!findMissingParameters(psf, storeList, report)) return false;
+    if (report.missing.empty()) {
+        LOG_INFO(psfFile << ": all " << report.tuplesChecked << " distinct type tuples have parameters");
+    } else {
+        LOG_ERROR(psfFile << ": " << report.missing.size() << " of " << report.tuplesChecked
+                  << " distinct type tuples have no parameters");
+        for (size_t i = 0; i < report.missing.size(); ++i) LOG_ERROR("  " << describeMissingParameter(report.missing[i]));
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+// ParameterCheck.h
+#ifndef PARAMETERCHECK_H
+#define PARAMETERCHECK_H
+
+#include "ParameterStore.h"
+#include "PsfFile.h"
+#include <string>
+#include <vector>
+
+// Bonded and nonbonded terms of a generated structure (QB_naa_capsid_wb.psf)
+// that none of the parameter files NAMD will read defines, found before
+// NAMD aborts on the first one at startup.
+//
+// Every bond, angle, dihedral and improper of the PSF is reduced to its
+// type tuple; each distinct tuple (either direction) is looked up once,
+// with CHARMM's X wildcards, in the parameter stores in turn. Each atom
+// type is checked for a NONBONDED entry. Only the missing tuples are then
+// traced back to the residues using them. CMAP cross-terms are not
+// checked.
+
+struct MissingParameter {
+    ParameterSection section;           // bonds to impropers, or nonbonded for an atom type
+    std::vector<std::string> types;
+    size_t uses;                        // terms of the structure with these types
+    std::vector<std::string> residues;  // residue names using it, sorted
+    std::string example;                // the atoms of the first such term
+
+    MissingParameter() : section(ParamBonds), uses(0) {}
+};
+
+struct ParameterCheckReport {
+    size_t tuplesChecked;               // distinct type tuples and atom types
+    std::vector<MissingParameter> missing;
+
+    ParameterCheckReport() : tuplesChecked(0) {}
+};
+
+// Check psf against stores; false only if the PSF has more atom types
+// than the tuple keys can hold
+bool findMissingParameters(const PsfFile& psf, const std::vector<const ParameterStore*>& stores,
+                           ParameterCheckReport& report);
+
+// The "structure" and "parameters" files of a NAMD configuration file
+bool namdInputFiles(const std::string& confFile, std::string& structureFile,
+                    std::vector<std::string>& parameterFiles);
+
+// Load psfFile and parameterFiles and check them; false if a file cannot
+// be read. Missing terms are logged and left in report.
+bool checkStructureParameters(const std::string& psfFile, const std::vector<std::string>& parameterFiles,
+                              ParameterCheckReport& report);
+
+// One missing term per line: "DIHEDRALS CG2R61 CG321 NH1 C  (3 uses: NAD; e.g. P1:12 NAD C7 ...)"
+std::string describeMissingParameter(const MissingParameter& term);
+
+#endif // PARAMETERCHECK_H
@@ -0,0 +1,558 @@
+// ParameterStore.cpp
+#include "ParameterStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+const char* parameterSectionName(ParameterSection section) {
+    switch (section) {
+        case ParamAtoms: return "ATOMS";
+        case ParamBonds: return "BONDS";
+        case ParamAngles: return "ANGLES";
+        case ParamDihedrals: return "DIHEDRALS";
+        case ParamImpropers: return "IMPROPERS";
+        case ParamCmap: return "CMAP";
+        case ParamNonbonded: return "NONBONDED";
+        case ParamNbfix: return "NBFIX";
+        case ParamHbond: return "HBOND";
+        case ParamSectionCount: break;
+    }
+    return "UNKNOWN";
+}
+
+int parameterArity(ParameterSection section) {
+    switch (section) {
+        case ParamBonds: return 2;
+        case ParamAngles: return 3;
+        case ParamDihedrals: return 4;
+        case ParamImpropers: return 4;
+        case ParamNonbonded: return 1;
+        case ParamNbfix: return 2;
+        default: return 0;
+    }
+}
+
+// Types in dihedral and improper entries are followed by a multiplicity
+static bool hasMultiplicity(ParameterSection section) {
+    return section == ParamDihedrals || section == ParamImpropers;
+}
+
+// Numbers after the types, excluding the multiplicity
+static size_t minimumValues(ParameterSection section) {
+    switch (section) {
+        case ParamNonbonded: return 3;     // ignored, epsilon, Rmin/2
+        default: return 2;
+    }
+}
+
+bool ParameterEntry::sameValues(const ParameterEntry& other) const {
+    if (multiplicity != other.multiplicity || values.size() != other.values.size()) return false;
+    for (size_t i = 0; i < values.size(); ++i) {
+        double scale = max(1.0, max(fabs(values[i]), fabs(other.values[i])));
+        if (fabs(values[i] - other.values[i]) > 1e-6 * scale) return false;
+    }
+    return true;
+}
+
+bool ParameterMergeOptions::defaults(const string& kind, ParameterMergeOptions& options) {
+    // CHARMM36 protein-side types after renameAtomTypes (AtomTypeRenamer.h)
+    static const char* const naaTypes[] = {"NH1", "NH2", "CT1", "CT2", "CT3", "C",  "O",   "H",  "HN",
+                                           "HB1", "HB2", "HB3", "HA3", "HP",  "CA", "OH1", "S"};
+    static const char* const npcTypes[] = {"NH1", "CT1", "C", "CT2", "H", "HB1", "HB3", "O"};
+
+    if (kind == "naa") {
+        options.label = "NAA";
+        options.proteinTypes.assign(naaTypes, naaTypes + sizeof(naaTypes) / sizeof(naaTypes[0]));
+    } else if (kind == "npc") {
+        options.label = "NPC";
+        options.proteinTypes.assign(npcTypes, npcTypes + sizeof(npcTypes) / sizeof(npcTypes[0]));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ── Line helpers ─────────────────────────────────────────────────────────────
+
+// Whitespace-separated tokens before any "!" comment
+static void tokenize(const string& line, vector<string>& tokens) {
+    tokens.clear();
+    size_t end = line.find('!');
+    if (end == string::npos) end = line.size();
+    size_t p = 0;
+    while (p < end) {
+        while (p < end && isspace((unsigned char)line[p])) p++;
+        size_t begin = p;
+        while (p < end && !isspace((unsigned char)line[p])) p++;
+        if (p > begin) tokens.push_back(line.substr(begin, p - begin));
+    }
+}
+
+static string upper(const string& s) {
+    string u(s);
+    for (size_t i = 0; i < u.size(); ++i) u[i] = (char)toupper((unsigned char)u[i]);
+    return u;
+}
+
+static bool toNumber(const string& token, double& value) {
+    const char* begin = token.c_str();
+    char* end = NULL;
+    value = strtod(begin, &end);
+    return end != begin && *end == '\0';
+}
+
+// Section of a header line, or -1. A line whose second token is a number is
+// an entry, whatever its first token.
+static int headerSection(const vector<string>& tokens) {
+    if (tokens.empty()) return -1;
+    double number;
+    if (tokens.size() > 1 && toNumber(tokens[1], number)) return -1;
+
+    string word = upper(tokens[0]);
+    if (word == "ATOMS") return ParamAtoms;
+    if (word == "BONDS" || word == "BOND") return ParamBonds;
+    if (word == "ANGLES" || word == "ANGL" || word == "THETAS" || word == "THETA") return ParamAngles;
+    if (word == "DIHEDRALS" || word == "DIHE" || word == "PHI") return ParamDihedrals;
+    if (word == "IMPROPERS" || word == "IMPROPER" || word == "IMPR" || word == "IMPHI") return ParamImpropers;
+    if (word == "CMAP") return ParamCmap;
+    if (word == "NONBONDED" || word == "NONB" || word == "NBONDED") return ParamNonbonded;
+    if (word == "NBFIX") return ParamNbfix;
+    if (word == "HBOND" || word == "HBONDS") return ParamHbond;
+    return -1;
+}
+
+static bool continues(const string& line) {
+    size_t end = line.find('!');
+    if (end == string::npos) end = line.size();
+    while (end > 0 && isspace((unsigned char)line[end - 1])) end--;
+    return end > 0 && line[end - 1] == '-';
+}
+
+// Section number and the tuple or its reverse, whichever sorts first
+static string canonicalKey(ParameterSection section, const vector<string>& types) {
+    vector<string> reversed(types.rbegin(), types.rend());
+    const vector<string>& tuple = (section != ParamNonbonded && reversed < types) ? reversed : types;
+    string key(1, (char)('0' + section));
+    for (size_t i = 0; i < tuple.size(); ++i) {
+        key += ' ';
+        key += tuple[i];
+    }
+    return key;
+}
+
+static string describe(const ParameterEntry& entry) {
+    ostringstream out;
+    out << parameterSectionName(entry.section);
+    for (size_t i = 0; i < entry.types.size(); ++i) out << " " << entry.types[i];
+    if (hasMultiplicity(entry.section)) out << " n=" << entry.multiplicity;
+    return out.str();
+}
+
+static string valueList(const ParameterEntry& entry) {
+    ostringstream out;
+    for (size_t i = 0; i < entry.values.size(); ++i) out << (i ? " " : "") << entry.values[i];
+    return out.str();
+}
+
+// "n=2: 0.2 180; n=3: 0.1 0" for the terms of one dihedral or improper tuple
+static string termList(const vector<const ParameterEntry*>& terms) {
+    ostringstream out;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        out << (i ? "; " : "") << "n=" << terms[i]->multiplicity << ": " << valueList(*terms[i]);
+    }
+    return out.str();
+}
+
+// Same multiplicities, each with the same values, in any order
+static bool sameTerms(const vector<const ParameterEntry*>& a, const vector<const ParameterEntry*>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        bool matched = false;
+        for (size_t j = 0; j < b.size() && !matched; ++j) {
+            matched = a[i]->multiplicity == b[j]->multiplicity && a[i]->sameValues(*b[j]);
+        }
+        if (!matched) return false;
+    }
+    return true;
+}
+
+// ── ParameterStore ───────────────────────────────────────────────────────────
+
+ParameterStore::ParameterStore() {
+    clear();
+}
+
+void ParameterStore::clear() {
+    preamble.clear();
+    blocks.clear();
+    trailer.clear();
+    entries.clear();
+    index.clear();
+    for (int i = 0; i < ParamSectionCount; ++i) counts[i] = 0;
+    droppedDuplicates = 0;
+    conflictList.clear();
+    problemList.clear();
+}
+
+bool ParameterStore::load(const string& filename) {
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in) {
+        LOG_ERROR("Could not open " << filename);
+        return false;
+    }
+    ostringstream buffer;
+    buffer << in.rdbuf();
+    parse(buffer.str());
+
+    for (size_t i = 0; i < problemList.size(); ++i) LOG_WARN(filename << " " << problemList[i]);
+    for (size_t i = 0; i < conflictList.size(); ++i) LOG_WARN(filename << ": " << conflictList[i]);
+    if (droppedDuplicates > 0) LOG_INFO(filename << ": " << droppedDuplicates << " duplicate entries dropped");
+    return true;
+}
+
+bool ParameterStore::parse(const string& text) {
+    clear();
+
+    enum { Preamble, Sections, Topology, Trailer } mode = Preamble;
+    bool header = false;            // the previous header line ended in "-"
+    vector<string> tokens;
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t newline = text.find('\n', pos);
+        size_t next = newline == string::npos ? text.size() : newline + 1;
+        size_t end = newline == string::npos ? text.size() : newline;
+        if (end > pos && text[end - 1] == '\r') end--;
+        string line = text.substr(pos, end - pos);
+        pos = next;
+        lineNumber++;
+
+        tokenize(line, tokens);
+        string first = tokens.empty() ? string() : upper(tokens[0]);
+
+        if (mode == Topology) {
+            if (first == "END") mode = Preamble;
+            continue;
+        }
+        if (first == "READ" && tokens.size() > 1) {
+            string what = upper(tokens[1]);
+            if (what.compare(0, 3, "RTF") == 0) {
+                mode = Topology;
+                continue;
+            }
+        }
+        if (mode == Trailer || first == "END" || first == "RETURN") {
+            mode = Trailer;
+            trailer.push_back(line);
+            continue;
+        }
+        if (header) {
+            blocks.back().header.push_back(line);
+            header = continues(line);
+            continue;
+        }
+
+        int section = headerSection(tokens);
+        if (section >= 0) {
+            Block block;
+            block.section = (ParameterSection)section;
+            block.header.push_back(line);
+            blocks.push_back(block);
+            header = continues(line);
+            mode = Sections;
+            continue;
+        }
+        if (mode != Sections) {
+            preamble.push_back(line);
+            continue;
+        }
+
+        Block& block = blocks.back();
+        Item item;
+        item.entry = -1;
+        ParameterEntry entry;
+        if (parameterArity(block.section) == 0 || tokens.empty() || first[0] == '*') {
+            item.text = line;
+        } else if (!parseEntry(block.section, line, lineNumber, entry)) {
+            item.text = line;       // kept as written
+        } else if (addEntry(entry, true)) {
+            item.entry = (int)entries.size() - 1;
+        } else {
+            droppedDuplicates++;
+            continue;
+        }
+        block.items.push_back(item);
+    }
+    return problemList.empty();
+}
+
+bool ParameterStore::parseEntry(ParameterSection section, const string& line, size_t lineNumber,
+                                ParameterEntry& entry) {
+    vector<string> tokens;
+    tokenize(line, tokens);
+    size_t arity = (size_t)parameterArity(section);
+    size_t extra = hasMultiplicity(section) ? 1 : 0;
+
+    ostringstream where;
+    where << "line " << lineNumber << ": " << parameterSectionName(section) << " entry ";
+    if (tokens.size() < arity + minimumValues(section) + extra) {
+        problemList.push_back(where.str() + "has too few fields: " + line);
+        return false;
+    }
+
+    entry.section = section;
+    entry.types.assign(tokens.begin(), tokens.begin() + arity);
+    entry.multiplicity = 0;
+    entry.values.clear();
+    entry.text = line;
+    for (size_t i = arity; i < tokens.size(); ++i) {
+        double value;
+        if (!toNumber(tokens[i], value)) {
+            problemList.push_back(where.str() + "has a non-numeric field: " + line);
+            return false;
+        }
+        // kchi n delta, kpsi n psi0
+        if (extra && i == arity + 1) entry.multiplicity = (int)value;
+        else entry.values.push_back(value);
+    }
+    return true;
+}
+
+bool ParameterStore::addEntry(const ParameterEntry& entry, bool reportConflict) {
+    vector<unsigned>& list = index[canonicalKey(entry.section, entry.types)];
+    bool conflict = false;
+    for (size_t i = 0; i < list.size(); ++i) {
+        const ParameterEntry& existing = entries[list[i]];
+        if (existing.multiplicity != entry.multiplicity) continue;
+        if (existing.sameValues(entry)) return false;
+        if (reportConflict) {
+            conflictList.push_back(describe(entry) + ": " + valueList(entry) + " after " + valueList(existing));
+        }
+        conflict = true;
+    }
+    // A conflicting line stays in the file, but lookups see the first definition
+    entries.push_back(entry);
+    if (!conflict) {
+        list.push_back((unsigned)entries.size() - 1);
+        counts[entry.section]++;
+    }
+    return true;
+}
+
+ParameterStore::Block& ParameterStore::blockFor(ParameterSection section) {
+    size_t i = 0;
+    for (; i < blocks.size(); ++i) {
+        if (blocks[i].section == section) return blocks[i];
+        if (blocks[i].section > section) break;
+    }
+    // A new section goes where CHARMM orders it
+    Block block;
+    block.section = section;
+    block.header.push_back(parameterSectionName(section));
+    Item blank;
+    blank.entry = -1;
+    block.items.push_back(blank);
+    blocks.insert(blocks.begin() + i, block);
+    return blocks[i];
+}
+
+const vector<unsigned>* ParameterStore::terms(ParameterSection section, const vector<string>& types) const {
+    unordered_map<string, vector<unsigned> >::const_iterator it = index.find(canonicalKey(section, types));
+    return it == index.end() || it->second.empty() ? NULL : &it->second;
+}
+
+const ParameterEntry* ParameterStore::find(ParameterSection section, const vector<string>& types,
+                                           int multiplicity) const {
+    const vector<unsigned>* list = terms(section, types);
+    if (!list) return NULL;
+    for (size_t i = 0; i < list->size(); ++i) {
+        const ParameterEntry& entry = entries[(*list)[i]];
+        if (!hasMultiplicity(section) || entry.multiplicity == multiplicity) return &entry;
+    }
+    return NULL;
+}
+
+bool ParameterStore::lookup(ParameterSection section, const vector<string>& types,
+                            vector<const ParameterEntry*>& found) const {
+    found.clear();
+    if ((int)types.size() != parameterArity(section) || types.empty()) return false;
+
+    // Wildcard patterns are not symmetric under reversal (X B C D read
+    // backwards is D C B X), so each is built from both orientations
+    vector<vector<string> > candidates(1, types);
+    vector<string> reversed(types.rbegin(), types.rend());
+    const string x = "X";
+    if (section == ParamDihedrals) {
+        string wild[] = {x, types[1], types[2], x};
+        candidates.push_back(vector<string>(wild, wild + 4));
+    } else if (section == ParamImpropers) {
+        const vector<string>* orientations[] = {&types, &reversed};
+        for (int pattern = 0; pattern < 3; ++pattern) {
+            for (int o = 0; o < 2; ++o) {
+                const vector<string>& t = *orientations[o];
+                string first[] = {t[0], x, x, t[3]};
+                string second[] = {x, t[1], t[2], t[3]};
+                string third[] = {x, x, t[2], t[3]};
+                string* wild = pattern == 0 ? first : pattern == 1 ? second : third;
+                candidates.push_back(vector<string>(wild, wild + 4));
+            }
+        }
+    }
+
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        const vector<unsigned>* list = terms(section, candidates[c]);
+        if (!list) continue;
+        for (size_t i = 0; i < list->size(); ++i) found.push_back(&entries[(*list)[i]]);
+        return true;
+    }
+    return false;
+}
+
+void ParameterStore::merge(const ParameterStore& source, const ParameterMergeOptions& options,
+                           ParameterMergeReport& report) {
+    set<string> protein(options.proteinTypes.begin(), options.proteinTypes.end());
+    vector<vector<unsigned> > added(ParamSectionCount);
+
+    // A dihedral or improper is the sum of its terms, so those are merged
+    // per tuple: all of source's multiplicities or none of them
+    set<string> mergedTuples;
+
+    for (size_t e = 0; e < source.entries.size(); ++e) {
+        const ParameterEntry& entry = source.entries[e];
+        bool proteinOnly = true;
+        for (size_t t = 0; t < entry.types.size() && proteinOnly; ++t) proteinOnly = protein.count(entry.types[t]) > 0;
+        if (proteinOnly) {
+            report.skipped++;
+            continue;
+        }
+
+        if (hasMultiplicity(entry.section)) {
+            string key = canonicalKey(entry.section, entry.types);
+            if (!mergedTuples.insert(key).second) continue;
+            const vector<unsigned>* sourceList = source.terms(entry.section, entry.types);
+            vector<const ParameterEntry*> incoming;
+            for (size_t i = 0; sourceList && i < sourceList->size(); ++i) {
+                incoming.push_back(&source.entries[(*sourceList)[i]]);
+            }
+            const vector<unsigned>* list = terms(entry.section, entry.types);
+            if (list) {
+                vector<const ParameterEntry*> present;
+                for (size_t i = 0; i < list->size(); ++i) present.push_back(&entries[(*list)[i]]);
+                if (sameTerms(present, incoming)) {
+                    report.duplicates += (int)incoming.size();
+                } else {
+                    string tuple = describe(entry);
+                    tuple.erase(tuple.rfind(" n="));
+                    report.conflicts.push_back(tuple + ": keeping " + termList(present) + ", not adding " +
+                                               termList(incoming));
+                }
+                continue;
+            }
+            for (size_t i = 0; i < incoming.size(); ++i) {
+                addEntry(*incoming[i], false);
+                added[entry.section].push_back((unsigned)entries.size() - 1);
+                report.added++;
+            }
+            continue;
+        }
+
+        const ParameterEntry* existing = find(entry.section, entry.types);
+        if (existing) {
+            if (existing->sameValues(entry)) {
+                report.duplicates++;
+            } else {
+                report.conflicts.push_back(describe(entry) + ": keeping " + valueList(*existing) + ", not adding " +
+                                           valueList(entry));
+            }
+            continue;
+        }
+        addEntry(entry, false);
+        added[entry.section].push_back((unsigned)entries.size() - 1);
+        report.added++;
+    }
+
+    for (int s = 0; s < ParamSectionCount; ++s) {
+        if (added[s].empty()) continue;
+        ParameterSection section = (ParameterSection)s;
+        vector<Item>& items = blockFor(section).items;
+
+        // After the section's last line, ahead of the blank lines that end it
+        size_t at = items.size();
+        while (at > 0 && items[at - 1].entry < 0 && items[at - 1].text.find_first_not_of(" \t") == string::npos) at--;
+
+        vector<Item> block;
+        Item text;
+        text.entry = -1;
+        block.push_back(text);
+        text.text = "! === " + options.label + " cross-force-field " + parameterSectionName(section) + " ===";
+        block.push_back(text);
+        for (size_t i = 0; i < added[s].size(); ++i) {
+            Item item;
+            item.entry = (int)added[s][i];
+            block.push_back(item);
+        }
+        items.insert(items.begin() + at, block.begin(), block.end());
+    }
+}
+
+size_t ParameterStore::size(ParameterSection section) const {
+    return section < ParamSectionCount ? counts[section] : 0;
+}
+
+void ParameterStore::write(ostream& out) const {
+    for (size_t i = 0; i < preamble.size(); ++i) out << preamble[i] << "\n";
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const Block& block = blocks[b];
+        for (size_t i = 0; i < block.header.size(); ++i) out << block.header[i] << "\n";
+        for (size_t i = 0; i < block.items.size(); ++i) {
+            const Item& item = block.items[i];
+            out << (item.entry >= 0 ? entries[item.entry].text : item.text) << "\n";
+        }
+    }
+    for (size_t i = 0; i < trailer.size(); ++i) out << trailer[i] << "\n";
+}
+
+bool ParameterStore::save(const string& filename) const {
+    string tempName = filename + ".tmp";
+    {
+        ofstream out(tempName.c_str(), ios::out | ios::binary);
+        if (!out) {
+            LOG_ERROR("Could not write " << tempName);
+            return false;
+        }
+        write(out);
+        if (!out) {
+            LOG_ERROR("Could not write " << tempName);
+            return false;
+        }
+    }
+    if (rename(tempName.c_str(), filename.c_str()) != 0) {
+        LOG_ERROR("Renaming " << tempName << " to " << filename << " failed.");
+        return false;
+    }
+    return true;
+}
+
+bool mergeStreamParameters(const string& strFile, const string& prmFile, const ParameterMergeOptions& options,
+                           ParameterMergeReport& report) {
+    ParameterStore parameters, stream;
+    if (!parameters.load(prmFile) || !stream.load(strFile)) return false;
+    if (parameters.size(ParamBonds) == 0 && parameters.size(ParamAngles) == 0) {
+        LOG_ERROR("No parameters read from " << prmFile);
+        return false;
+    }
+
+    parameters.merge(stream, options, report);
+    for (size_t i = 0; i < report.conflicts.size(); ++i) LOG_WARN(strFile << ": " << report.conflicts[i]);
+    LOG_INFO(strFile << ": " << report.added << " parameters added to " << prmFile << ", " << report.duplicates
+                     << " already present, " << report.skipped << " protein-only skipped");
+    return parameters.save(prmFile);
+}
@@ -0,0 +1,144 @@
+// ParameterStore.h
+#ifndef PARAMETERSTORE_H
+#define PARAMETERSTORE_H
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// CHARMM parameter file (par_GUI.prm) or the parameter section of a CGenFF
+// stream file, with every BONDS/ANGLES/DIHEDRALS/IMPROPERS/NONBONDED/NBFIX
+// entry hashed by its canonical type tuple:
+//
+//   bonds, angles, dihedrals, impropers, NBFIX pairs
+//                  the tuple or its reverse, whichever sorts first
+//   dihedrals, impropers
+//                  several lines per tuple, one per multiplicity
+//
+// Lines are kept in file order and written back as read. An entry is
+// dropped as a duplicate when an earlier one has the same types (either
+// direction), multiplicity and values to a relative 1e-6; the "!" comments
+// are not compared, so a duplicate whose comment differs goes too. ATOMS,
+// CMAP and HBOND sections are carried through unchanged.
+
+enum ParameterSection {
+    ParamAtoms,
+    ParamBonds,
+    ParamAngles,
+    ParamDihedrals,
+    ParamImpropers,
+    ParamCmap,
+    ParamNonbonded,
+    ParamNbfix,
+    ParamHbond,
+    ParamSectionCount
+};
+
+const char* parameterSectionName(ParameterSection section);
+// Atom types per entry, 0 for sections kept as text
+int parameterArity(ParameterSection section);
+
+struct ParameterEntry {
+    ParameterSection section;
+    std::vector<std::string> types;
+    int multiplicity;               // dihedrals and impropers, else 0
+    std::vector<double> values;     // the numbers after the types, without the multiplicity
+    std::string text;               // the whole line, without its newline
+
+    // Same multiplicity and values, to a relative 1e-6; text is not compared
+    bool sameValues(const ParameterEntry& other) const;
+};
+
+struct ParameterMergeOptions {
+    std::string label;                      // in the comment above the merged entries
+    std::vector<std::string> proteinTypes;  // entries using only these are already in CHARMM36
+
+    // "naa": novel amino acid (nad.str); "npc": N-terminal conjugate (ntrm_clean.str)
+    static bool defaults(const std::string& kind, ParameterMergeOptions& options);
+};
+
+struct ParameterMergeReport {
+    int added;
+    int duplicates;                 // already present with the same values
+    int skipped;                    // protein-side only
+    std::vector<std::string> conflicts;     // present with other values; the existing entry (or tuple) is kept
+
+    ParameterMergeReport() : added(0), duplicates(0), skipped(0) {}
+};
+
+class ParameterStore {
+public:
+    ParameterStore();
+
+    // False only if the file cannot be read; malformed entries are logged
+    // as warnings, kept in problems() and written back unchanged
+    bool load(const std::string& filename);
+    // A stream file's "read rtf" part is skipped; from "read param" on, or
+    // the whole text for a plain parameter file, is read. False if any
+    // entry was malformed.
+    bool parse(const std::string& text);
+    void clear();
+
+    // The entry for exactly these types (either direction), or NULL
+    const ParameterEntry* find(ParameterSection section, const std::vector<std::string>& types,
+                               int multiplicity = 0) const;
+    // Every term of the most specific matching tuple, with CHARMM's X
+    // wildcards: dihedrals X B C X; impropers A X X D, X B C D, X X C D,
+    // each tried for the tuple as given and reversed.
+    // False if nothing matches.
+    bool lookup(ParameterSection section, const std::vector<std::string>& types,
+                std::vector<const ParameterEntry*>& terms) const;
+
+    // Entries of source not already here, appended at the end of their
+    // section under a "! === <label> cross-force-field <SECTION> ===" line.
+    // Dihedrals and impropers go by tuple: a tuple already here with any
+    // other set of multiplicities or values is a conflict and none of
+    // source's terms for it are added.
+    void merge(const ParameterStore& source, const ParameterMergeOptions& options, ParameterMergeReport& report);
+
+    size_t size(ParameterSection section) const;
+    int duplicatesDropped() const { return droppedDuplicates; }
+    const std::vector<std::string>& conflicts() const { return conflictList; }
+    const std::vector<std::string>& problems() const { return problemList; }
+
+    void write(std::ostream& out) const;
+    // Written to a temporary file first, then renamed over filename
+    bool save(const std::string& filename) const;
+
+private:
+    // A line of a section: an entry, or text (comments, blank lines, CMAP data)
+    struct Item {
+        int entry;                  // into entries, -1 for text
+        std::string text;
+    };
+
+    struct Block {
+        ParameterSection section;
+        std::vector<std::string> header;    // the section line and its "-" continuations
+        std::vector<Item> items;
+    };
+
+    bool parseEntry(ParameterSection section, const std::string& line, size_t lineNumber, ParameterEntry& entry);
+    // Index entry unless it duplicates one already indexed; false if dropped
+    bool addEntry(const ParameterEntry& entry, bool reportConflict);
+    Block& blockFor(ParameterSection section);
+    const std::vector<unsigned>* terms(ParameterSection section, const std::vector<std::string>& types) const;
+
+    std::vector<std::string> preamble;      // before the first section
+    std::vector<Block> blocks;
+    std::vector<std::string> trailer;       // END and anything after it
+    std::vector<ParameterEntry> entries;
+    std::unordered_map<std::string, std::vector<unsigned> > index;  // section + canonical tuple
+    size_t counts[ParamSectionCount];
+    int droppedDuplicates;
+    std::vector<std::string> conflictList;
+    std::vector<std::string> problemList;
+};
+
+// Merge the parameters of strFile into prmFile and rewrite it; used by the
+// GUI and the merge_params tool
+bool mergeStreamParameters(const std::string& strFile, const std::string& prmFile,
+                           const ParameterMergeOptions& options, ParameterMergeReport& report);
+
+#endif // PARAMETERSTORE_H
@@ -0,0 +1,199 @@
+// PdbReader.cpp
+#include "PdbReader.h"
+#include "Logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// Chunk size for streaming files
+static const size_t chunkSize = 1 << 16;
+
+void PdbAtoms::clear() {
+    names.clear();
+    residueNames.clear();
+    residueNumbers.clear();
+    elements.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+void PdbAtoms::reserve(size_t n) {
+    names.reserve(4 * n);
+    residueNames.reserve(4 * n);
+    residueNumbers.reserve(n);
+    elements.reserve(2 * n);
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+}
+
+static string fixedField(const vector<char>& chars, size_t width, size_t i) {
+    const char* p = &chars[width * i];
+    size_t n = 0;
+    while (n < width && p[n] != '\0') n++;
+    return string(p, n);
+}
+
+string PdbAtoms::name(size_t i) const { return fixedField(names, 4, i); }
+string PdbAtoms::residueName(size_t i) const { return fixedField(residueNames, 4, i); }
+string PdbAtoms::element(size_t i) const { return fixedField(elements, 2, i); }
+
+// Append columns [begin, end) of the line, trimmed and '\0'-padded to width
+static void appendTrimmed(const char* line, size_t length, size_t begin, size_t end, size_t width,
+                          vector<char>& out) {
+    if (end > length) end = length;
+    while (begin < end && line[begin] == ' ') begin++;
+    while (end > begin && line[end - 1] == ' ') end--;
+    size_t n = end - begin;
+    for (size_t k = 0; k < width; ++k) out.push_back(k < n ? line[begin + k] : '\0');
+}
+
+// Decimal number in columns [begin, end), e.g. "  -12.345". Plain fixed-point
+// fields with up to 15 digits are converted as one exact integer divided by
+// an exact power of ten, which rounds the same as strtod; anything else goes
+// through strtod.
+static bool parseCoordinate(const char* line, size_t begin, size_t end, double& value) {
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                         1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    while (begin < end && line[begin] == ' ') begin++;
+    while (end > begin && line[end - 1] == ' ') end--;
+    if (begin == end) return false;
+
+    size_t p = begin;
+    bool negative = false;
+    if (line[p] == '-' || line[p] == '+') negative = (line[p++] == '-');
+    double mantissa = 0.0;
+    int digits = 0, decimals = 0;
+    while (p < end && line[p] >= '0' && line[p] <= '9') {
+        mantissa = mantissa * 10.0 + (line[p++] - '0');
+        digits++;
+    }
+    if (p < end && line[p] == '.') {
+        p++;
+        while (p < end && line[p] >= '0' && line[p] <= '9') {
+            mantissa = mantissa * 10.0 + (line[p++] - '0');
+            digits++;
+            decimals++;
+        }
+    }
+    if (p == end && digits > 0 && digits <= 15) {
+        value = mantissa / powersOfTen[decimals];
+        if (negative) value = -value;
+        return true;
+    }
+
+    // Exponents and other unusual spellings
+    char field[32];
+    size_t n = end - begin;
+    if (n >= sizeof(field)) return false;
+    memcpy(field, line + begin, n);
+    field[n] = '\0';
+    char* stop = NULL;
+    value = strtod(field, &stop);
+    return stop == field + n;
+}
+
+static int parseInteger(const char* line, size_t length, size_t begin, size_t end) {
+    if (end > length) end = length;
+    while (begin < end && line[begin] == ' ') begin++;
+    bool negative = false;
+    if (begin < end && line[begin] == '-') {
+        negative = true;
+        begin++;
+    }
+    int value = 0;
+    while (begin < end && line[begin] >= '0' && line[begin] <= '9') value = value * 10 + (line[begin++] - '0');
+    return negative ? -value : value;
+}
+
+// One line; false on a malformed ATOM/HETATM record
+static bool parseLine(const char* line, size_t length, size_t lineNumber, PdbAtoms& atoms) {
+    if (length > 0 && line[length - 1] == '\r') length--;
+    bool atom = length >= 4 && memcmp(line, "ATOM", 4) == 0;
+    bool hetatm = length >= 6 && memcmp(line, "HETATM", 6) == 0;
+    if (!atom && !hetatm) return true;
+
+    if (length < 54) {
+        LOG_ERROR("PDB line " << lineNumber << " is truncated: an atom record needs columns 1-54, this one has "
+                  << length);
+        return false;
+    }
+    double coords[3];
+    for (int k = 0; k < 3; ++k) {
+        if (!parseCoordinate(line, 30 + 8 * k, 38 + 8 * k, coords[k])) {
+            LOG_ERROR("PDB line " << lineNumber << " has an unreadable " << (char)('x' + k) << " coordinate");
+            return false;
+        }
+    }
+
+    appendTrimmed(line, length, 12, 16, 4, atoms.names);
+    appendTrimmed(line, length, 17, 21, 4, atoms.residueNames);
+    atoms.residueNumbers.push_back(parseInteger(line, length, 22, 26));
+    appendTrimmed(line, length, 76, 78, 2, atoms.elements);
+    atoms.x.push_back(coords[0]);
+    atoms.y.push_back(coords[1]);
+    atoms.z.push_back(coords[2]);
+    return true;
+}
+
+// Parse the complete lines of [data, data + size); returns the bytes used
+static size_t parseLines(const char* data, size_t size, bool final, size_t& lineNumber, PdbAtoms& atoms,
+                         bool& ok) {
+    size_t start = 0;
+    while (start < size) {
+        const char* newline = (const char*)memchr(data + start, '\n', size - start);
+        if (!newline && !final) break;
+        size_t end = newline ? (size_t)(newline - data) : size;
+        lineNumber++;
+        if (!parseLine(data + start, end - start, lineNumber, atoms)) {
+            ok = false;
+            return size;
+        }
+        start = newline ? end + 1 : size;
+    }
+    return start;
+}
+
+bool readPdbAtoms(const char* data, size_t size, PdbAtoms& atoms) {
+    atoms.clear();
+    size_t lineNumber = 0;
+    bool ok = true;
+    parseLines(data, size, true, lineNumber, atoms, ok);
+    return ok;
+}
+
+bool readPdbAtoms(const string& text, PdbAtoms& atoms) {
+    return readPdbAtoms(text.data(), text.size(), atoms);
+}
+
+bool readPdbFile(const string& filename, PdbAtoms& atoms) {
+    atoms.clear();
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        LOG_ERROR("Could not open " << filename);
+        return false;
+    }
+
+    // A partial last line is carried to the front of the buffer
+    vector<char> buffer(chunkSize);
+    size_t held = 0, lineNumber = 0;
+    bool ok = true;
+    while (ok) {
+        if (held == buffer.size()) buffer.resize(2 * buffer.size());   // a line longer than the buffer
+        size_t n = fread(&buffer[held], 1, buffer.size() - held, file);
+        bool final = (n == 0);
+        size_t used = parseLines(&buffer[0], held + n, final, lineNumber, atoms, ok);
+        if (final) break;
+        held = held + n - used;
+        memmove(&buffer[0], &buffer[used], held);
+    }
+    if (ferror(file)) {
+        LOG_ERROR("Reading " << filename << " failed");
+        ok = false;
+    }
+    fclose(file);
+    return ok;
+}
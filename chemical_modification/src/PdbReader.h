@@ -0,0 +1,43 @@
+// PdbReader.h
+#ifndef PDBREADER_H
+#define PDBREADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Streaming fixed-column reader for the ATOM/HETATM records of a PDB file.
+// Records are parsed in place from a reused chunk buffer (no per-line
+// strings) into structure-of-arrays storage that grows with the file, so
+// there is no atom limit. A record that is too short or has an unreadable
+// coordinate is an error, reported with its line number; nothing is
+// dropped silently.
+
+// ── Data structures ──────────────────────────────────────────────────────────
+
+struct PdbAtoms {
+    std::vector<char> names;            // 4 characters per atom, trimmed, '\0'-padded
+    std::vector<char> residueNames;     // 4 characters per atom (columns 18-21), trimmed
+    std::vector<int> residueNumbers;    // columns 23-26
+    std::vector<char> elements;         // 2 characters per atom (columns 77-78), trimmed
+    std::vector<double> x, y, z;
+
+    size_t size() const { return x.size(); }
+    void clear();
+    void reserve(size_t n);
+
+    std::string name(size_t i) const;
+    std::string residueName(size_t i) const;
+    std::string element(size_t i) const;
+};
+
+// ── Reading ──────────────────────────────────────────────────────────────────
+
+// Parse a whole in-memory PDB text
+bool readPdbAtoms(const char* data, size_t size, PdbAtoms& atoms);
+bool readPdbAtoms(const std::string& text, PdbAtoms& atoms);
+
+// Stream a PDB file in fixed-size chunks
+bool readPdbFile(const std::string& filename, PdbAtoms& atoms);
+
+#endif // PDBREADER_H
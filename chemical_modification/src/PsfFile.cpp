@@ -0,0 +1,663 @@
+// PsfFile.cpp
+#include "PsfFile.h"
+#include "CharmmStream.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+// ── Reading helpers ──────────────────────────────────────────────────────────
+
+// isspace() without the locale lookup, for the per-character loops
+static inline bool blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+struct PsfCursor {
+    const char* p;
+    const char* end;
+    size_t line;
+
+    // The next line without its newline; false at the end of the buffer
+    bool nextLine(const char*& begin, const char*& stop) {
+        if (p >= end) return false;
+        begin = p;
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        stop = newline ? newline : end;
+        p = newline ? newline + 1 : end;
+        if (stop > begin && stop[-1] == '\r') stop--;
+        line++;
+        return true;
+    }
+
+    // n whitespace-separated non-negative integers, whatever the line layout
+    bool readIntegers(size_t n, vector<uint32_t>& out) {
+        out.resize(n);
+        if (n == 0) return true;
+        for (size_t i = 0; i < n; ++i) {
+            while (p < end && blank(*p)) {
+                if (*p == '\n') line++;
+                p++;
+            }
+            uint64_t value = 0;
+            const char* digits = p;
+            while (p < end && *p >= '0' && *p <= '9' && value <= 0xFFFFFFFFu) value = value * 10 + (uint64_t)(*p++ - '0');
+            if (p == digits || value >= 0xFFFFFFFFu) return false;
+            out[i] = (uint32_t)value;
+        }
+        return true;
+    }
+};
+
+// 1-based atom numbers to 0-based indices; 0 becomes noAtom where allowed
+static bool toAtomIndices(vector<uint32_t>& values, size_t atoms, bool allowZero) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint32_t value = values[i];
+        if (value == 0 && allowZero) {
+            values[i] = PsfFile::noAtom;
+        } else if (value == 0 || value > atoms) {
+            return false;
+        } else {
+            values[i] = value - 1;
+        }
+    }
+    return true;
+}
+
+// A plain decimal such as -0.270000 or 12.0110: the digits as an integer,
+// divided by a power of ten. Both are exact below 10^15, so the one
+// rounding of the division gives what strtod gives. Anything else goes to
+// strtod.
+static double parseDecimal(const char* p, const char* end) {
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    const char* start = p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    uint64_t digits = 0;
+    int count = 0, decimals = -1;
+    for (; p < end; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            digits = digits * 10 + (uint64_t)(*p - '0');
+            count++;
+            if (decimals >= 0) decimals++;
+        } else if (*p == '.' && decimals < 0) {
+            decimals = 0;
+        } else {
+            break;
+        }
+    }
+    if (count == 0 || count > 15 || (p < end && !blank(*p))) return strtod(start, NULL);
+    double value = (double)digits / powers[decimals > 0 ? decimals : 0];
+    return negative ? -value : value;
+}
+
+struct Field {
+    const char* data;
+    size_t size;
+};
+
+static size_t splitFields(const char* p, const char* end, Field* fields, size_t maxFields) {
+    size_t n = 0;
+    while (p < end && n < maxFields) {
+        while (p < end && blank(*p)) p++;
+        const char* begin = p;
+        while (p < end && !blank(*p)) p++;
+        if (p > begin) {
+            fields[n].data = begin;
+            fields[n].size = (size_t)(p - begin);
+            n++;
+        }
+    }
+    return n;
+}
+
+// Section header "  <count> [<second>] !<NAME>..."; false for any other line
+static bool sectionHeader(const char* begin, const char* stop, long& count, long& second, string& name) {
+    const char* bang = (const char*)memchr(begin, '!', stop - begin);
+    if (!bang) return false;
+    char* after = NULL;
+    count = strtol(begin, &after, 10);
+    if (after == begin || after > bang) return false;
+    char* next = NULL;
+    second = strtol(after, &next, 10);
+    if (next == after || next > bang) second = 0;
+    const char* n = bang + 1;
+    const char* e = n;
+    while (e < stop && (isalnum((unsigned char)*e))) e++;
+    name.assign(n, e - n);
+    return !name.empty();
+}
+
+// ── Writing helpers ──────────────────────────────────────────────────────────
+
+// CHARMM's Fortran E format for the CHEQ hardness column, as psfgen
+// copies it: -0.301140E-02 (mantissa in [0.1, 1), six digits)
+static void formatFortranE(double value, char* out, size_t size) {
+    double magnitude = fabs(value);
+    long long digits = 0;
+    int exponent = 0;
+    if (magnitude > 0.0) {
+        exponent = (int)floor(log10(magnitude)) + 1;
+        digits = llround(magnitude / pow(10.0, exponent) * 1e6);
+        // log10 can land one decade off near powers of ten
+        if (digits < 100000) digits = llround(magnitude / pow(10.0, --exponent) * 1e6);
+        if (digits >= 1000000) {
+            digits = 100000;
+            exponent++;
+        }
+    }
+    snprintf(out, size, "%s0.%06lldE%c%02d", value < 0.0 ? "-" : "", digits, exponent < 0 ? '-' : '+', abs(exponent));
+}
+
+// Formatted lines collected in a buffer and written in large blocks
+class PsfWriter {
+public:
+    PsfWriter(ostream& stream, bool wide) : out(stream), ext(wide) { buffer.reserve(chunk + 256); }
+    ~PsfWriter() { flush(); }
+
+    void append(const char* text, size_t size) {
+        buffer.append(text, size);
+        if (buffer.size() >= chunk) flush();
+    }
+    void text(const string& line) { append(line.data(), line.size()); }
+    void newline() { append("\n", 1); }
+
+    void header(size_t count, const char* name) {
+        char line[64];
+        int n = snprintf(line, sizeof(line), ext ? "%10zu !%s\n" : "%8zu !%s\n", count, name);
+        append(line, (size_t)n);
+    }
+
+    // value right-aligned in width columns (I8 or I10), without snprintf
+    void integer(uint64_t value, size_t width) {
+        char digits[24];
+        size_t n = 0;
+        do {
+            digits[n++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value);
+        for (size_t i = n; i < width; ++i) buffer += ' ';
+        while (n) buffer += digits[--n];
+    }
+
+    // text left-aligned in width columns, one space after it
+    void name(const string& text, size_t width) {
+        buffer += text;
+        for (size_t i = text.size(); i < width; ++i) buffer += ' ';
+        buffer += ' ';
+    }
+
+    // perLine numbers per line, then a blank line; atom indices are
+    // written 1-based, noAtom as 0
+    void numbers(const vector<uint32_t>& values, size_t perLine, bool atoms) {
+        const size_t width = ext ? 10 : 8;
+        for (size_t i = 0; i < values.size(); ++i) {
+            uint32_t value = values[i];
+            if (atoms) value = value == PsfFile::noAtom ? 0 : value + 1;
+            integer(value, width);
+            if ((i + 1) % perLine == 0) newline();
+        }
+        if (values.size() % perLine != 0) newline();
+        newline();
+    }
+
+    void flush() {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+private:
+    static const size_t chunk = 1 << 20;
+    ostream& out;
+    bool ext;
+    string buffer;
+};
+
+// ── PsfFile ──────────────────────────────────────────────────────────────────
+
+PsfFile::PsfFile() : ext(false), molnt(false) {
+}
+
+void PsfFile::clear() {
+    ext = false;
+    molnt = false;
+    flags.clear();
+    title.clear();
+    segids.clear();
+    resids.clear();
+    resnames.clear();
+    names.clear();
+    types.clear();
+    charges.clear();
+    masses.clear();
+    moves.clear();
+    electronegativities.clear();
+    hardnesses.clear();
+    bonds.clear();
+    angles.clear();
+    dihedrals.clear();
+    impropers.clear();
+    crossterms.clear();
+    donors.clear();
+    acceptors.clear();
+    exclusions.clear();
+    exclusionEnds.clear();
+    groups.clear();
+    molecules.clear();
+    strings.clear();
+    stringIds.clear();
+}
+
+uint32_t PsfFile::intern(const char* data, size_t size) {
+    string s(data, size);
+    unordered_map<string, uint32_t>::const_iterator it = stringIds.find(s);
+    if (it != stringIds.end()) return it->second;
+    uint32_t id = (uint32_t)strings.size();
+    strings.push_back(s);
+    stringIds[s] = id;
+    return id;
+}
+
+bool PsfFile::load(const string& filename) {
+    CharmmStream file;
+    if (!file.map(filename)) return false;
+    if (!parse(file.data(), file.size())) {
+        LOG_ERROR("Reading " << filename << " failed.");
+        return false;
+    }
+    LOG_DEBUG(filename << ": " << atomCount() << " atoms, " << bondCount() << " bonds, " << angleCount()
+              << " angles, " << dihedralCount() << " dihedrals, " << improperCount() << " impropers, "
+              << crosstermCount() << " cross-terms");
+    return true;
+}
+
+bool PsfFile::parse(const char* data, size_t size) {
+    clear();
+    PsfCursor cursor = {data, data + size, 0};
+    const char* begin;
+    const char* stop;
+
+    Field fields[11];
+    size_t words = 0;
+    if (!cursor.nextLine(begin, stop) || (words = splitFields(begin, stop, fields, 11)) == 0 ||
+        fields[0].size != 3 || strncmp(fields[0].data, "PSF", 3) != 0) {
+        LOG_ERROR("Not a PSF file: the first line does not start with PSF");
+        return false;
+    }
+    for (size_t i = 1; i < words; ++i) {
+        string flag(fields[i].data, fields[i].size);
+        if (flag == "EXT") {
+            ext = true;
+        } else if (flag == "DRUDE") {
+            LOG_ERROR("Drude PSF files are not supported");
+            return false;
+        } else {
+            flags.push_back(flag);
+        }
+    }
+    const bool cheq = find(flags.begin(), flags.end(), "CHEQ") != flags.end();
+
+    long count, second;
+    string section;
+    while (cursor.nextLine(begin, stop)) {
+        if (!sectionHeader(begin, stop, count, second, section)) continue;
+        if (count < 0 || second < 0) {
+            LOG_ERROR("PSF line " << cursor.line << ": negative count for " << section);
+            return false;
+        }
+
+        if (section == "NTITLE") {
+            for (long i = 0; i < count && cursor.nextLine(begin, stop); ++i) title.push_back(string(begin, stop));
+        } else if (section == "NATOM") {
+            segids.reserve(count);
+            resids.reserve(count);
+            resnames.reserve(count);
+            names.reserve(count);
+            types.reserve(count);
+            charges.reserve(count);
+            masses.reserve(count);
+            moves.reserve(count);
+            if (cheq) {
+                electronegativities.reserve(count);
+                hardnesses.reserve(count);
+            }
+            for (long i = 0; i < count; ++i) {
+                size_t n = 0;
+                if (!cursor.nextLine(begin, stop) || (n = splitFields(begin, stop, fields, 11)) < (cheq ? 11u : 8u)) {
+                    LOG_ERROR("PSF line " << cursor.line << ": malformed atom record");
+                    return false;
+                }
+                // Consecutive atoms mostly share their segment and residue
+                size_t last = segids.size();
+                bool same = last > 0;
+                for (int f = 1; f <= 3 && same; ++f) {
+                    const vector<uint32_t>& ids = f == 1 ? segids : f == 2 ? resids : resnames;
+                    const string& previous = strings[ids[last - 1]];
+                    same = previous.size() == fields[f].size && memcmp(previous.data(), fields[f].data, fields[f].size) == 0;
+                }
+                if (same) {
+                    segids.push_back(segids[last - 1]);
+                    resids.push_back(resids[last - 1]);
+                    resnames.push_back(resnames[last - 1]);
+                } else {
+                    segids.push_back(intern(fields[1].data, fields[1].size));
+                    resids.push_back(intern(fields[2].data, fields[2].size));
+                    resnames.push_back(intern(fields[3].data, fields[3].size));
+                }
+                names.push_back(intern(fields[4].data, fields[4].size));
+                types.push_back(intern(fields[5].data, fields[5].size));
+                charges.push_back(parseDecimal(fields[6].data, fields[6].data + fields[6].size));
+                masses.push_back(parseDecimal(fields[7].data, fields[7].data + fields[7].size));
+                moves.push_back(n > 8 ? atoi(string(fields[8].data, fields[8].size).c_str()) : 0);
+                if (cheq) {
+                    electronegativities.push_back(parseDecimal(fields[9].data, fields[9].data + fields[9].size));
+                    hardnesses.push_back(parseDecimal(fields[10].data, fields[10].data + fields[10].size));
+                }
+            }
+        } else if (section == "NNB") {
+            if (!cursor.readIntegers((size_t)count, exclusions) || !toAtomIndices(exclusions, atomCount(), false) ||
+                !cursor.readIntegers(atomCount(), exclusionEnds)) {
+                LOG_ERROR("PSF line " << cursor.line << ": bad atom index in NNB");
+                return false;
+            }
+            for (size_t i = 0; i < exclusionEnds.size(); ++i) {
+                if (exclusionEnds[i] > exclusions.size() || (i > 0 && exclusionEnds[i] < exclusionEnds[i - 1])) {
+                    LOG_ERROR("PSF line " << cursor.line << ": NNB pointers out of order");
+                    return false;
+                }
+            }
+        } else if (section == "NGRP") {
+            if (!cursor.readIntegers((size_t)count * 3, groups)) {
+                LOG_ERROR("PSF line " << cursor.line << ": malformed NGRP entry");
+                return false;
+            }
+            for (size_t g = 0; g < groups.size(); g += 3) {
+                if (groups[g] >= atomCount() || (g > 0 && groups[g] <= groups[g - 3])) {
+                    LOG_ERROR("PSF line " << cursor.line << ": NGRP group starts out of order");
+                    return false;
+                }
+            }
+        } else if (section == "MOLNT") {
+            molnt = true;
+            if (!cursor.readIntegers(atomCount(), molecules)) {
+                LOG_ERROR("PSF line " << cursor.line << ": malformed MOLNT entry");
+                return false;
+            }
+        } else if (section == "NUMLP") {
+            if (count != 0 || second != 0) {
+                LOG_ERROR("PSF line " << cursor.line << ": lone pairs are not supported");
+                return false;
+            }
+        } else {
+            vector<uint32_t>* terms = NULL;
+            size_t arity = 4;
+            bool allowZero = false;
+            if (section == "NBOND") {
+                terms = &bonds;
+                arity = 2;
+            } else if (section == "NTHETA") {
+                terms = &angles;
+                arity = 3;
+            } else if (section == "NPHI") {
+                terms = &dihedrals;
+            } else if (section == "NIMPHI") {
+                terms = &impropers;
+            } else if (section == "NCRTERM") {
+                terms = &crossterms;
+                arity = 8;
+            } else if (section == "NDON" || section == "NACC") {
+                terms = section == "NDON" ? &donors : &acceptors;
+                arity = 2;
+                allowZero = true;
+            } else {
+                LOG_WARN("PSF line " << cursor.line << ": section " << section << " and the rest of the file not read");
+                break;
+            }
+
+            if (!cursor.readIntegers((size_t)count * arity, *terms) ||
+                !toAtomIndices(*terms, atomCount(), allowZero)) {
+                LOG_ERROR("PSF line " << cursor.line << ": bad atom index in " << section);
+                return false;
+            }
+        }
+    }
+    if (atomCount() == 0) {
+        LOG_ERROR("No atoms in the PSF");
+        return false;
+    }
+    return true;
+}
+
+void PsfFile::write(ostream& out) const {
+    // More atoms than an I8 column holds, or names longer than the A4
+    // columns (CGenFF types), need the wide layout
+    bool wide = ext || atomCount() > 99999999;
+    for (size_t i = 0; i < strings.size() && !wide; ++i) wide = strings[i].size() > 4;
+    PsfWriter writer(out, wide);
+
+    string header = "PSF";
+    if (wide) header += " EXT";
+    for (size_t i = 0; i < flags.size(); ++i) header += " " + flags[i];
+    writer.text(header + "\n\n");
+
+    writer.header(title.size(), "NTITLE");
+    for (size_t i = 0; i < title.size(); ++i) writer.text(title[i] + "\n");
+    writer.newline();
+
+    // psfgen's atom columns: "%10d %-8s %-8s %-8s %-8s %-6s %10.6f %13.4f
+    // %11d" (EXT), or "%8d" and "%-4s" throughout; only the numbers go
+    // through snprintf. CHEQ files add the electronegativity and hardness
+    // as "%10.5f%18s", the latter in Fortran E format
+    writer.header(atomCount(), "NATOM");
+    const size_t width = wide ? 8 : 4;
+    const bool cheq = find(flags.begin(), flags.end(), "CHEQ") != flags.end();
+    const bool cheqValues = electronegativities.size() == atomCount() && hardnesses.size() == atomCount();
+    char numbers[128], hardness[48];
+    for (size_t a = 0; a < atomCount(); ++a) {
+        writer.integer(a + 1, wide ? 10 : 8);
+        writer.text(" ");
+        writer.name(strings[segids[a]], width);
+        writer.name(strings[resids[a]], width);
+        writer.name(strings[resnames[a]], width);
+        writer.name(strings[names[a]], width);
+        writer.name(strings[types[a]], wide ? 6 : 4);
+        int n;
+        if (cheq) {
+            formatFortranE(cheqValues ? hardnesses[a] : 0.0, hardness, sizeof(hardness));
+            n = snprintf(numbers, sizeof(numbers), "%10.6f %13.4f %11d%10.5f%18s\n", charges[a], masses[a], moves[a],
+                         cheqValues ? electronegativities[a] : 0.0, hardness);
+        } else {
+            n = snprintf(numbers, sizeof(numbers), "%10.6f %13.4f %11d\n", charges[a], masses[a], moves[a]);
+        }
+        writer.append(numbers, (size_t)min(n, (int)sizeof(numbers) - 1));
+    }
+    writer.newline();
+
+    writer.header(bondCount(), "NBOND: bonds");
+    writer.numbers(bonds, 8, true);
+    writer.header(angleCount(), "NTHETA: angles");
+    writer.numbers(angles, 9, true);
+    writer.header(dihedralCount(), "NPHI: dihedrals");
+    writer.numbers(dihedrals, 8, true);
+    writer.header(improperCount(), "NIMPHI: impropers");
+    writer.numbers(impropers, 8, true);
+    writer.header(donors.size() / 2, "NDON: donors");
+    writer.numbers(donors, 8, true);
+    writer.header(acceptors.size() / 2, "NACC: acceptors");
+    writer.numbers(acceptors, 8, true);
+
+    // One pointer per atom even without exclusions
+    writer.header(exclusions.size(), "NNB");
+    writer.numbers(exclusions, 8, true);
+    if (exclusionEnds.size() == atomCount()) {
+        writer.numbers(exclusionEnds, 8, false);
+    } else {
+        writer.numbers(vector<uint32_t>(atomCount(), (uint32_t)exclusions.size()), 8, false);
+    }
+
+    // psfgen writes the whole structure as one group when there are none
+    const uint32_t oneGroup[] = {0, 0, 0};
+    const vector<uint32_t> wholeGroup(oneGroup, oneGroup + 3);
+    const vector<uint32_t>& groupList = groups.empty() ? wholeGroup : groups;
+    char countLine[64];
+    int n = snprintf(countLine, sizeof(countLine), wide ? "%10zu%10d !NGRP NST2\n" : "%8zu%8d !NGRP NST2\n",
+                     groupList.size() / 3, 0);
+    writer.append(countLine, (size_t)n);
+    writer.numbers(groupList, 9, false);
+
+    if (molnt) {
+        uint32_t count = 0;
+        for (size_t i = 0; i < molecules.size(); ++i) count = max(count, molecules[i]);
+        writer.header(count, "MOLNT");
+        writer.numbers(molecules, 8, false);
+        n = snprintf(countLine, sizeof(countLine), wide ? "%10d%10d !NUMLP NUMLPH\n" : "%8d%8d !NUMLP NUMLPH\n", 0, 0);
+        writer.append(countLine, (size_t)n);
+        writer.newline();
+    }
+
+    writer.header(crosstermCount(), "NCRTERM: cross-terms");
+    writer.numbers(crossterms, 8, true);
+}
+
+bool PsfFile::save(const string& filename) const {
+    string tempName = filename + ".tmp";
+    {
+        ofstream out(tempName.c_str(), ios::out | ios::binary);
+        if (!out) {
+            LOG_ERROR("Could not write " << tempName);
+            return false;
+        }
+        write(out);
+        if (!out) {
+            LOG_ERROR("Could not write " << tempName);
+            return false;
+        }
+    }
+    if (rename(tempName.c_str(), filename.c_str()) != 0) {
+        LOG_ERROR("Renaming " << tempName << " to " << filename << " failed.");
+        return false;
+    }
+    return true;
+}
+
+string PsfFile::describeAtom(uint32_t atom) const {
+    return strings[segids[atom]] + ":" + strings[resids[atom]] + " " + strings[resnames[atom]] + " " +
+           strings[names[atom]];
+}
+
+long PsfFile::findAtom(const string& segid, const string& resid, const string& name) const {
+    unordered_map<string, uint32_t>::const_iterator s = stringIds.find(segid);
+    unordered_map<string, uint32_t>::const_iterator r = stringIds.find(resid);
+    unordered_map<string, uint32_t>::const_iterator n = stringIds.find(name);
+    if (s == stringIds.end() || r == stringIds.end() || n == stringIds.end()) return -1;
+    for (size_t a = 0; a < atomCount(); ++a) {
+        if (names[a] == n->second && resids[a] == r->second && segids[a] == s->second) return (long)a;
+    }
+    return -1;
+}
+
+double PsfFile::totalCharge() const {
+    double total = 0.0;
+    for (size_t a = 0; a < charges.size(); ++a) total += charges[a];
+    return total;
+}
+
+// ── Deleting atoms ───────────────────────────────────────────────────────────
+
+// Keep the terms whose atoms all survive, renumbered through newIndex
+static void remapTerms(vector<uint32_t>& terms, size_t arity, const vector<uint32_t>& newIndex) {
+    size_t kept = 0;
+    for (size_t i = 0; i + arity <= terms.size(); i += arity) {
+        bool alive = true;
+        for (size_t j = 0; j < arity && alive; ++j) {
+            uint32_t atom = terms[i + j];
+            alive = atom == PsfFile::noAtom || newIndex[atom] != PsfFile::noAtom;
+        }
+        if (!alive) continue;
+        for (size_t j = 0; j < arity; ++j) {
+            uint32_t atom = terms[i + j];
+            terms[kept + j] = atom == PsfFile::noAtom ? atom : newIndex[atom];
+        }
+        kept += arity;
+    }
+    terms.resize(kept);
+}
+
+template <typename T>
+static void compact(vector<T>& values, const vector<uint32_t>& newIndex) {
+    size_t kept = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (newIndex[i] != PsfFile::noAtom) values[kept++] = values[i];
+    }
+    values.resize(kept);
+}
+
+size_t PsfFile::deleteAtoms(const vector<bool>& doomed) {
+    const size_t atoms = atomCount();
+    vector<uint32_t> newIndex(atoms, noAtom);
+    uint32_t next = 0;
+    for (size_t a = 0; a < atoms; ++a) {
+        if (a >= doomed.size() || !doomed[a]) newIndex[a] = next++;
+    }
+    if (next == atoms) return 0;
+
+    // Exclusions and groups are read in the old numbering, so they go first
+    if (exclusionEnds.size() == atoms) {
+        vector<uint32_t> keptExclusions, keptEnds;
+        uint32_t start = 0;
+        for (size_t a = 0; a < atoms; ++a) {
+            uint32_t end = exclusionEnds[a];
+            if (newIndex[a] != noAtom) {
+                for (uint32_t e = start; e < end; ++e) {
+                    if (newIndex[exclusions[e]] != noAtom) keptExclusions.push_back(newIndex[exclusions[e]]);
+                }
+                keptEnds.push_back((uint32_t)keptExclusions.size());
+            }
+            start = end;
+        }
+        exclusions.swap(keptExclusions);
+        exclusionEnds.swap(keptEnds);
+    }
+
+    // A group starts at its first surviving atom; empty groups go
+    vector<uint32_t> keptGroups;
+    for (size_t g = 0; g < groups.size(); g += 3) {
+        size_t last = g + 3 < groups.size() ? groups[g + 3] : atoms;
+        for (size_t a = groups[g]; a < last; ++a) {
+            if (newIndex[a] == noAtom) continue;
+            keptGroups.push_back(newIndex[a]);
+            keptGroups.push_back(groups[g + 1]);
+            keptGroups.push_back(groups[g + 2]);
+            break;
+        }
+    }
+    groups.swap(keptGroups);
+
+    compact(segids, newIndex);
+    compact(resids, newIndex);
+    compact(resnames, newIndex);
+    compact(names, newIndex);
+    compact(types, newIndex);
+    compact(charges, newIndex);
+    compact(masses, newIndex);
+    compact(moves, newIndex);
+    if (electronegativities.size() == atoms) compact(electronegativities, newIndex);
+    if (hardnesses.size() == atoms) compact(hardnesses, newIndex);
+    if (molecules.size() == atoms) compact(molecules, newIndex);
+
+    remapTerms(bonds, 2, newIndex);
+    remapTerms(angles, 3, newIndex);
+    remapTerms(dihedrals, 4, newIndex);
+    remapTerms(impropers, 4, newIndex);
+    remapTerms(crossterms, 8, newIndex);
+    remapTerms(donors, 2, newIndex);
+    remapTerms(acceptors, 2, newIndex);
+    return atoms - next;
+}
@@ -0,0 +1,98 @@
+// PsfFile.h
+#ifndef PSFFILE_H
+#define PSFFILE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// CHARMM/X-PLOR protein structure file, as psfgen writes it for the capsid
+// (QB_naa_capsid_wb.psf): atoms, their bonded terms and the bookkeeping
+// sections after them.
+//
+// Atoms are stored as parallel arrays. Segment, residue, name and type
+// strings are interned: each atom holds small integer ids into one string
+// table, so a capsid of a million atoms costs a few tens of bytes per atom.
+// Bonded terms are flat arrays of 0-based atom indices, two per bond, three
+// per angle, four per dihedral or improper, eight per CMAP cross-term.
+//
+// Both the standard and the EXT (wide column) layouts are read; atom lines
+// are split on whitespace, the other sections read as a stream of integers.
+// write() uses psfgen's atom columns for the layout in effect, including
+// the two CHEQ columns, and its section layout, so edited files load in
+// NAMD and VMD like the originals. Lone pairs and Drude particles are not
+// supported.
+
+class PsfFile {
+public:
+    // Acceptor antecedent or donor hydrogen that is absent (0 in the file)
+    static const uint32_t noAtom = 0xFFFFFFFF;
+
+    PsfFile();
+
+    bool load(const std::string& filename);
+    bool parse(const char* data, size_t size);
+    void clear();
+
+    void write(std::ostream& out) const;
+    // Written to a temporary file first, then renamed over filename
+    bool save(const std::string& filename) const;
+
+    bool extended() const { return ext; }
+    void setExtended(bool wide) { ext = wide; }
+    size_t atomCount() const { return charges.size(); }
+    size_t bondCount() const { return bonds.size() / 2; }
+    size_t angleCount() const { return angles.size() / 3; }
+    size_t dihedralCount() const { return dihedrals.size() / 4; }
+    size_t improperCount() const { return impropers.size() / 4; }
+    size_t crosstermCount() const { return crossterms.size() / 8; }
+
+    // Interned strings
+    const std::string& text(uint32_t id) const { return strings[id]; }
+    size_t stringCount() const { return strings.size(); }
+
+    // Header words after "PSF" other than EXT (CMAP, CHEQ, XPLOR), and the
+    // NTITLE lines
+    std::vector<std::string> flags;
+    std::vector<std::string> title;
+
+    // Per-atom ids into text()
+    std::vector<uint32_t> segids, resids, resnames, names, types;
+    std::vector<double> charges, masses;
+    std::vector<int> moves;                 // IMOVE column
+    // CHEQ columns: electronegativity and hardness per atom, CHEQ files only
+    std::vector<double> electronegativities, hardnesses;
+
+    std::vector<uint32_t> bonds, angles, dihedrals, impropers, crossterms;
+    std::vector<uint32_t> donors, acceptors;     // pairs; the second may be noAtom
+
+    // NNB: excluded atoms, and per atom the end of its run in exclusions
+    std::vector<uint32_t> exclusions, exclusionEnds;
+    // NGRP: first atom (0-based), group type and move flag per group
+    std::vector<uint32_t> groups;
+    // MOLNT: molecule number per atom, CHEQ files only
+    std::vector<uint32_t> molecules;
+
+    // "SEGID:RESID RESNAME NAME" of atom, for messages
+    std::string describeAtom(uint32_t atom) const;
+    // Index of the atom, -1 if there is none
+    long findAtom(const std::string& segid, const std::string& resid, const std::string& name) const;
+    double totalCharge() const;
+
+    // Remove the atoms flagged in doomed (one flag per atom) and every term,
+    // exclusion and group entry naming them; the rest is renumbered.
+    // Returns the number of atoms removed.
+    size_t deleteAtoms(const std::vector<bool>& doomed);
+
+private:
+    uint32_t intern(const char* data, size_t size);
+
+    bool ext;
+    bool molnt;                 // MOLNT and NUMLP sections present
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+};
+
+#endif // PSFFILE_H
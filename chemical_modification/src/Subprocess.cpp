@@ -0,0 +1,118 @@
+// Subprocess.cpp
+#include "Subprocess.h"
+#include "Logger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+static void closeBoth(int fds[2]) {
+    if (fds[0] >= 0) close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+}
+
+// Held from pipe creation to fork, so no other thread's child inherits a
+// pipe end before it is marked close-on-exec
+static std::mutex spawnMutex;
+
+static bool makePipe(int fds[2]) {
+    fds[0] = fds[1] = -1;
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+bool runProcess(const vector<string>& argv, ProcessResult& result) {
+    result.exitCode = -1;
+    result.output.clear();
+    result.errors.clear();
+    result.seconds = 0.0;
+    if (argv.empty()) return false;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Everything the child needs is prepared before fork
+    vector<char*> args;
+    for (size_t i = 0; i < argv.size(); ++i) args.push_back(const_cast<char*>(argv[i].c_str()));
+    args.push_back(NULL);
+
+    unique_lock<std::mutex> spawnLock(spawnMutex);
+    int outPipe[2], errPipe[2];
+    if (!makePipe(outPipe)) {
+        LOG_ERROR("pipe failed: " << strerror(errno));
+        return false;
+    }
+    if (!makePipe(errPipe)) {
+        LOG_ERROR("pipe failed: " << strerror(errno));
+        closeBoth(outPipe);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("fork failed: " << strerror(errno));
+        closeBoth(outPipe);
+        closeBoth(errPipe);
+        return false;
+    }
+    if (pid == 0) {
+        // Child: only async-signal-safe calls until exec
+        dup2(outPipe[1], STDOUT_FILENO);
+        dup2(errPipe[1], STDERR_FILENO);
+        execv(args[0], &args[0]);
+        _exit(127);
+    }
+    spawnLock.unlock();
+
+    close(outPipe[1]);
+    close(errPipe[1]);
+
+    // Drain both pipes together so a child filling one cannot block
+    struct pollfd fds[2];
+    fds[0].fd = outPipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = errPipe[0];
+    fds[1].events = POLLIN;
+    string* sinks[2] = {&result.output, &result.errors};
+    int open = 2;
+    char buffer[65536];
+    while (open > 0) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int k = 0; k < 2; ++k) {
+            if (fds[k].fd < 0 || !(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            ssize_t n = read(fds[k].fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                sinks[k]->append(buffer, n);
+            } else if (n == 0 || errno != EINTR) {
+                close(fds[k].fd);
+                fds[k].fd = -1;
+                open--;
+            }
+        }
+    }
+    for (int k = 0; k < 2; ++k) {
+        if (fds[k].fd >= 0) close(fds[k].fd);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (result.exitCode == 127 && result.output.empty()) {
+        LOG_ERROR("Could not run " << argv[0]);
+        return false;
+    }
+    return true;
+}
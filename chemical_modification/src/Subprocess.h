@@ -0,0 +1,22 @@
+// Subprocess.h
+#ifndef SUBPROCESS_H
+#define SUBPROCESS_H
+
+#include <string>
+#include <vector>
+
+// Run a program directly (fork/exec, no shell) and capture its stdout and
+// stderr through pipes. Safe to call from several threads at once.
+
+struct ProcessResult {
+    int exitCode;           // exit status, or -1 if it did not exit normally
+    std::string output;     // stdout
+    std::string errors;     // stderr
+    double seconds;         // wall time
+};
+
+// argv[0] is the program path. Returns false if the program could not be
+// started; a program that runs and fails returns true with exitCode != 0.
+bool runProcess(const std::vector<std::string>& argv, ProcessResult& result);
+
+#endif // SUBPROCESS_H
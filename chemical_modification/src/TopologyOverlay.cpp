@@ -0,0 +1,78 @@
+// TopologyOverlay.cpp
+#include "TopologyOverlay.h"
+#include "CharmmStream.h"
+#include "Logger.h"
+#include "TopologyStore.h"
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+string emptyOverlay(const string& baseFile) {
+    ostringstream out;
+    out << "* Project topology, read after " << baseFile << "\n"
+        << "*\n"
+        << "36  1\n"
+        << "\n"
+        << topologyDefaults
+        << "\n"
+        << "END\n";
+    return out.str();
+}
+
+bool checkOverlayCollisions(const TopologyStore& base, const StrModel& overlay, vector<string>& collisions) {
+    collisions.clear();
+
+    set<string> seen;
+    for (size_t i = 0; i < overlay.masses.size(); ++i) {
+        string type = overlay.masses[i].type.str();
+        if (base.findType(type)) collisions.push_back("MASS " + type + " is already defined in " + base.sourceFile());
+        else if (!seen.insert(type).second) collisions.push_back("MASS " + type + " is defined twice");
+    }
+
+    // RESI and PRES names share one namespace in psfgen and CHARMM
+    seen.clear();
+    for (size_t i = 0; i < overlay.residues.size(); ++i) {
+        const StrResidue& residue = overlay.residues[i];
+        string kind = residue.patch ? "PRES " : "RESI ";
+        string name = residue.name.str();
+        if (base.findResidue(name)) collisions.push_back(kind + name + " is already defined in " + base.sourceFile());
+        else if (!seen.insert(name).second) collisions.push_back(kind + name + " is defined twice");
+    }
+    return collisions.empty();
+}
+
+void undefinedOverlayTypes(const TopologyStore& base, const StrModel& overlay, vector<string>& types) {
+    types.clear();
+    set<string> reported;
+    for (size_t r = 0; r < overlay.residues.size(); ++r) {
+        // Patches also use protein types, which come from top_all36_prot.rtf
+        if (overlay.residues[r].patch) continue;
+        const vector<StrAtomRecord>& atoms = overlay.residues[r].atoms;
+        for (size_t a = 0; a < atoms.size(); ++a) {
+            string type = atoms[a].type.str();
+            if (base.findType(type) || overlay.findMass(type) || !reported.insert(type).second) continue;
+            types.push_back(type);
+        }
+    }
+}
+
+bool validateOverlay(const TopologyStore& base, const string& overlayText, const string& overlayName) {
+    StrModel overlay;
+    parseCharmmStream(overlayText.data(), overlayText.size(), overlay);
+    for (size_t i = 0; i < overlay.problems.size(); ++i) LOG_WARN(overlayName << " " << overlay.problems[i]);
+
+    vector<string> found;
+    undefinedOverlayTypes(base, overlay, found);
+    for (size_t i = 0; i < found.size(); ++i) LOG_WARN("Atom type " << found[i] << " in " << overlayName << " has no MASS entry");
+
+    if (!checkOverlayCollisions(base, overlay, found)) {
+        // A full copy of the base collides on every name; a few lines say enough
+        const size_t shown = 10;
+        for (size_t i = 0; i < found.size() && i < shown; ++i) LOG_ERROR(overlayName << ": " << found[i]);
+        if (found.size() > shown) LOG_ERROR(overlayName << ": ... and " << found.size() - shown << " more collisions");
+        return false;
+    }
+    LOG_DEBUG(overlayName << ": " << overlay.residues.size() << " residues over " << base.sourceFile());
+    return true;
+}
@@ -0,0 +1,37 @@
+// TopologyOverlay.h
+#ifndef TOPOLOGYOVERLAY_H
+#define TOPOLOGYOVERLAY_H
+
+#include <string>
+#include <vector>
+
+class TopologyStore;
+struct StrModel;
+
+// A project's own residues and patches, kept in a small topology file that
+// psfgen reads after the unchanged base RTF:
+//
+//   topology top_all36_cgenff_CBD_template.rtf     base, never written
+//   topology top_all36_cgenff_CBD.rtf              overlay
+//
+// The overlay only adds: a MASS type or RESI/PRES name the base already
+// defines would silently replace the base definition (or be dropped, depending
+// on the reader), so composing an overlay is checked against the base index.
+
+// Text of an overlay with no residues yet. The DEFA/AUTO lines restate the
+// defaults the base ends with, and give the file a topology section for
+// insertResidueTopology to fill.
+std::string emptyOverlay(const std::string& baseFile);
+
+// MASS types and RESI/PRES names of overlay that base also defines, or that
+// the overlay defines twice, as "RESI ONE" style descriptions. True if none.
+bool checkOverlayCollisions(const TopologyStore& base, const StrModel& overlay, std::vector<std::string>& collisions);
+
+// Atom types of the overlay's RESI blocks with a MASS entry in neither file
+void undefinedOverlayTypes(const TopologyStore& base, const StrModel& overlay, std::vector<std::string>& types);
+
+// Parse overlayText and check it against base: collisions are logged as
+// errors, undefined types as warnings. True if there are no collisions.
+bool validateOverlay(const TopologyStore& base, const std::string& overlayText, const std::string& overlayName);
+
+#endif // TOPOLOGYOVERLAY_H
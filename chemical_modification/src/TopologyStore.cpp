@@ -0,0 +1,346 @@
+// TopologyStore.cpp
+#include "TopologyStore.h"
+#include "CharmmStream.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+static const char cacheMagic[8] = {'C', 'H', 'E', 'M', 'T', 'O', 'P', '1'};
+
+// FNV-1a over 8-byte words, then the tail bytes
+static uint64_t contentHash(const char* data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i) hash = (hash ^ (unsigned char)data[i]) * prime;
+    return hash;
+}
+
+// ── Cache encoding ───────────────────────────────────────────────────────────
+
+static void putBytes(string& out, const void* data, size_t size) {
+    out.append((const char*)data, size);
+}
+
+template <typename T>
+static void put(string& out, T value) {
+    putBytes(out, &value, sizeof(value));
+}
+
+static void putString(string& out, const string& s) {
+    put<uint16_t>(out, (uint16_t)s.size());
+    out.append(s);
+}
+
+// Bounds-checked reader over a cache file's contents
+struct CacheReader {
+    const char* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+
+    CacheReader(const string& bytes) : data(bytes.data()), size(bytes.size()), pos(0), ok(true) {}
+
+    void bytes(void* out, size_t n) {
+        if (!ok || size - pos < n) {
+            ok = false;
+            memset(out, 0, n);
+            return;
+        }
+        memcpy(out, data + pos, n);
+        pos += n;
+    }
+
+    template <typename T>
+    T get() {
+        T value;
+        bytes(&value, sizeof(value));
+        return value;
+    }
+
+    string getString() {
+        uint16_t n = get<uint16_t>();
+        if (!ok || size - pos < n) {
+            ok = false;
+            return string();
+        }
+        string s(data + pos, n);
+        pos += n;
+        return s;
+    }
+};
+
+const char* const topologyDefaults = "DEFA FIRS NONE LAST NONE\nAUTO ANGLES DIHE\n";
+
+// ── TopologyStore ────────────────────────────────────────────────────────────
+
+TopologyStore::TopologyStore() : sourceSize(0), sourceHash(0), fromCache(false) {
+}
+
+bool TopologyStore::open(const string& rtfFile) {
+    source = rtfFile;
+    fromCache = false;
+    typeList.clear();
+    residueList.clear();
+    atomList.clear();
+
+    CharmmStream stream;
+    if (!stream.map(rtfFile)) {
+        source.clear();
+        return false;
+    }
+    sourceSize = stream.size();
+    sourceHash = contentHash(stream.data(), stream.size());
+
+    string cache = cacheFile(rtfFile);
+    if (loadCache(cache, sourceSize, sourceHash)) {
+        fromCache = true;
+    } else {
+        if (!buildFromSource(stream.data(), stream.size())) return false;
+        if (!saveCache(cache)) LOG_WARN("Could not write the topology index " << cache);
+    }
+    buildMaps();
+    LOG_DEBUG("Topology " << rtfFile << ": " << typeList.size() << " types, " << residueList.size()
+              << " residues" << (fromCache ? " (cached index)" : ""));
+    return true;
+}
+
+bool TopologyStore::buildFromSource(const char* data, size_t size) {
+    StrModel model;
+    parseCharmmStream(data, size, model);
+    for (size_t i = 0; i < model.problems.size(); ++i) LOG_WARN(source << " " << model.problems[i]);
+
+    for (size_t m = 0; m < model.masses.size(); ++m) {
+        const StrMassRecord& mass = model.masses[m];
+        TopologyType type;
+        type.type = mass.type.str();
+        type.number = mass.number;
+        type.mass = mass.mass;
+        type.element = mass.element.str();
+        type.offset = (uint64_t)(mass.text.data - data);
+        type.length = (uint32_t)mass.text.size;
+        typeList.push_back(type);
+    }
+    for (size_t r = 0; r < model.residues.size(); ++r) {
+        const StrResidue& parsed = model.residues[r];
+        TopologyResidue residue;
+        residue.name = parsed.name.str();
+        residue.patch = parsed.patch;
+        residue.charge = parsed.charge;
+        residue.offset = (uint64_t)(parsed.text.data - data);
+        residue.length = parsed.text.size;
+        residue.firstAtom = (uint32_t)atomList.size();
+        residue.atomCount = (uint32_t)parsed.atoms.size();
+        for (size_t a = 0; a < parsed.atoms.size(); ++a) {
+            TopologyAtom atom;
+            atom.name = parsed.atoms[a].name.str();
+            atom.type = parsed.atoms[a].type.str();
+            atom.charge = parsed.atoms[a].charge;
+            atomList.push_back(atom);
+        }
+        residueList.push_back(residue);
+    }
+    return true;
+}
+
+bool TopologyStore::loadCache(const string& filename, uint64_t size, uint64_t hash) {
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in) return false;
+    ostringstream buffer;
+    buffer << in.rdbuf();
+    string bytes = buffer.str();
+
+    CacheReader reader(bytes);
+    char magic[8];
+    reader.bytes(magic, sizeof(magic));
+    if (!reader.ok || memcmp(magic, cacheMagic, sizeof(magic)) != 0) return false;
+    if (reader.get<uint64_t>() != size || reader.get<uint64_t>() != hash) {
+        LOG_DEBUG(filename << " is out of date, reindexing " << source);
+        return false;
+    }
+
+    uint32_t numTypes = reader.get<uint32_t>();
+    uint32_t numResidues = reader.get<uint32_t>();
+    uint32_t numAtoms = reader.get<uint32_t>();
+    // Every record takes at least one byte, which bounds the counts
+    if (!reader.ok || numTypes > bytes.size() || numResidues > bytes.size() || numAtoms > bytes.size()) return false;
+
+    typeList.resize(numTypes);
+    for (uint32_t i = 0; i < numTypes && reader.ok; ++i) {
+        TopologyType& t = typeList[i];
+        t.type = reader.getString();
+        t.number = reader.get<int32_t>();
+        t.mass = reader.get<double>();
+        t.element = reader.getString();
+        t.offset = reader.get<uint64_t>();
+        t.length = reader.get<uint32_t>();
+    }
+    residueList.resize(numResidues);
+    for (uint32_t i = 0; i < numResidues && reader.ok; ++i) {
+        TopologyResidue& r = residueList[i];
+        r.name = reader.getString();
+        r.patch = reader.get<uint8_t>() != 0;
+        r.charge = reader.get<double>();
+        r.offset = reader.get<uint64_t>();
+        r.length = reader.get<uint64_t>();
+        r.firstAtom = reader.get<uint32_t>();
+        r.atomCount = reader.get<uint32_t>();
+        if ((uint64_t)r.firstAtom + r.atomCount > numAtoms) reader.ok = false;
+    }
+    atomList.resize(numAtoms);
+    for (uint32_t i = 0; i < numAtoms && reader.ok; ++i) {
+        TopologyAtom& a = atomList[i];
+        a.name = reader.getString();
+        a.type = reader.getString();
+        a.charge = reader.get<double>();
+    }
+
+    if (!reader.ok || reader.pos != bytes.size()) {
+        LOG_WARN(filename << " is damaged, reindexing " << source);
+        typeList.clear();
+        residueList.clear();
+        atomList.clear();
+        return false;
+    }
+    return true;
+}
+
+bool TopologyStore::saveCache(const string& filename) const {
+    string out;
+    putBytes(out, cacheMagic, sizeof(cacheMagic));
+    put<uint64_t>(out, sourceSize);
+    put<uint64_t>(out, sourceHash);
+    put<uint32_t>(out, (uint32_t)typeList.size());
+    put<uint32_t>(out, (uint32_t)residueList.size());
+    put<uint32_t>(out, (uint32_t)atomList.size());
+    for (size_t i = 0; i < typeList.size(); ++i) {
+        const TopologyType& t = typeList[i];
+        putString(out, t.type);
+        put<int32_t>(out, t.number);
+        put<double>(out, t.mass);
+        putString(out, t.element);
+        put<uint64_t>(out, t.offset);
+        put<uint32_t>(out, t.length);
+    }
+    for (size_t i = 0; i < residueList.size(); ++i) {
+        const TopologyResidue& r = residueList[i];
+        putString(out, r.name);
+        put<uint8_t>(out, r.patch ? 1 : 0);
+        put<double>(out, r.charge);
+        put<uint64_t>(out, r.offset);
+        put<uint64_t>(out, r.length);
+        put<uint32_t>(out, r.firstAtom);
+        put<uint32_t>(out, r.atomCount);
+    }
+    for (size_t i = 0; i < atomList.size(); ++i) {
+        const TopologyAtom& a = atomList[i];
+        putString(out, a.name);
+        putString(out, a.type);
+        put<double>(out, a.charge);
+    }
+
+    // Written beside the cache and renamed, so readers never see half a file
+    string tempName = filename + ".tmp";
+    {
+        ofstream file(tempName.c_str(), ios::out | ios::binary);
+        if (!file || !file.write(out.data(), out.size())) return false;
+    }
+    return rename(tempName.c_str(), filename.c_str()) == 0;
+}
+
+void TopologyStore::buildMaps() {
+    typeIndex.clear();
+    residueIndex.clear();
+    atomIndex.clear();
+    typeIndex.reserve(typeList.size());
+    residueIndex.reserve(residueList.size());
+    atomIndex.reserve(atomList.size());
+
+    // A later definition shadows an earlier one, as when CHARMM reads the file
+    for (size_t i = 0; i < typeList.size(); ++i) typeIndex[typeList[i].type] = (uint32_t)i;
+    for (size_t r = 0; r < residueList.size(); ++r) {
+        const TopologyResidue& residue = residueList[r];
+        residueIndex[residue.name] = (uint32_t)r;
+        for (uint32_t a = 0; a < residue.atomCount; ++a) {
+            uint32_t index = residue.firstAtom + a;
+            atomIndex[residue.name + " " + atomList[index].name] = index;
+        }
+    }
+}
+
+const TopologyType* TopologyStore::findType(const string& type) const {
+    unordered_map<string, uint32_t>::const_iterator it = typeIndex.find(type);
+    return it == typeIndex.end() ? NULL : &typeList[it->second];
+}
+
+const TopologyResidue* TopologyStore::findResidue(const string& name) const {
+    unordered_map<string, uint32_t>::const_iterator it = residueIndex.find(name);
+    return it == residueIndex.end() ? NULL : &residueList[it->second];
+}
+
+const TopologyAtom* TopologyStore::findAtom(const string& residue, const string& atom) const {
+    unordered_map<string, uint32_t>::const_iterator it = atomIndex.find(residue + " " + atom);
+    return it == atomIndex.end() ? NULL : &atomList[it->second];
+}
+
+bool TopologyStore::writeSubset(const vector<string>& residueNames, ostream& out) const {
+    vector<const TopologyResidue*> selected;
+    set<string> usedTypes;
+    for (size_t i = 0; i < residueNames.size(); ++i) {
+        const TopologyResidue* residue = findResidue(residueNames[i]);
+        if (!residue) {
+            LOG_ERROR("Residue " << residueNames[i] << " is not in " << source);
+            return false;
+        }
+        selected.push_back(residue);
+        for (uint32_t a = 0; a < residue->atomCount; ++a) usedTypes.insert(atomList[residue->firstAtom + a].type);
+    }
+
+    // MASS lines in file order, so the subset keeps the source's numbering
+    vector<const TopologyType*> types;
+    for (set<string>::const_iterator it = usedTypes.begin(); it != usedTypes.end(); ++it) {
+        const TopologyType* type = findType(*it);
+        if (!type) {
+            LOG_ERROR("Atom type " << *it << " has no MASS entry in " << source);
+            return false;
+        }
+        types.push_back(type);
+    }
+    sort(types.begin(), types.end(),
+         [](const TopologyType* a, const TopologyType* b) { return a->offset < b->offset; });
+
+    ifstream in(source.c_str(), ios::in | ios::binary);
+    if (!in) {
+        LOG_ERROR("Could not open " << source);
+        return false;
+    }
+    string block;
+    out << "* Subset of " << source << "\n*\n36  1\n\n";
+    for (size_t i = 0; i < types.size(); ++i) {
+        block.resize(types[i]->length);
+        in.seekg((streamoff)types[i]->offset);
+        if (!in.read(&block[0], block.size())) return false;
+        out << block << "\n";
+    }
+    out << "\n" << topologyDefaults << "\n";
+    for (size_t i = 0; i < selected.size(); ++i) {
+        block.resize(selected[i]->length);
+        in.seekg((streamoff)selected[i]->offset);
+        if (!block.empty() && !in.read(&block[0], block.size())) return false;
+        out << block;
+        if (!block.empty() && block[block.size() - 1] != '\n') out << "\n";
+    }
+    out << "END\n";
+    return true;
+}
@@ -0,0 +1,97 @@
+// TopologyStore.h
+#ifndef TOPOLOGYSTORE_H
+#define TOPOLOGYSTORE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Indexed view of a large topology file such as the CGenFF base topology
+// (~58,000 lines): MASS types and RESI/PRES blocks by name, and atoms by
+// residue, all hashed.
+//
+// The index is built by one CharmmStream pass and cached next to the RTF
+// as "<rtf>.idx". The cache records the source's size and a hash of its
+// contents, and open() rebuilds it whenever either no longer matches, so an
+// edited or regenerated RTF is never served from a stale index.
+//
+// Offsets are byte offsets into the source RTF; writeSubset copies the
+// blocks it needs straight from there.
+
+struct TopologyType {
+    std::string type;
+    int number;
+    double mass;
+    std::string element;
+    uint64_t offset;        // MASS line
+    uint32_t length;
+};
+
+struct TopologyAtom {
+    std::string name;
+    std::string type;
+    double charge;
+};
+
+struct TopologyResidue {
+    std::string name;
+    bool patch;             // PRES
+    double charge;
+    uint64_t offset;        // RESI line up to the next RESI/PRES/END line
+    uint64_t length;
+    uint32_t firstAtom;     // into atoms()
+    uint32_t atomCount;
+};
+
+// The defaults a topology file states before its residues, so psfgen
+// applies no terminal patches and generates angles and dihedrals:
+// "DEFA FIRS NONE LAST NONE" and "AUTO ANGLES DIHE", one per line
+extern const char* const topologyDefaults;
+
+class TopologyStore {
+public:
+    TopologyStore();
+
+    // Load the cached index if it matches rtfFile, otherwise parse rtfFile
+    // and write a new cache (a failed cache write is only a warning)
+    bool open(const std::string& rtfFile);
+    bool loadedFromCache() const { return fromCache; }
+    const std::string& sourceFile() const { return source; }
+
+    const TopologyType* findType(const std::string& type) const;
+    const TopologyResidue* findResidue(const std::string& name) const;
+    const TopologyAtom* findAtom(const std::string& residue, const std::string& atom) const;
+
+    const std::vector<TopologyType>& types() const { return typeList; }
+    const std::vector<TopologyResidue>& residues() const { return residueList; }
+    const std::vector<TopologyAtom>& atoms() const { return atomList; }
+
+    // A standalone RTF holding only the named residues (RESI or PRES) and
+    // the MASS lines of the types their atoms use, with topologyDefaults
+    // before the residues. False if a residue or type is missing.
+    bool writeSubset(const std::vector<std::string>& residueNames, std::ostream& out) const;
+
+    static std::string cacheFile(const std::string& rtfFile) { return rtfFile + ".idx"; }
+
+private:
+    bool buildFromSource(const char* data, size_t size);
+    bool loadCache(const std::string& filename, uint64_t size, uint64_t hash);
+    bool saveCache(const std::string& filename) const;
+    void buildMaps();
+
+    std::string source;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    bool fromCache;
+
+    std::vector<TopologyType> typeList;
+    std::vector<TopologyResidue> residueList;
+    std::vector<TopologyAtom> atomList;
+    std::unordered_map<std::string, uint32_t> typeIndex;
+    std::unordered_map<std::string, uint32_t> residueIndex;
+    std::unordered_map<std::string, uint32_t> atomIndex;     // "RESI ATOM"
+};
+
+#endif // TOPOLOGYSTORE_H
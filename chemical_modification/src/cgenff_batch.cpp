@@ -0,0 +1,65 @@
+#include <cstdlib>        // For atoi
+#include <iostream>       // Input-output stream library
+#include <string>         // String library
+#include <vector>         // Vector library
+#include "CgenffBatch.h"  // Batch CGenFF driver
+#include "Logger.h"       // Leveled logging
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options] <dir|file.mol2>...\n"
+         << "  --jobs n         concurrent cgenff runs (default: one per core)\n"
+         << "  --cgenff path    cgenff executable (default ./cgenff)\n"
+         << "  --out dir        output directory (default cgenff_batch)\n";
+}
+
+//Run using: g++ -std=c++11 -pthread -o cgenff_batch cgenff_batch.cpp CgenffBatch.cpp Subprocess.cpp ICTable.cpp ICBuilder.cpp CharmmStream.cpp TopologyStore.cpp TopologyOverlay.cpp PdbReader.cpp InternalCoordinates.cpp GeometryCache.cpp GeometryKernels.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    BatchSettings settings;
+    vector<string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--jobs" || arg == "--cgenff" || arg == "--out") {
+            if (i + 1 >= argc) {
+                cerr << "Error: Missing value for " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            string value = argv[++i];
+            if (arg == "--jobs") settings.jobs = atoi(value.c_str());
+            else if (arg == "--cgenff") settings.cgenffPath = value;
+            else settings.outputDir = value;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            cerr << "Error: Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    vector<string> files;
+    if (!collectMol2Files(inputs, files)) return 1;
+    if (files.empty()) {
+        cerr << "Error: No .mol2 files to parameterize" << endl;
+        return 1;
+    }
+
+    vector<BatchLigand> results;
+    int failures = runCgenffBatch(files, settings, results);
+    string summary = settings.outputDir + "/summary.tsv";
+    if (!writeBatchSummary(summary, results)) return 1;
+
+    cout << results.size() - failures << " of " << results.size() << " ligands parameterized; summary in "
+         << summary << endl;
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,94 @@
+#include <iostream>       // Input-output stream library
+#include <string>         // String library
+#include <vector>         // Vector container
+#include "Logger.h"       // Leveled logging
+#include "ParameterCheck.h" // Missing parameter detection
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--conf namd_conf]\n"
+         << "       " << program << " <psf_file> <prm_file>...\n"
+         << "  Lists the bonds, angles, dihedrals, impropers and atom types of the\n"
+         << "  structure that none of the parameter files define\n"
+         << "  --conf  take the structure and parameter files from a NAMD\n"
+         << "          configuration file (default minimize.conf)\n"
+         << "  --self-check  check built-in structures whose impropers are covered\n"
+         << "                by wildcards in either orientation\n";
+}
+
+// Four atoms typed A B C D (or D C B A, which changes the order the check
+// numbers the types in) with a bond, angle and dihedral chain and one
+// improper, against parameters whose only improper is X B C D
+static bool checkImproper(const string& atomTypes, const string& improper, size_t expectedMissing) {
+    string text = "PSF\n\n       1 !NTITLE\n REMARKS self-check\n\n       4 !NATOM\n";
+    for (size_t a = 0; a < 4; ++a) {
+        string type(1, atomTypes[a]);
+        text += "       " + string(1, (char)('1' + a)) + " P1   1        RES  " + type + "1   " + type +
+                "       0.000000       12.0110           0\n";
+    }
+    text += "\n       3 !NBOND: bonds\n       1       2       2       3       3       4\n\n"
+            "       2 !NTHETA: angles\n       1       2       3       2       3       4\n\n"
+            "       1 !NPHI: dihedrals\n       1       2       3       4\n\n"
+            "       1 !NIMPHI: impropers\n" + improper + "\n\n";
+
+    PsfFile psf;
+    ParameterStore parameters;
+    parameters.parse("BONDS\nA B 300.0 1.5\nB C 300.0 1.5\nC D 300.0 1.5\n"
+                     "ANGLES\nA B C 50.0 110.0\nB C D 50.0 110.0\n"
+                     "DIHEDRALS\nX B C X 0.5 2 180.0\n"
+                     "IMPROPERS\nX B C D 20.0 0 0.0\n"
+                     "NONBONDED\nA 0.0 -0.1 2.0\nB 0.0 -0.1 2.0\nC 0.0 -0.1 2.0\nD 0.0 -0.1 2.0\n"
+                     "END\n");
+    ParameterCheckReport report;
+    vector<const ParameterStore*> stores(1, &parameters);
+    if (!psf.parse(text.data(), text.size()) || !findMissingParameters(psf, stores, report)) return false;
+    if (report.missing.size() == expectedMissing) return true;
+    cerr << "Atoms " << atomTypes << ", improper" << improper << ": expected " << expectedMissing
+         << " missing, found " << report.missing.size() << endl;
+    for (size_t i = 0; i < report.missing.size(); ++i) cerr << "  " << describeMissingParameter(report.missing[i]) << endl;
+    return false;
+}
+
+static int selfCheck() {
+    int failures = 0;
+    failures += !checkImproper("ABCD", "       1       2       3       4", 0);    // A B C D
+    failures += !checkImproper("ABCD", "       4       3       2       1", 0);    // D C B A
+    failures += !checkImproper("DCBA", "       4       3       2       1", 0);    // A B C D
+    failures += !checkImproper("DCBA", "       1       2       3       4", 0);    // D C B A
+    failures += !checkImproper("ABCD", "       2       1       3       4", 1);    // B A C D
+    cout << "Improper self-check: " << (failures ? "FAILED" : "passed") << endl;
+    return failures ? 1 : 0;
+}
+
+//Run using: g++ -std=c++11 -O2 -o check_params check_params.cpp ParameterCheck.cpp PsfFile.cpp ParameterStore.cpp CharmmStream.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc == 2 && string(argv[1]) == "--self-check") return selfCheck();
+
+    string psfFile;
+    vector<string> parameterFiles;
+    if (argc == 1 || (argc == 3 && string(argv[1]) == "--conf")) {
+        string confFile = argc == 3 ? argv[2] : "minimize.conf";
+        if (!namdInputFiles(confFile, psfFile, parameterFiles)) return 1;
+        if (psfFile.empty() || parameterFiles.empty()) {
+            cerr << confFile << " has no structure or parameters line" << endl;
+            return 1;
+        }
+    } else if (argc >= 3 && argv[1][0] != '-') {
+        psfFile = argv[1];
+        parameterFiles.assign(argv + 2, argv + argc);
+    } else {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ParameterCheckReport report;
+    if (!checkStructureParameters(psfFile, parameterFiles, report)) return 1;
+    cout << psfFile << ": " << report.tuplesChecked << " type tuples checked, " << report.missing.size()
+         << " missing" << endl;
+    return report.missing.empty() ? 0 : 2;
+}
@@ -6,6 +6,17 @@
 #include <wx/tglbtn.h>
 #include "FileProcessor.h"
 #include "MoleculeViewer.h"
+#include "ICTable.h"
+#include "ICBuilder.h"
+#include "PdbReader.h"
+#include "CharmmStream.h"
+#include "TopologyStore.h"
+#include "TopologyOverlay.h"
+#include "ParameterStore.h"
+#include "AtomTypeRenamer.h"
+#include "ParameterCheck.h"
+#include "CapRemoval.h"
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
@@ -36,11 +47,13 @@ private:
 
     // 3D molecule viewer
     MoleculeViewer* molViewer;
+    wxString viewerPdbPath;
     wxToggleButton* bondedModeBtn;
     wxToggleButton* deletedModeBtn;
     wxStaticText* viewerStatusLabel;
     
     FileProcessor processor;
+    TopologyStore baseTopology;     // indexed top_all36_cgenff_CBD_template.rtf
 
     // Panel creation methods
     wxPanel* CreateSetupPanel(wxNotebook* notebook);
@@ -60,6 +73,10 @@ private:
     void OnCreateTopology(wxCommandEvent& event);
     void OnDownloadNAAMol2(wxCommandEvent& event);
     void OnUploadNAAStr(wxCommandEvent& event);
+    bool ReportStreamFile(const wxString& path);
+    bool CheckTopologyOverlay();
+    bool RemoveCaps(const CapRemovalJob& job);
+    bool CheckCapsidParameters();
     void OnCreateViewCapsid(wxCommandEvent& event);
     void OnMinimizeCapsid(wxCommandEvent& event);
     void CreateViewQbeta();
@@ -74,6 +91,7 @@ private:
     void OnClearDeletedSelection(wxCommandEvent& event);
     void OnSelectionChanged(SelectionMode mode, const std::vector<std::string>& names);
     void UpdateViewerStatus();
+    void ValidateICTable(const std::vector<std::string>& deletedNames);
 
     bool CopyFile(const wxString& source, const wxString& destination);
     wxString GetAminoAcidAbbreviation(const wxString& fullName);
@@ -125,7 +143,7 @@ wxEND_EVENT_TABLE()
 
 MyFrame::MyFrame(const wxString& title)
     : wxFrame(NULL, wxID_ANY, title, wxDefaultPosition, wxSize(900, 800)),
-      processor("IC_table_noCGENFF.cpp")
+      processor("IC_table.cpp")
 {
     wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
     
@@ -446,7 +464,9 @@ void MyFrame::OnLoadMolecule(wxCommandEvent& event)
 
     if (molViewer->LoadPDB(pdbPath.ToStdString())) {
         statusText->AppendText("Loaded molecule from: " + pdbPath + "\n");
+        viewerPdbPath = pdbPath;
         UpdateViewerStatus();
+        ValidateICTable(molViewer->GetDeletedAtomNames());
     } else {
         statusText->AppendText("Error: Failed to load molecule from: " + pdbPath + "\n");
         wxMessageBox("Failed to load PDB file.", "Error", wxOK | wxICON_ERROR);
@@ -508,6 +528,7 @@ void MyFrame::OnSelectionChanged(SelectionMode mode, const std::vector<std::stri
         statusText->AppendText("Deleted atoms updated: ");
         for (const auto& n : names) statusText->AppendText(wxString(n) + " ");
         statusText->AppendText("\n");
+        ValidateICTable(names);
     }
 
     std::cout << "OnSelectionChanged completed" << std::endl;
@@ -525,6 +546,48 @@ void MyFrame::UpdateViewerStatus()
     }
 }
 
+// Build the IC table of the viewed molecule without the deleted atoms and
+// rebuild it in-process: the same check psfgen's guesscoord would make
+void MyFrame::ValidateICTable(const std::vector<std::string>& deletedNames)
+{
+    if (viewerPdbPath.IsEmpty())
+        return;
+
+    PdbAtoms pdb;
+    if (!readPdbFile(viewerPdbPath.ToStdString(), pdb))
+        return;
+    std::vector<ICAtom> atoms;
+    for (size_t i = 0; i < pdb.size(); ++i) {
+        std::string name = pdb.name(i);
+        if (std::find(deletedNames.begin(), deletedNames.end(), name) != deletedNames.end())
+            continue;
+        ICAtom atom;
+        atom.name = name;
+        atom.coords[0] = pdb.x[i];
+        atom.coords[1] = pdb.y[i];
+        atom.coords[2] = pdb.z[i];
+        atoms.push_back(atom);
+    }
+    if (atoms.size() < 3)
+        return;
+
+    BondGraph graph;
+    bondGraphFromDistances(atoms, graph);
+    std::vector<ICEntry> entries;
+    buildInternalCoordinates(atoms, graph, entries);
+    ICRebuild rebuild;
+    bool complete = validateICTable(atoms, entries, rebuild);
+
+    statusText->AppendText(wxString::Format("IC table: %d entries, rebuilds %d of %d atoms, RMSD %.4f A\n",
+                                            (int)entries.size(), (int)(atoms.size() - rebuild.unplaced.size()),
+                                            (int)atoms.size(), rebuild.rmsd));
+    if (!complete) {
+        statusText->AppendText("Warning: IC table cannot place:");
+        for (const auto& n : rebuild.unplaced) statusText->AppendText(" " + wxString(n));
+        statusText->AppendText("\n");
+    }
+}
+
 // ── Helper functions (unchanged) ─────────────────────────────────────────────
 
 wxString MyFrame::GetAminoAcidAbbreviation(const wxString& fullName)
@@ -596,6 +659,118 @@ void MyFrame::OnDownloadOneMol2(wxCommandEvent& event)
     }
 }
 
+// Parse an uploaded stream file and summarize its residue and parameters
+bool MyFrame::ReportStreamFile(const wxString& path)
+{
+    CharmmStream stream;
+    if (!stream.open(path.ToStdString()))
+    {
+        statusText->AppendText("Error: Could not read " + path + "\n");
+        return false;
+    }
+    const StrModel& model = stream.model();
+    if (model.residues.empty())
+    {
+        statusText->AppendText("Error: No RESI block in " + path + "\n");
+        wxMessageBox("The uploaded file has no RESI block. Is it a CGenFF stream file?", "Error", wxOK | wxICON_ERROR);
+        return false;
+    }
+
+    const StrResidue& residue = model.residues[0];
+    statusText->AppendText(wxString::Format("Residue %s: %d atoms, %d bonds, charge %.3f\n",
+                                            residue.name.str(), (int)residue.atoms.size(),
+                                            (int)residue.bonds.size(), residue.charge));
+    statusText->AppendText(wxString::Format("Parameters: %d bonds, %d angles, %d dihedrals, %d impropers\n",
+                                            (int)model.bondParams.size(), (int)model.angleParams.size(),
+                                            (int)model.dihedralParams.size(), (int)model.improperParams.size()));
+    if (!residue.comment.empty())
+        statusText->AppendText("CGenFF: " + residue.comment.str() + "\n");
+    for (size_t i = 0; i < model.problems.size(); ++i)
+        statusText->AppendText("Warning: " + model.problems[i] + "\n");
+
+    // Residue name and atom types against the base topology (index cached on disk)
+    const std::string baseFile = "top_all36_cgenff_CBD_template.rtf";
+    if (baseTopology.sourceFile() != baseFile && wxFileExists(baseFile))
+        baseTopology.open(baseFile);
+    if (baseTopology.sourceFile() == baseFile) {
+        if (baseTopology.findResidue(residue.name.str()))
+            statusText->AppendText("Warning: RESI " + residue.name.str() + " is already defined in " + baseFile + "\n");
+        for (size_t a = 0; a < residue.atoms.size(); ++a) {
+            if (!baseTopology.findType(residue.atoms[a].type.str()))
+                statusText->AppendText("Warning: atom type " + residue.atoms[a].type.str() + " of " +
+                                       residue.atoms[a].name.str() + " has no MASS entry in " + baseFile + "\n");
+        }
+    }
+    return true;
+}
+
+// Check the project topology overlay, after a patch maker appended to it,
+// against the base topology
+bool MyFrame::CheckTopologyOverlay()
+{
+    const std::string baseFile = "top_all36_cgenff_CBD_template.rtf";
+    const std::string overlayFile = "top_all36_cgenff_CBD.rtf";
+    if (baseTopology.sourceFile() != baseFile && !baseTopology.open(baseFile))
+    {
+        statusText->AppendText("Error: Could not read " + baseFile + "\n");
+        return false;
+    }
+    std::string overlayText;
+    if (!readTextFile(overlayFile, overlayText) || !validateOverlay(baseTopology, overlayText, overlayFile))
+    {
+        statusText->AppendText("Error: " + overlayFile + " redefines a MASS type or residue of " + baseFile + "\n");
+        return false;
+    }
+    return true;
+}
+
+// Cap removal, charge move and CGenFF to CHARMM36 type renaming of a stream
+// file in memory, with the removed atoms and the type map shown in the
+// status panel
+bool MyFrame::RemoveCaps(const CapRemovalJob& job)
+{
+    statusText->AppendText("Removing caps: " + job.strFile + " -> " + job.outFile + " (" + job.aminoAcid + ")...\n");
+    CapRemovalReport report;
+    if (!removeCaps(job, report))
+        return false;
+    std::ostringstream text;
+    writeCapRemovalReport(report, text);
+    statusText->AppendText(text.str());
+    return true;
+}
+
+// Every bonded term and atom type of the capsid PSF against the parameter
+// files minimize.conf lists, so a missing parameter shows up here rather
+// than as a NAMD abort
+bool MyFrame::CheckCapsidParameters()
+{
+    std::string psfFile;
+    std::vector<std::string> parameterFiles;
+    if (!wxFileExists("minimize.conf") || !namdInputFiles("minimize.conf", psfFile, parameterFiles) ||
+        psfFile.empty() || parameterFiles.empty())
+    {
+        psfFile = "QB_naa_capsid_wb.psf";
+        parameterFiles.assign(1, "par_GUI.prm");
+    }
+    statusText->AppendText("Checking parameters for " + psfFile + "...\n");
+
+    ParameterCheckReport report;
+    if (!checkStructureParameters(psfFile, parameterFiles, report))
+    {
+        statusText->AppendText("Error: Could not read " + psfFile + " or its parameter files.\n");
+        return false;
+    }
+    if (!report.missing.empty())
+    {
+        statusText->AppendText(wxString::Format("Error: %d parameters missing:\n", (int)report.missing.size()));
+        for (size_t i = 0; i < report.missing.size(); i++)
+            statusText->AppendText("  " + describeMissingParameter(report.missing[i]) + "\n");
+        return false;
+    }
+    statusText->AppendText(wxString::Format("All %d type tuples have parameters.\n", (int)report.tuplesChecked));
+    return true;
+}
+
 void MyFrame::OnUploadOneStr(wxCommandEvent& event)
 {
     wxFileDialog openFileDialog(this, "Select one.str file", "", "",
@@ -611,7 +786,8 @@ void MyFrame::OnUploadOneStr(wxCommandEvent& event)
     {
         statusText->AppendText("one.str file uploaded successfully: " + selectedStrPath + "\n");
         statusText->AppendText("File copied to: " + targetPath + "\n");
-        statusText->AppendText("You can now proceed to the next step.\n\n");
+        if (ReportStreamFile(targetPath))
+            statusText->AppendText("You can now proceed to the next step.\n\n");
     }
     else
     {
@@ -672,7 +848,8 @@ void MyFrame::OnUploadNAAStr(wxCommandEvent& event)
     {
         statusText->AppendText("naa.str file uploaded successfully: " + selectedStrPath + "\n");
         statusText->AppendText("File copied to: " + targetPath + "\n");
-        statusText->AppendText("You can now proceed to create and view the capsid.\n\n");
+        if (ReportStreamFile(targetPath))
+            statusText->AppendText("You can now proceed to create and view the capsid.\n\n");
     }
     else
     {
@@ -716,26 +893,21 @@ void MyFrame::OnRunRenaming(wxCommandEvent& event)
 {
     statusText->AppendText("Starting atom renaming process...\n");
     
-    statusText->AppendText("Resetting top_all36_cgenff_CBD.rtf from template...\n");
+    // The base topology is never rewritten: the project's residues and patches
+    // go into a small overlay that the pgn scripts load after it
+    statusText->AppendText("Resetting top_all36_cgenff_CBD.rtf (overlay on top_all36_cgenff_CBD_template.rtf)...\n");
     
-    std::ifstream templateFile("top_all36_cgenff_CBD_template.rtf");
-    if (!templateFile.is_open()) {
-        statusText->AppendText("Error: Failed to open template file top_all36_cgenff_CBD_template.rtf\n");
+    if (!wxFileExists("top_all36_cgenff_CBD_template.rtf")) {
+        statusText->AppendText("Error: Base topology top_all36_cgenff_CBD_template.rtf not found\n");
         return;
     }
     
-    std::ofstream targetFile("top_all36_cgenff_CBD.rtf");
-    if (!targetFile.is_open()) {
+    if (!writeTextFile("top_all36_cgenff_CBD.rtf", emptyOverlay("top_all36_cgenff_CBD_template.rtf"))) {
         statusText->AppendText("Error: Failed to create target file top_all36_cgenff_CBD.rtf\n");
-        templateFile.close();
         return;
     }
     
-    targetFile << templateFile.rdbuf();
-    templateFile.close();
-    targetFile.close();
-    
-    statusText->AppendText("Successfully reset top_all36_cgenff_CBD.rtf from template.\n");
+    statusText->AppendText("Successfully reset top_all36_cgenff_CBD.rtf.\n");
     
     wxString command = "python3 fix_atom_naming_pdb.py";
     statusText->AppendText("Running command: " + command + "\n");
@@ -759,13 +931,10 @@ void MyFrame::OnRunRenaming(wxCommandEvent& event)
         statusText->AppendText("Error: BBS atom renaming script failed. Make sure fix_atom_naming_pdb_BBS.py exists.\n");
         return;
     }
-    statusText->AppendText("Running ./IC_table command...\n");
-    
-    wxString icTableCommand = "/Users/carydarwin/eviVLP/GUI/IC_table_one";
-    int icResult = system(icTableCommand.mb_str());
+    statusText->AppendText("Generating IC table (fixed)...\n");
     
-    if (icResult == 0) {
-        statusText->AppendText("IC_table command executed successfully.\n");
+    if (generateICTable(ICTableJob::defaults(ResidueFixed))) {
+        statusText->AppendText("IC table generated successfully.\n");
         statusText->AppendText("Atom renaming process completed successfully!\n");
 
         // Auto-load the renamed molecule into the viewer
@@ -776,7 +945,7 @@ void MyFrame::OnRunRenaming(wxCommandEvent& event)
             }
         }
     } else {
-        statusText->AppendText("Error: IC_table command failed. Make sure IC_table executable exists and has proper permissions.\n");
+        statusText->AppendText("Error: IC table generation failed. Check one.str, one.pdb and top_all36_cgenff_CBD.rtf.\n");
     }
 }
 
@@ -945,6 +1114,8 @@ void MyFrame::OnProcessPatchMaker(wxCommandEvent& event)
         
         if (result == 0) {
             statusText->AppendText("Patch maker script executed successfully.\n");
+            if (!CheckTopologyOverlay())
+                return;
             
             statusText->AppendText("Resetting patch maker file...\n");
             processor.ResetPatchMakerFile(std::string(selectedAminoAcid.mb_str()));
@@ -1001,6 +1172,8 @@ void MyFrame::OnProcessPatchMaker(wxCommandEvent& event)
                     return;
                 }
                 statusText->AppendText("N-terminus patch maker executed successfully.\n");
+                if (!CheckTopologyOverlay())
+                    return;
                 
                 // Reset the ntrm patch maker template
                 processor.ResetPatchMakerFile("N-Terminus");
@@ -1049,6 +1222,10 @@ void MyFrame::OnCreateTopology(wxCommandEvent& event)
 {
     statusText->AppendText("Starting final processing...\n");
     
+    int selection = aminoAcidChoice->GetSelection();
+    wxString selectedAminoAcid = aminoAcidChoice->GetString(selection);
+    wxString aminoAcidAbbrev = GetAminoAcidAbbreviation(selectedAminoAcid);
+    
     // --- NAA path (existing) ---
     wxString command1 = "python3 noX.py";
     statusText->AppendText("Running command: " + command1 + "\n");
@@ -1060,25 +1237,11 @@ void MyFrame::OnCreateTopology(wxCommandEvent& event)
     }
     statusText->AppendText("noX.py executed successfully.\n");
     
-    wxString command2 = "python3 noX_psf.py";
-    statusText->AppendText("Running command: " + command2 + "\n");
-    int result2 = system(command2.mb_str());
-    
-    if (result2 != 0) {
-        statusText->AppendText("Error: noX_psf.py failed.\n");
-        return;
-    }
-    statusText->AppendText("noX_psf.py executed successfully.\n");
-    
-    wxString renameTypes = "python3 rename_atom_types_naa.py " + aminoAcidAbbrev + " nad.str";
-    statusText->AppendText("Running command: " + renameTypes + "\n");
-    int renameResult = system(renameTypes.mb_str());
-    
-    if (renameResult != 0) {
-        statusText->AppendText("Error: rename_atom_types_naa.py failed.\n");
+    if (!RemoveCaps(CapRemovalJob::defaults(ResidueNaa, aminoAcidAbbrev.ToStdString()))) {
+        statusText->AppendText("Error: Cap removal and atom type renaming of naa.str failed.\n");
         return;
     }
-    statusText->AppendText("Atom type renaming executed successfully.\n");
+    statusText->AppendText("nad.str written.\n");
     
     wxString command0 = "python3 fix_atom_naming_pdb_naa.py";
     statusText->AppendText("Running command: " + command0 + "\n");
@@ -1090,20 +1253,14 @@ void MyFrame::OnCreateTopology(wxCommandEvent& event)
     }
     statusText->AppendText("fix_atom_naming_pdb_naa.py executed successfully.\n");
     
-    wxString command3 = "./IC_naa";
-    statusText->AppendText("Running command: " + command3 + "\n");
-    int result3 = system(command3.mb_str());
-    
-    if (result3 != 0) {
-        statusText->AppendText("Error: IC_naa failed.\n");
+    statusText->AppendText("Generating IC table (naa)...\n");
+    if (!generateICTable(ICTableJob::defaults(ResidueNaa))) {
+        statusText->AppendText("Error: IC table generation for nad.str failed.\n");
         return;
     }
-    statusText->AppendText("IC_naa executed successfully.\n");
+    statusText->AppendText("IC table for nad.str generated successfully.\n");
     
     // --- NPC path (N-terminus, for Lysine) ---
-    int selection = aminoAcidChoice->GetSelection();
-    wxString selectedAminoAcid = aminoAcidChoice->GetString(selection);
-    
     if (selectedAminoAcid == "Lysine") {
         wxString ntrmNoX = "python3 noX_ntrm.py";
         statusText->AppendText("Running command: " + ntrmNoX + "\n");
@@ -1115,35 +1272,11 @@ void MyFrame::OnCreateTopology(wxCommandEvent& event)
         }
         statusText->AppendText("noX_ntrm.py executed successfully.\n");
         
-        wxString ntrmNoXPsf = "python3 noX_psf_ntrm.py";
-        statusText->AppendText("Running command: " + ntrmNoXPsf + "\n");
-        int ntrmNoXPsfResult = system(ntrmNoXPsf.mb_str());
-        
-        if (ntrmNoXPsfResult != 0) {
-            statusText->AppendText("Error: noX_psf_ntrm.py failed.\n");
-            return;
-        }
-        statusText->AppendText("noX_psf_ntrm.py executed successfully.\n");
-        
-        wxString chargeFix = "python3 charge_fix_ntrm.py";
-        statusText->AppendText("Running command: " + chargeFix + "\n");
-        int chargeFixResult = system(chargeFix.mb_str());
-        
-        if (chargeFixResult != 0) {
-            statusText->AppendText("Error: charge_fix_ntrm.py failed.\n");
-            return;
-        }
-    statusText->AppendText("charge_fix_ntrm.py executed successfully.\n");
-
-        wxString renameTypes = "python3 rename_atom_types_naa.py ntrm ntrm_clean.str";
-        statusText->AppendText("Running command: " + renameTypes + "\n");
-        int renameResult = system(renameTypes.mb_str());
-        
-        if (renameResult != 0) {
-            statusText->AppendText("Error: rename_atom_types_naa.py failed.\n");
+        if (!RemoveCaps(CapRemovalJob::defaults(ResidueNtrm, "ntrm"))) {
+            statusText->AppendText("Error: Cap removal and atom type renaming of ntrm.str failed.\n");
             return;
         }
-        statusText->AppendText("rename_atom_types_naa.py executed successfully.\n");
+        statusText->AppendText("ntrm_clean.str written.\n");
 
         wxString ntrmFixNaming = "python3 fix_atom_naming_pdb_ntrm.py";
         statusText->AppendText("Running command: " + ntrmFixNaming + "\n");
@@ -1155,25 +1288,25 @@ void MyFrame::OnCreateTopology(wxCommandEvent& event)
         }
         statusText->AppendText("fix_atom_naming_pdb_ntrm.py executed successfully.\n");
         
-        wxString addParams = "python3 add_npc_params_to_prm.py";
-        statusText->AppendText("Running command: " + addParams + "\n");
-        int addParamsResult = system(addParams.mb_str());
-
-        if (addParamsResult != 0) {
-            statusText->AppendText("Error: add_npc_params_to_prm.py failed.\n");
+        statusText->AppendText("Merging ntrm_clean.str parameters into par_GUI.prm...\n");
+        ParameterMergeOptions mergeOptions;
+        ParameterMergeOptions::defaults("npc", mergeOptions);
+        ParameterMergeReport mergeReport;
+        if (!mergeStreamParameters("ntrm_clean.str", "par_GUI.prm", mergeOptions, mergeReport)) {
+            statusText->AppendText("Error: Merging ntrm_clean.str parameters into par_GUI.prm failed.\n");
             return;
         }
-statusText->AppendText("NPC cross-FF parameters added to par_GUI.prm.\n");
-
-        wxString ntrmIC = "./IC_ntrm_NPC";
-        statusText->AppendText("Running command: " + ntrmIC + "\n");
-        int ntrmICResult = system(ntrmIC.mb_str());
-        
-        if (ntrmICResult != 0) {
-            statusText->AppendText("Error: IC_ntrm_NPC failed.\n");
+        for (size_t i = 0; i < mergeReport.conflicts.size(); ++i)
+            statusText->AppendText("Warning: " + mergeReport.conflicts[i] + "\n");
+        statusText->AppendText(wxString::Format("NPC cross-FF parameters added to par_GUI.prm: %d new, %d already present.\n",
+                                                mergeReport.added, mergeReport.duplicates));
+
+        statusText->AppendText("Generating IC table (ntrm)...\n");
+        if (!generateICTable(ICTableJob::defaults(ResidueNtrm))) {
+            statusText->AppendText("Error: IC table generation for ntrm_clean.str failed.\n");
             return;
         }
-        statusText->AppendText("IC_ntrm_NPC executed successfully.\n");
+        statusText->AppendText("IC table for ntrm_clean.str generated successfully.\n");
     }
     
     statusText->AppendText("Final processing completed successfully!\n");
@@ -1336,6 +1469,10 @@ void MyFrame::OnMinimizeCapsid(wxCommandEvent& event)
     wxString command9 = "~/Downloads/NAMD_3.0b5_MacOS-universal-multicore/namd3 +p8 minimize.conf output.log";
     
     statusText->AppendText("Minimize Capsid button clicked!\n");
+    if (!CheckCapsidParameters()) {
+        statusText->AppendText("Error: Minimization not started.\n");
+        return;
+    }
     statusText->AppendText("Running command: " + command9 + "\n");
     
     int result = system(command9.mb_str());
@@ -1356,6 +1493,7 @@ void MyFrame::OnZipFiles(wxCommandEvent& event)
     filesToZip.Add("QB_naa_capsid_wb.psf");
     filesToZip.Add("QB_naa_capsid_wb.pdb");
     filesToZip.Add("par_GUI.prm");
+    filesToZip.Add("top_all36_cgenff_CBD_template.rtf");
     filesToZip.Add("top_all36_cgenff_CBD.rtf");
     
     bool allFilesExist = true;
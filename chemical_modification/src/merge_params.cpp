@@ -0,0 +1,148 @@
+#include <iostream>       // Input-output stream library
+#include <string>         // String library
+#include <vector>         // Vector container
+#include "Logger.h"       // Leveled logging
+#include "ParameterStore.h" // par_GUI.prm parsing and merging
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <naa|npc> <str_file> [prm_file]\n"
+         << "       " << program << " --dedupe [prm_file]\n"
+         << "  naa, npc  add the cross-force-field parameters of str_file to prm_file,\n"
+         << "            skipping those already present (npc defaults to ntrm_clean.str)\n"
+         << "  --dedupe  rewrite prm_file without entries repeating the types and\n"
+         << "            values of an earlier one (comments are not compared)\n"
+         << "  --self-check  run the lookup and merge checks on built-in parameters\n"
+         << "prm_file defaults to par_GUI.prm\n";
+}
+
+// One lookup of the self-check: types should resolve to the entry whose
+// line starts with expected ("" for no match)
+static bool expectLookup(const ParameterStore& store, ParameterSection section, const string& tuple,
+                         const string& expected) {
+    vector<string> types;
+    size_t pos = 0;
+    while (pos < tuple.size()) {
+        size_t end = tuple.find(' ', pos);
+        if (end == string::npos) end = tuple.size();
+        types.push_back(tuple.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    vector<const ParameterEntry*> terms;
+    string found = store.lookup(section, types, terms) ? terms[0]->text.substr(0, expected.size()) : "";
+    if (found == expected) return true;
+    cerr << parameterSectionName(section) << " " << tuple << ": expected '" << expected << "', found '" << found
+         << "'" << endl;
+    return false;
+}
+
+// Wildcard lookups in both orientations of each tuple
+static int selfCheck() {
+    ParameterStore store;
+    store.parse("DIHEDRALS\n"
+                "X    CB   CC   X        0.5000  2   180.00\n"
+                "IMPROPERS\n"
+                "AA   X    X    AD      10.0000  0     0.00\n"
+                "X    IB   IC   ID      20.0000  0     0.00\n"
+                "X    X    JC   JD      30.0000  0     0.00\n"
+                "END\n");
+    int failures = 0;
+    failures += !expectLookup(store, ParamDihedrals, "CA CB CC CD", "X    CB   CC");
+    failures += !expectLookup(store, ParamDihedrals, "CD CC CB CA", "X    CB   CC");
+    failures += !expectLookup(store, ParamImpropers, "AA AB AC AD", "AA   X");
+    failures += !expectLookup(store, ParamImpropers, "AD AC AB AA", "AA   X");
+    failures += !expectLookup(store, ParamImpropers, "IA IB IC ID", "X    IB");
+    failures += !expectLookup(store, ParamImpropers, "ID IC IB IA", "X    IB");
+    failures += !expectLookup(store, ParamImpropers, "JA JB JC JD", "X    X    JC");
+    failures += !expectLookup(store, ParamImpropers, "JD JC JB JA", "X    X    JC");
+    failures += !expectLookup(store, ParamImpropers, "IA IB ID IC", "");
+    cout << "Lookup self-check: " << (failures ? "FAILED" : "passed") << endl;
+    return failures ? 1 : 0;
+}
+
+// Number of terms lookup finds for a dihedral
+static size_t dihedralTerms(const ParameterStore& store, const string& a, const string& b, const string& c,
+                            const string& d) {
+    string tuple[] = {a, b, c, d};
+    vector<const ParameterEntry*> terms;
+    store.lookup(ParamDihedrals, vector<string>(tuple, tuple + 4), terms);
+    return terms.size();
+}
+
+// Dihedrals merge by tuple: another set of multiplicities for a tuple
+// already present is a conflict, a new tuple brings all of its terms
+static int mergeSelfCheck() {
+    ParameterStore target, source;
+    target.parse("DIHEDRALS\n"
+                 "DA   DB   DC   DD       0.2000  2   180.00\n"
+                 "EA   EB   EC   ED       0.2000  2   180.00\n"
+                 "EA   EB   EC   ED       0.1000  3     0.00\n"
+                 "END\n");
+    source.parse("DIHEDRALS\n"
+                 "DA   DB   DC   DD       0.2000  2   180.00\n"
+                 "DA   DB   DC   DD       0.1000  3     0.00\n"
+                 "ED   EC   EB   EA       0.1000  3     0.00\n"
+                 "EA   EB   EC   ED       0.2000  2   180.00\n"
+                 "FA   FB   FC   FD       0.3000  1     0.00\n"
+                 "FA   FB   FC   FD       0.4000  2     0.00\n"
+                 "END\n");
+    ParameterMergeOptions options;
+    options.label = "self-check";
+    ParameterMergeReport report;
+    target.merge(source, options, report);
+
+    bool passed = report.added == 2 && report.duplicates == 2 && report.conflicts.size() == 1 &&
+                  dihedralTerms(target, "DA", "DB", "DC", "DD") == 1 &&
+                  dihedralTerms(target, "EA", "EB", "EC", "ED") == 2 &&
+                  dihedralTerms(target, "FA", "FB", "FC", "FD") == 2;
+    if (!passed) {
+        cerr << "Merge: " << report.added << " added, " << report.duplicates << " duplicates, "
+             << report.conflicts.size() << " conflicts" << endl;
+        for (size_t i = 0; i < report.conflicts.size(); ++i) cerr << "  " << report.conflicts[i] << endl;
+    }
+    cout << "Merge self-check: " << (passed ? "passed" : "FAILED") << endl;
+    return passed ? 0 : 1;
+}
+
+//Run using: g++ -std=c++11 -o merge_params merge_params.cpp ParameterStore.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string mode = argv[1];
+    if (mode == "--self-check") return selfCheck() | mergeSelfCheck();
+
+    if (mode == "--dedupe") {
+        string prmFile = argc > 2 ? argv[2] : "par_GUI.prm";
+        ParameterStore parameters;
+        if (!parameters.load(prmFile)) return 1;
+        cout << prmFile << ": " << parameters.duplicatesDropped() << " duplicates removed, "
+             << parameters.conflicts().size() << " conflicting entries kept" << endl;
+        return parameters.save(prmFile) ? 0 : 1;
+    }
+
+    ParameterMergeOptions options;
+    if (!ParameterMergeOptions::defaults(mode, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string strFile = argc > 2 ? argv[2] : (mode == "npc" ? "ntrm_clean.str" : "");
+    string prmFile = argc > 3 ? argv[3] : "par_GUI.prm";
+    if (strFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ParameterMergeReport report;
+    if (!mergeStreamParameters(strFile, prmFile, options, report)) return 1;
+    cout << "Parameters added to " << prmFile << ": " << report.added << " (" << report.duplicates
+         << " already present, " << report.skipped << " protein-only, " << report.conflicts.size()
+         << " conflicts)" << endl;
+    return 0;
+}
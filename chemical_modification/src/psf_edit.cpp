@@ -0,0 +1,76 @@
+#include <iostream>       // Input-output stream library
+#include <cstdlib>        // strtod
+#include <string>         // String library
+#include <vector>         // Vector container
+#include "Logger.h"       // Leveled logging
+#include "PsfFile.h"      // PSF reading, editing and writing
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <in_psf> <out_psf> [edits...]\n"
+         << "  --delete SEGID:RESID:NAME         remove the atom and every term naming it\n"
+         << "  --delete-caps                     remove all atoms whose names contain X\n"
+         << "  --charge SEGID:RESID:NAME=CHARGE  set the atom's charge\n"
+         << "  Edits are applied in order; the structure is renumbered and written once\n";
+}
+
+// "SEGID:RESID:NAME" to the atom's index, -1 with a message if there is none
+static long atomIndex(const PsfFile& psf, const string& spec) {
+    size_t first = spec.find(':'), second = spec.find(':', first + 1);
+    if (first == string::npos || second == string::npos) {
+        cerr << "Expected SEGID:RESID:NAME, got " << spec << endl;
+        return -1;
+    }
+    long atom = psf.findAtom(spec.substr(0, first), spec.substr(first + 1, second - first - 1), spec.substr(second + 1));
+    if (atom < 0) cerr << "No atom " << spec << endl;
+    return atom;
+}
+
+//Run using: g++ -std=c++11 -O2 -o psf_edit psf_edit.cpp PsfFile.cpp CharmmStream.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    PsfFile psf;
+    if (!psf.load(argv[1])) return 1;
+    double charge = psf.totalCharge();
+
+    for (int i = 3; i < argc; ++i) {
+        string edit = argv[i];
+        if (edit == "--delete-caps") {
+            vector<bool> doomed(psf.atomCount(), false);
+            for (size_t a = 0; a < psf.atomCount(); ++a) doomed[a] = psf.text(psf.names[a]).find('X') != string::npos;
+            cout << "Removed " << psf.deleteAtoms(doomed) << " cap atoms" << endl;
+        } else if ((edit == "--delete" || edit == "--charge") && i + 1 < argc) {
+            string spec = argv[++i];
+            size_t equals = spec.find('=');
+            if (edit == "--charge" && equals == string::npos) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            long atom = atomIndex(psf, spec.substr(0, equals));
+            if (atom < 0) return 1;
+            if (edit == "--delete") {
+                vector<bool> doomed(psf.atomCount(), false);
+                doomed[atom] = true;
+                psf.deleteAtoms(doomed);
+            } else {
+                psf.charges[atom] = strtod(spec.c_str() + equals + 1, NULL);
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!psf.save(argv[2])) return 1;
+    cout << argv[2] << ": " << psf.atomCount() << " atoms, total charge " << psf.totalCharge() << " (was " << charge
+         << ")" << endl;
+    return 0;
+}
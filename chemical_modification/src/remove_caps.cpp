@@ -0,0 +1,42 @@
+#include <iostream>       // Input-output stream library
+#include <cctype>         // Character classification
+#include <string>         // String library
+#include "CapRemoval.h"   // Cap removal, charge move and type renaming
+#include "Logger.h"       // Leveled logging
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " naa <lys|cys|tyr>\n"
+         << "       " << program << " ntrm\n"
+         << "  naa   naa.pdb + naa.str -> nad.str\n"
+         << "  ntrm  ntrm_fixed.pdb + ntrm.str -> ntrm_clean.str, moving the HX charge to C\n"
+         << "  Removes the cap atoms (names with X) and their bonds, then renames the\n"
+         << "  protein-side CGenFF atom types to CHARMM36\n";
+}
+
+//Run using: g++ -std=c++11 -o remove_caps remove_caps.cpp CapRemoval.cpp AtomTypeRenamer.cpp ICTable.cpp ICBuilder.cpp CharmmStream.cpp TopologyStore.cpp TopologyOverlay.cpp PdbReader.cpp Subprocess.cpp InternalCoordinates.cpp GeometryCache.cpp GeometryKernels.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    string kind = argc > 1 ? argv[1] : "";
+    CapRemovalJob job;
+    if (kind == "naa" && argc == 3) {
+        string aminoAcid = argv[2];
+        for (size_t i = 0; i < aminoAcid.size(); ++i) aminoAcid[i] = (char)tolower((unsigned char)aminoAcid[i]);
+        job = CapRemovalJob::defaults(ResidueNaa, aminoAcid);
+    } else if (kind == "ntrm" && argc == 2) {
+        job = CapRemovalJob::defaults(ResidueNtrm, "ntrm");
+    } else {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    CapRemovalReport report;
+    if (!removeCaps(job, report)) return 1;
+    cout << job.strFile << " -> " << job.outFile << "\n";
+    writeCapRemovalReport(report, cout);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include <iostream>       // Input-output stream library
+#include <cctype>         // Character classification
+#include <string>         // String library
+#include "AtomTypeRenamer.h" // CGenFF to CHARMM36 type renaming
+#include "Logger.h"       // Leveled logging
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <lys|cys|tyr|ntrm> [str_file]\n"
+         << "  Renames the protein-side CGenFF atom types of str_file to CHARMM36 types\n"
+         << "  str_file defaults to naa_clean.str (ntrm_clean.str for ntrm)\n";
+}
+
+//Run using: g++ -std=c++11 -o rename_atom_types rename_atom_types.cpp AtomTypeRenamer.cpp ICTable.cpp ICBuilder.cpp CharmmStream.cpp TopologyStore.cpp TopologyOverlay.cpp PdbReader.cpp Subprocess.cpp InternalCoordinates.cpp GeometryCache.cpp GeometryKernels.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc < 2 || argc > 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string aminoAcid = argv[1];
+    for (size_t i = 0; i < aminoAcid.size(); ++i) aminoAcid[i] = (char)tolower((unsigned char)aminoAcid[i]);
+    string strFile = argc > 2 ? argv[2] : (aminoAcid == "ntrm" ? "ntrm_clean.str" : "naa_clean.str");
+
+    TypeRenameReport report;
+    if (!renameAtomTypesInFile(aminoAcid, strFile, report)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    cout << "Renamed " << strFile << " for " << aminoAcid << "\n";
+    writeTypeRenameReport(report, cout);
+    return 0;
+}
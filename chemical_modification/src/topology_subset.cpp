@@ -0,0 +1,104 @@
+#include <cstdio>         // remove
+#include <fstream>        // File streams
+#include <iostream>       // Input-output stream library
+#include <sstream>        // String streams
+#include <string>         // String library
+#include <vector>         // Vector container
+#include "Logger.h"       // Leveled logging
+#include "TopologyStore.h" // Indexed topology files
+
+using namespace std;    // Standard namespace for C++ libraries
+
+// Print command-line usage
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <rtf_file> <out_file> <residue>...\n"
+         << "       " << program << " --self-check\n"
+         << "  Writes a standalone topology file with only the named RESI/PRES entries\n"
+         << "  of rtf_file and the MASS lines of the atom types they use\n"
+         << "  --self-check  write a subset of a built-in topology and read it back\n";
+}
+
+static bool writeSubsetFile(const TopologyStore& store, const vector<string>& residues, const string& outFile) {
+    ofstream out(outFile.c_str(), ios::out | ios::binary);
+    if (!out || !store.writeSubset(residues, out)) return false;
+    out.close();
+    return !out.fail();
+}
+
+// Same atoms, types and charges in both stores
+static bool sameResidue(const TopologyStore& a, const TopologyStore& b, const string& name) {
+    const TopologyResidue* ra = a.findResidue(name);
+    const TopologyResidue* rb = b.findResidue(name);
+    if (!ra || !rb || ra->patch != rb->patch || ra->atomCount != rb->atomCount) return false;
+    for (uint32_t i = 0; i < ra->atomCount; ++i) {
+        const TopologyAtom& x = a.atoms()[ra->firstAtom + i];
+        const TopologyAtom& y = b.atoms()[rb->firstAtom + i];
+        if (x.name != y.name || x.type != y.type || x.charge != y.charge) return false;
+        const TopologyType* type = b.findType(y.type);
+        if (!type || type->mass != a.findType(x.type)->mass) return false;
+    }
+    return true;
+}
+
+// A subset of a small topology, reopened through TopologyStore::open
+static int selfCheck() {
+    const string baseFile = "topology_subset_check.rtf";
+    const string subsetFile = "topology_subset_check_out.rtf";
+    ofstream base(baseFile.c_str());
+    base << "* self-check topology\n*\n36  1\n\n"
+         << "MASS  -1  CG331     12.01100 C ! aliphatic C for methyl group (-CH3)\n"
+         << "MASS  -1  HGA3       1.00800 H ! alphatic proton, CH3\n"
+         << "MASS  -1  OG311     15.99940 O ! hydroxyl oxygen\n"
+         << "MASS  -1  HGP1       1.00800 H ! polar H\n\n"
+         << "DEFA FIRS NONE LAST NONE\nAUTO ANGLES DIHE\n\n"
+         << "RESI MET        0.000\nGROUP\nATOM C1   CG331   -0.270\nATOM H1   HGA3     0.090\n"
+         << "ATOM H2   HGA3     0.090\nATOM H3   HGA3     0.090\nBOND C1 H1 C1 H2 C1 H3\n\n"
+         << "RESI WAT        0.000\nGROUP\nATOM O1   OG311   -0.650\nATOM H1   HGP1     0.325\n"
+         << "ATOM H2   HGP1     0.325\nBOND O1 H1 O1 H2\n\n"
+         << "PRES DEH       -0.090\nGROUP\nATOM C1   CG331   -0.180\nDELETE ATOM H3\n\n"
+         << "END\n";
+    base.close();
+
+    bool passed = false;
+    TopologyStore store, subset;
+    vector<string> residues;
+    residues.push_back("MET");
+    residues.push_back("DEH");
+    if (store.open(baseFile) && writeSubsetFile(store, residues, subsetFile) && subset.open(subsetFile)) {
+        ifstream in(subsetFile.c_str());
+        ostringstream text;
+        text << in.rdbuf();
+        passed = sameResidue(store, subset, "MET") && sameResidue(store, subset, "DEH") &&
+                 !subset.findResidue("WAT") && subset.residues().size() == 2 && subset.types().size() == 2 &&
+                 !subset.findType("OG311") && text.str().find(topologyDefaults) != string::npos;
+    }
+    const string files[] = {baseFile, subsetFile};
+    for (int i = 0; i < 2; ++i) {
+        remove(files[i].c_str());
+        remove(TopologyStore::cacheFile(files[i]).c_str());
+    }
+    cout << "Topology subset self-check: " << (passed ? "passed" : "FAILED") << endl;
+    return passed ? 0 : 1;
+}
+
+//Run using: g++ -std=c++11 -o topology_subset topology_subset.cpp TopologyStore.cpp CharmmStream.cpp Logger.cpp
+// Main function
+int main(int argc, char* argv[]) {
+    Logger::instance().configureFromEnvironment();
+
+    if (argc == 2 && string(argv[1]) == "--self-check") return selfCheck();
+    if (argc < 4) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    TopologyStore store;
+    if (!store.open(argv[1])) return 1;
+    vector<string> residues(argv + 3, argv + argc);
+    if (!writeSubsetFile(store, residues, argv[2])) {
+        cerr << "Could not write " << argv[2] << endl;
+        return 1;
+    }
+    cout << residues.size() << " residues of " << argv[1] << " written to " << argv[2] << endl;
+    return 0;
+}
@@ -1,3 +1,4 @@
+import re
 import numpy as np
 
 def load_pdb_coordinates(pdb_file):
@@ -22,33 +23,90 @@ def save_pdb_coordinates(pdb_file, atoms, new_coordinates):
             file.write(f"{atom[:30]}{x:8.3f}{y:8.3f}{z:8.3f}{atom[54:]}")
     print(f"Transformed PDB saved to {pdb_file}")
 
+def load_model_coordinates(ensemble_file, model, template_pdb):
+    """Load model `model` (1-based) of a conformer ensemble.
+
+    A PDB ensemble gives the records between its model-th MODEL and ENDMDL
+    (the whole file if it has no MODEL records; records outside MODEL/ENDMDL
+    are ignored otherwise, as readConformers does). An XYZ ensemble gives the
+    model-th frame's coordinates on the records of template_pdb, which must
+    list the same atoms in the same order.
+    """
+    if ensemble_file.lower().endswith((".pdb", ".ent")):
+        atoms = []
+        coordinates = []
+        current = 0
+        in_model = False
+        with open(ensemble_file, 'r') as file:
+            lines = file.readlines()
+        has_models = any(line.startswith("MODEL") for line in lines)
+        for line in lines:
+            if line.startswith("MODEL"):
+                current += 1
+                in_model = True
+            elif line.startswith("ENDMDL"):
+                in_model = False
+            elif line.startswith(("ATOM", "HETATM")) and ((in_model and current == model) or not has_models):
+                atoms.append(line)
+                coordinates.append([float(line[30:38]), float(line[38:46]), float(line[46:54])])
+        if not atoms:
+            raise ValueError(f"{ensemble_file} has no model {model}")
+        return atoms, np.array(coordinates)
+
+    atoms, _ = load_pdb_coordinates(template_pdb)
+    with open(ensemble_file, 'r') as file:
+        lines = [line for line in file]
+    position = 0
+    for frame in range(1, model + 1):
+        while lines[position].strip() == "":
+            position += 1
+        count = int(lines[position].split()[0])
+        if frame == model:
+            rows = lines[position + 2:position + 2 + count]
+            coordinates = np.array([[float(v) for v in row.split()[1:4]] for row in rows])
+        position += count + 2
+    if len(atoms) != len(coordinates):
+        raise ValueError(f"Frame {model} of {ensemble_file} has {len(coordinates)} atoms, "
+                         f"{template_pdb} has {len(atoms)}")
+    return atoms, coordinates
+
+def transform_source(rotation_matrix_file):
+    """Ensemble file and 1-based model the transform was found for, from the
+    "Transform from model k of <file> to ..." header the ensemble search
+    writes; (None, None) for a single-structure search."""
+    with open(rotation_matrix_file, 'r') as file:
+        header = file.readline()
+    match = re.match(r"#\s*Transform from model (\d+) of (.+) to \S+\s*$", header)
+    if not match:
+        return None, None
+    return match.group(2), int(match.group(1))
+
 def load_rotation_matrix(rotation_matrix_file):
-    """Load a 4x4 rotation matrix from a text file."""
+    """Load a 4x4 homogeneous transform written by the rotate program."""
     return np.loadtxt(rotation_matrix_file)
 
 def transform_pdb(pdb_file, output_file, rotation_matrix_file):
-    """Translate to origin, invert the matrix, rotate, and translate back."""
-    atoms, coordinates = load_pdb_coordinates(pdb_file)
+    """Apply the placement transform (pivot translation already included).
 
-    # Load the rotation matrix from the file
-    rotation_matrix = load_rotation_matrix(rotation_matrix_file)
-
-    # Calculate translation to origin
-    translation_vector = -coordinates[0]
+    When the transform came from an ensemble search it is applied to the
+    winning model of the ensemble rather than to pdb_file.
+    """
+    ensemble_file, model = transform_source(rotation_matrix_file)
+    if ensemble_file is not None:
+        print(f"Transform was found for model {model} of {ensemble_file}")
+        atoms, coordinates = load_model_coordinates(ensemble_file, model, pdb_file)
+    else:
+        atoms, coordinates = load_pdb_coordinates(pdb_file)
 
-    # Translate to origin
-    translated_coordinates = coordinates + translation_vector
+    # Load the transform from the file
+    rotation_matrix = load_rotation_matrix(rotation_matrix_file)
 
-    # Apply the inverted rotation
     # Extend 3D coordinates to homogeneous coordinates for 4x4 matrix multiplication
-    homogeneous_coordinates = np.hstack([translated_coordinates, np.ones((translated_coordinates.shape[0], 1))])
-    rotated_homogeneous = np.dot(homogeneous_coordinates, rotation_matrix.T)
+    homogeneous_coordinates = np.hstack([coordinates, np.ones((coordinates.shape[0], 1))])
+    transformed_homogeneous = np.dot(homogeneous_coordinates, rotation_matrix.T)
 
     # Convert back to 3D coordinates
-    rotated_coordinates = rotated_homogeneous[:, :3]
-
-    # Translate back to the original position
-    final_coordinates = rotated_coordinates - translation_vector
+    final_coordinates = transformed_homogeneous[:, :3]
 
     # Save the transformed coordinates
     save_pdb_coordinates(output_file, atoms, final_coordinates)
@@ -0,0 +1,660 @@
+#include "CapsidIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+// The int16 copies hold offsets of at most quantRange steps from their
+// cell's corner, and the screens only take query offsets below
+// maxQueryOffset steps (farther cells are checked in double), so every
+// axis difference stays below their sum, rounding included, and the sum
+// of three squares fits in int32 whatever the cell size
+static const int quantRange = 10000;
+static const int maxQueryOffset = 16000;
+static_assert(3LL * (quantRange + maxQueryOffset + 2) * (quantRange + maxQueryOffset + 2) <= INT_MAX,
+              "int16 screen distances must fit in int32");
+
+// Spread the low 21 bits of v so there are two zero bits between each
+static uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8)  & 0x100f00f00f00f00fULL;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2)  & 0x1249249249249249ULL;
+    return v;
+}
+
+static uint64_t mortonKey(int cx, int cy, int cz) {
+    return spreadBits(cx) | (spreadBits(cy) << 1) | (spreadBits(cz) << 2);
+}
+
+// Nearest integer; floor(v + 0.5) inlines where lround is a library call
+static inline int quantize(double v) {
+    return (int)floor(v + 0.5);
+}
+
+int CapsidIndex::cellCoord(double value, int axis) const {
+    int c = (int)floor((value - origin[axis]) / cellSize);
+    if (c < 0) return 0;
+    if (c >= dims[axis]) return dims[axis] - 1;
+    return c;
+}
+
+// Function to bucket the capsid atoms into Morton-ordered grid cells
+void CapsidIndex::build(const vector<Atom>& atoms, double cellSizeIn) {
+    cellSize = cellSizeIn;
+    int n = (int)atoms.size();
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    order.resize(n);
+    element.resize(n);
+
+    double lo[3] = {0.0, 0.0, 0.0}, hi[3] = {0.0, 0.0, 0.0};
+    if (n > 0) {
+        for (int k = 0; k < 3; ++k) lo[k] = hi[k] = atoms[0].coords[k];
+    }
+    for (int i = 1; i < n; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = min(lo[k], atoms[i].coords[k]);
+            hi[k] = max(hi[k], atoms[i].coords[k]);
+        }
+    }
+    // Grow the cells if the table would be much larger than the atom count
+    const double maxCells = max(8.0 * n, 262144.0);
+    while (true) {
+        double cells = 1.0;
+        for (int k = 0; k < 3; ++k) {
+            origin[k] = lo[k];
+            dims[k] = (int)floor((hi[k] - lo[k]) / cellSize) + 1;
+            cells *= dims[k];
+        }
+        if (cells <= maxCells) break;
+        cellSize *= 1.25;
+    }
+    numCells = dims[0] * dims[1] * dims[2];
+
+    // Sort atoms by the Morton key of their cell (ties keep file order)
+    vector<pair<uint64_t, int> > keys(n);
+    for (int i = 0; i < n; ++i) {
+        int cx = cellCoord(atoms[i].coords[0], 0);
+        int cy = cellCoord(atoms[i].coords[1], 1);
+        int cz = cellCoord(atoms[i].coords[2], 2);
+        keys[i] = make_pair(mortonKey(cx, cy, cz), i);
+    }
+    sort(keys.begin(), keys.end());
+
+    // 0.01 A steps unless the cells had to grow past quantRange of them
+    quantStep = max(0.01, cellSize / quantRange);
+    const double invStep = 1.0 / quantStep;
+    qx.resize(n);
+    qy.resize(n);
+    qz.resize(n);
+    fx.resize(n);
+    fy.resize(n);
+    fz.resize(n);
+    double maxAbs = 0.0;
+
+    cellStart.assign(numCells, 0);
+    cellEnd.assign(numCells, 0);
+    for (int i = 0; i < n; ++i) {
+        const Atom& atom = atoms[keys[i].second];
+        order[i] = keys[i].second;
+        element[i] = (uint8_t)elementCode(atom.type);
+        x[i] = atom.coords[0];
+        y[i] = atom.coords[1];
+        z[i] = atom.coords[2];
+
+        int cx = cellCoord(x[i], 0), cy = cellCoord(y[i], 1), cz = cellCoord(z[i], 2);
+        qx[i] = (int16_t)quantize((x[i] - origin[0]) * invStep - cx * cellSize * invStep);
+        qy[i] = (int16_t)quantize((y[i] - origin[1]) * invStep - cy * cellSize * invStep);
+        qz[i] = (int16_t)quantize((z[i] - origin[2]) * invStep - cz * cellSize * invStep);
+
+        fx[i] = (float)x[i];
+        fy[i] = (float)y[i];
+        fz[i] = (float)z[i];
+        maxAbs = max(maxAbs, max(fabs(x[i]), max(fabs(y[i]), fabs(z[i]))));
+
+        int cell = cellId(cx, cy, cz);
+        if (i == 0 || keys[i].first != keys[i - 1].first) {
+            cellStart[cell] = i;
+        }
+        cellEnd[cell] = i + 1;
+    }
+    floatError = 0.5 * numeric_limits<float>::epsilon() * maxAbs;
+}
+
+// Call visit(cx, cy, cz) for every in-grid cell at Chebyshev distance r from c
+template <typename F>
+static void visitRing(const int c[3], int r, const int dims[3], F visit) {
+    int z0 = max(c[2] - r, 0), z1 = min(c[2] + r, dims[2] - 1);
+    int y0 = max(c[1] - r, 0), y1 = min(c[1] + r, dims[1] - 1);
+    for (int cz = z0; cz <= z1; ++cz) {
+        bool zEdge = abs(cz - c[2]) == r;
+        for (int cy = y0; cy <= y1; ++cy) {
+            bool edge = zEdge || abs(cy - c[1]) == r;
+            // Interior rows only contribute their two end cells
+            int step = edge ? 1 : 2 * r;
+            for (int cx = c[0] - r; cx <= c[0] + r; cx += step) {
+                if (cx >= 0 && cx < dims[0]) visit(cx, cy, cz);
+            }
+        }
+    }
+}
+
+// Largest error of a quantized distance, in steps: half a step per axis from each side
+static const double quantError = sqrt(3.0) + 1e-3;
+
+// Quantized squared distance above which an atom cannot come closer than sqrt(best2)
+static int screenLimit(double best2, double invStep) {
+    double limit = sqrt(best2) * invStep + quantError;
+    return limit < 46340.0 ? (int)ceil(limit * limit) : INT_MAX;
+}
+
+// Atoms screened per pass: the int16 kernels screen a cell in blocks of this
+// many atoms into a stack buffer, then re-verify the flagged ones in double
+static const int screenBlock = 64;
+
+// Quantized squared distances from (ix, iy, iz) to the n <= screenBlock atoms
+// at q*, stored in d2. Returns how many are at most maybe2; sure receives how
+// many are below sure2. No branches, so the loop vectorizes.
+static inline int screenInt16(const int16_t* qx, const int16_t* qy, const int16_t* qz, int n, int ix, int iy,
+                              int iz, int sure2, int maybe2, int32_t* d2, int& sure) {
+    int candidates = 0, certain = 0;
+    for (int k = 0; k < n; ++k) {
+        int dxi = ix - qx[k];
+        int dyi = iy - qy[k];
+        int dzi = iz - qz[k];
+        int d2i = dxi*dxi + dyi*dyi + dzi*dzi;
+        d2[k] = d2i;
+        candidates += d2i <= maybe2;
+        certain += d2i < sure2;
+    }
+    sure = certain;
+    return candidates;
+}
+
+double CapsidIndex::minDistance(const vector<Atom>& query, int* capsidAtom, int* queryAtom) const {
+    int bestCapsid = -1, bestQuery = -1;
+    double mindist = screening == ScreenInt16 ? minDistanceInt16(query, bestCapsid, bestQuery)
+                                              : minDistanceExact(query, bestCapsid, bestQuery);
+    if (capsidAtom) *capsidAtom = bestCapsid >= 0 ? order[bestCapsid] : -1;
+    if (queryAtom) *queryAtom = bestQuery;
+    return mindist;
+}
+
+int CapsidIndex::countFailures(const vector<Atom>& query, double threshold) const {
+    return countFailures(query, uniformClashTable(threshold));
+}
+
+
+// Clash cut-offs rearranged for the kernels: row qe holds the cut-off against
+// every capsid element, so the inner loop is one lookup by element[j]
+struct PairCuts {
+    double cut[NumElementCodes][NumElementCodes];
+    double cut2[NumElementCodes][NumElementCodes];   // superset cut on d2
+    double reach[NumElementCodes];                   // largest cut-off in the row
+    bool uniform;                                    // every pair has the same cut-off
+
+    explicit PairCuts(const ClashTable& table) : uniform(true) {
+        for (int qe = 0; qe < NumElementCodes; ++qe) {
+            reach[qe] = 0.0;
+            for (int ce = 0; ce < NumElementCodes; ++ce) {
+                double t = table.cutoff[ce][qe];
+                cut[qe][ce] = t;
+                cut2[qe][ce] = t * t * (1.0 + 1e-12);
+                reach[qe] = max(reach[qe], t);
+                if (t != table.cutoff[0][0]) uniform = false;
+            }
+        }
+    }
+};
+
+double CapsidIndex::minDistanceExact(const vector<Atom>& query, int& bestCapsid, int& bestQuery) const {
+    double best2 = numeric_limits<double>::infinity();
+    if (x.empty()) return best2;
+
+    for (size_t q = 0; q < query.size(); ++q) {
+        const double px = query[q].coords[0];
+        const double py = query[q].coords[1];
+        const double pz = query[q].coords[2];
+        const int c[3] = {cellCoord(px, 0), cellCoord(py, 1), cellCoord(pz, 2)};
+
+        int maxRing = 0;
+        for (int k = 0; k < 3; ++k) {
+            maxRing = max(maxRing, max(c[k], dims[k] - 1 - c[k]));
+        }
+
+        // Expand Chebyshev rings of cells; atoms in ring r are at least
+        // (r - 1) * cellSize away, so stop once that cannot beat best2
+        for (int r = 0; r <= maxRing; ++r) {
+            double bound = (r - 1) * cellSize;
+            if (r > 0 && bound * bound >= best2) break;
+
+            visitRing(c, r, dims, [&](int cx, int cy, int cz) {
+                int cell = cellId(cx, cy, cz);
+                for (uint32_t j = cellStart[cell]; j < cellEnd[cell]; ++j) {
+                    double dx = px - x[j];
+                    double dy = py - y[j];
+                    double dz = pz - z[j];
+                    double d2 = dx*dx + dy*dy + dz*dz;
+                    if (d2 < best2) {
+                        best2 = d2;
+                        bestCapsid = j;
+                        bestQuery = (int)q;
+                    }
+                }
+            });
+        }
+    }
+
+    // sqrt is monotonic and correctly rounded, so this equals the brute-force minimum of sqrt
+    return sqrt(best2);
+}
+
+double CapsidIndex::minDistanceInt16(const vector<Atom>& query, int& bestCapsid, int& bestQuery) const {
+    double best2 = numeric_limits<double>::infinity();
+    if (x.empty()) return best2;
+
+    const double invStep = 1.0 / quantStep;
+
+    for (size_t q = 0; q < query.size(); ++q) {
+        const double px = query[q].coords[0];
+        const double py = query[q].coords[1];
+        const double pz = query[q].coords[2];
+        const int c[3] = {cellCoord(px, 0), cellCoord(py, 1), cellCoord(pz, 2)};
+
+        int maxRing = 0;
+        for (int k = 0; k < 3; ++k) {
+            maxRing = max(maxRing, max(c[k], dims[k] - 1 - c[k]));
+        }
+
+        for (int r = 0; r <= maxRing; ++r) {
+            double bound = (r - 1) * cellSize;
+            if (r > 0 && bound * bound >= best2) break;
+
+            visitRing(c, r, dims, [&](int cx, int cy, int cz) {
+                int cell = cellId(cx, cy, cz);
+                uint32_t start = cellStart[cell], end = cellEnd[cell];
+                if (start == end) return;
+
+                double ox = (px - origin[0]) * invStep - cx * cellSize * invStep;
+                double oy = (py - origin[1]) * invStep - cy * cellSize * invStep;
+                double oz = (pz - origin[2]) * invStep - cz * cellSize * invStep;
+
+                // Cells this far away can still be searched, just not in int32
+                bool quantizable = fabs(ox) < maxQueryOffset && fabs(oy) < maxQueryOffset && fabs(oz) < maxQueryOffset;
+                if (quantizable) {
+                    const int ix = quantize(ox), iy = quantize(oy), iz = quantize(oz);
+                    int32_t d2i[screenBlock];
+                    int unused;
+
+                    // Integer screen; only atoms that might beat best2 are re-verified in double
+                    for (uint32_t block = start; block < end; block += screenBlock) {
+                        const int n = (int)min<uint32_t>(screenBlock, end - block);
+                        int limit2 = screenLimit(best2, invStep);
+                        if (screenInt16(&qx[block], &qy[block], &qz[block], n, ix, iy, iz, 0, limit2, d2i,
+                                        unused) == 0) {
+                            continue;
+                        }
+                        for (int k = 0; k < n; ++k) {
+                            if (d2i[k] > limit2) continue;
+                            const uint32_t j = block + k;
+                            double dx = px - x[j];
+                            double dy = py - y[j];
+                            double dz = pz - z[j];
+                            double d2 = dx*dx + dy*dy + dz*dz;
+                            if (d2 < best2) {
+                                best2 = d2;
+                                bestCapsid = j;
+                                bestQuery = (int)q;
+                                limit2 = screenLimit(best2, invStep);
+                            }
+                        }
+                    }
+                    return;
+                }
+
+                for (uint32_t j = start; j < end; ++j) {
+                    double dx = px - x[j];
+                    double dy = py - y[j];
+                    double dz = pz - z[j];
+                    double d2 = dx*dx + dy*dy + dz*dz;
+                    if (d2 < best2) {
+                        best2 = d2;
+                        bestCapsid = j;
+                        bestQuery = (int)q;
+                    }
+                }
+            });
+        }
+    }
+
+    return sqrt(best2);
+}
+
+template <bool ByElement>
+int CapsidIndex::countFailuresExact(const vector<Atom>& query, const ClashTable& table) const {
+    int failureCount = 0;
+
+    // Superset cut on squared distance; the exact test below matches the brute-force kernel
+    const PairCuts cuts(table);
+
+    for (size_t q = 0; q < query.size(); ++q) {
+        const double px = query[q].coords[0];
+        const double py = query[q].coords[1];
+        const double pz = query[q].coords[2];
+        const int qe = ByElement ? elementCode(query[q].type) : 0;
+        const double* cut = cuts.cut[qe];
+        const double* cut2 = cuts.cut2[qe];
+        const double reach = cuts.reach[qe];
+        if (reach <= 0.0) continue;
+        int x0 = cellCoord(px - reach, 0), x1 = cellCoord(px + reach, 0);
+        int y0 = cellCoord(py - reach, 1), y1 = cellCoord(py + reach, 1);
+        int z0 = cellCoord(pz - reach, 2), z1 = cellCoord(pz + reach, 2);
+
+        for (int cz = z0; cz <= z1; ++cz) {
+            for (int cy = y0; cy <= y1; ++cy) {
+                for (int cx = x0; cx <= x1; ++cx) {
+                    int cell = cellId(cx, cy, cz);
+                    for (uint32_t j = cellStart[cell]; j < cellEnd[cell]; ++j) {
+                        double dx = px - x[j];
+                        double dy = py - y[j];
+                        double dz = pz - z[j];
+                        double d2 = dx*dx + dy*dy + dz*dz;
+                        const int ce = ByElement ? element[j] : 0;
+                        if (d2 < cut2[ce] && sqrt(d2) < cut[ce]) {
+                            failureCount++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return failureCount;
+}
+
+template <bool ByElement>
+int CapsidIndex::countFailuresInt16(const vector<Atom>& query, const ClashTable& table) const {
+    int failureCount = 0;
+    const double invStep = 1.0 / quantStep;
+    const PairCuts cuts(table);
+
+    // Quantized squared distances below sureCut2 are certainly failures, those
+    // above maybeCut2 certainly are not; the band in between is checked in double
+    int sureCut2[NumElementCodes][NumElementCodes];
+    int maybeCut2[NumElementCodes][NumElementCodes];
+    for (int qe = 0; qe < NumElementCodes; ++qe) {
+        for (int ce = 0; ce < NumElementCodes; ++ce) {
+            double sureCut = cuts.cut[qe][ce] * invStep - quantError;
+            double maybeCut = cuts.cut[qe][ce] * invStep + quantError;
+            sureCut2[qe][ce] = sureCut > 0.0 ? (int)floor(sureCut * sureCut) : 0;
+            maybeCut2[qe][ce] = (int)ceil(maybeCut * maybeCut);
+        }
+    }
+
+    for (size_t q = 0; q < query.size(); ++q) {
+        const double px = query[q].coords[0];
+        const double py = query[q].coords[1];
+        const double pz = query[q].coords[2];
+        const int qe = ByElement ? elementCode(query[q].type) : 0;
+        const double* cut = cuts.cut[qe];
+        const double* cut2 = cuts.cut2[qe];
+        const int* sure2 = sureCut2[qe];
+        const int* maybe2 = maybeCut2[qe];
+        const double reach = cuts.reach[qe];
+        if (reach <= 0.0) continue;
+        int x0 = cellCoord(px - reach, 0), x1 = cellCoord(px + reach, 0);
+        int y0 = cellCoord(py - reach, 1), y1 = cellCoord(py + reach, 1);
+        int z0 = cellCoord(pz - reach, 2), z1 = cellCoord(pz + reach, 2);
+
+        // The screen takes one cut for the whole block: with element cut-offs
+        // it flags everything within the row's widest band and counts nothing
+        // as certain, leaving the per-element decision to the second pass
+        int rowMaybe2 = 0;
+        for (int ce = 0; ce < NumElementCodes; ++ce) rowMaybe2 = max(rowMaybe2, maybe2[ce]);
+        const int blockSure2 = ByElement ? 0 : sure2[0];
+        const int blockMaybe2 = ByElement ? rowMaybe2 : maybe2[0];
+
+        for (int cz = z0; cz <= z1; ++cz) {
+            const double oz = (pz - origin[2]) * invStep - cz * cellSize * invStep;
+            for (int cy = y0; cy <= y1; ++cy) {
+                const double oy = (py - origin[1]) * invStep - cy * cellSize * invStep;
+                for (int cx = x0; cx <= x1; ++cx) {
+                    const double ox = (px - origin[0]) * invStep - cx * cellSize * invStep;
+                    int cell = cellId(cx, cy, cz);
+                    uint32_t start = cellStart[cell], end = cellEnd[cell];
+
+                    // A query outside the grid is clamped to its edge cells,
+                    // which can be too far away to screen in int32
+                    if (fabs(ox) >= maxQueryOffset || fabs(oy) >= maxQueryOffset || fabs(oz) >= maxQueryOffset) {
+                        for (uint32_t j = start; j < end; ++j) {
+                            double dx = px - x[j];
+                            double dy = py - y[j];
+                            double dz = pz - z[j];
+                            double d2 = dx*dx + dy*dy + dz*dz;
+                            const int ce = ByElement ? element[j] : 0;
+                            if (d2 < cut2[ce] && sqrt(d2) < cut[ce]) {
+                                failureCount++;
+                            }
+                        }
+                        continue;
+                    }
+                    const int ix = quantize(ox), iy = quantize(oy), iz = quantize(oz);
+                    int32_t d2i[screenBlock];
+
+                    for (uint32_t block = start; block < end; block += screenBlock) {
+                        const int n = (int)min<uint32_t>(screenBlock, end - block);
+                        int sure;
+                        int candidates = screenInt16(&qx[block], &qy[block], &qz[block], n, ix, iy, iz,
+                                                     blockSure2, blockMaybe2, d2i, sure);
+                        failureCount += sure;
+                        if (candidates == sure) continue;
+
+                        // Second pass over the flagged atoms only
+                        for (int k = 0; k < n; ++k) {
+                            const uint32_t j = block + k;
+                            const int ce = ByElement ? element[j] : 0;
+                            if (d2i[k] > maybe2[ce]) continue;
+                            if (d2i[k] < sure2[ce]) {
+                                if (ByElement) failureCount++;      // else counted by the screen
+                                continue;
+                            }
+
+                            double dx = px - x[j];
+                            double dy = py - y[j];
+                            double dz = pz - z[j];
+                            double d2 = dx*dx + dy*dy + dz*dz;
+                            if (d2 < cut2[ce] && sqrt(d2) < cut[ce]) {
+                                failureCount++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return failureCount;
+}
+
+double CapsidIndex::floatMargin(const FloatCoords& placed) const {
+    // Both coordinate errors on up to three axes, plus the float subtraction
+    // (the squares and sums are covered by the relative slack on the cuts)
+    const double eps = numeric_limits<float>::epsilon();
+    double reach = placed.maxAbs + floatError / (0.5 * eps);
+    return sqrt(3.0) * (placed.error + floatError + eps * reach);
+}
+
+// Slack on float squared-distance cuts for rounding in the squares and sums
+static const double floatRelative = 1e-5;
+
+double CapsidIndex::minDistanceMixed(const Transform& t, const vector<Atom>& initial, const FloatCoords& placed,
+                                     int* capsidAtom, int* queryAtom) const {
+    int bestCapsid = -1, bestQuery = -1;
+    double best2 = numeric_limits<double>::infinity();
+
+    if (!x.empty()) {
+        const double margin = floatMargin(placed);
+
+        for (size_t q = 0; q < initial.size(); ++q) {
+            const float px = placed.x[q];
+            const float py = placed.y[q];
+            const float pz = placed.z[q];
+            const int c[3] = {cellCoord(px, 0), cellCoord(py, 1), cellCoord(pz, 2)};
+
+            int maxRing = 0;
+            for (int k = 0; k < 3; ++k) {
+                maxRing = max(maxRing, max(c[k], dims[k] - 1 - c[k]));
+            }
+
+            // Double coordinates of this query atom, computed on first use
+            double p[3];
+            bool havePoint = false;
+
+            // Float squared distances above limit cannot beat best2
+            float limit = numeric_limits<float>::infinity();
+            if (best2 < numeric_limits<double>::infinity()) {
+                double reach = sqrt(best2) + margin;
+                limit = (float)(reach * reach * (1.0 + floatRelative));
+            }
+
+            for (int r = 0; r <= maxRing; ++r) {
+                // The double point may be up to margin closer than the float one
+                double bound = (r - 1) * cellSize - margin;
+                if (r > 0 && bound > 0.0 && bound * bound >= best2) break;
+
+                visitRing(c, r, dims, [&](int cx, int cy, int cz) {
+                    int cell = cellId(cx, cy, cz);
+                    for (uint32_t j = cellStart[cell]; j < cellEnd[cell]; ++j) {
+                        float dxf = px - fx[j];
+                        float dyf = py - fy[j];
+                        float dzf = pz - fz[j];
+                        if (dxf*dxf + dyf*dyf + dzf*dzf > limit) continue;
+
+                        if (!havePoint) {
+                            transformPoint(t, initial[q].coords, p);
+                            havePoint = true;
+                        }
+                        double dx = p[0] - x[j];
+                        double dy = p[1] - y[j];
+                        double dz = p[2] - z[j];
+                        double d2 = dx*dx + dy*dy + dz*dz;
+                        if (d2 < best2) {
+                            best2 = d2;
+                            bestCapsid = j;
+                            bestQuery = (int)q;
+                            double reach = sqrt(best2) + margin;
+                            limit = (float)(reach * reach * (1.0 + floatRelative));
+                        }
+                    }
+                });
+            }
+        }
+    }
+
+    if (capsidAtom) *capsidAtom = bestCapsid >= 0 ? order[bestCapsid] : -1;
+    if (queryAtom) *queryAtom = bestQuery;
+    return sqrt(best2);
+}
+
+int CapsidIndex::countFailuresMixed(const Transform& t, const vector<Atom>& initial, const FloatCoords& placed,
+                                    double threshold) const {
+    return countFailuresMixed(t, initial, placed, uniformClashTable(threshold));
+}
+
+template <bool ByElement>
+int CapsidIndex::countFailuresFloat(const Transform& t, const vector<Atom>& initial, const FloatCoords& placed,
+                                    const ClashTable& table) const {
+    int failureCount = 0;
+    const double margin = floatMargin(placed);
+    const PairCuts cuts(table);
+
+    // Float squared distances below sureCut2 are certainly failures, those
+    // above maybeCut2 certainly are not; the band in between is checked in double
+    float sureCut2[NumElementCodes][NumElementCodes];
+    float maybeCut2[NumElementCodes][NumElementCodes];
+    for (int qe = 0; qe < NumElementCodes; ++qe) {
+        for (int ce = 0; ce < NumElementCodes; ++ce) {
+            double sureCut = max(0.0, cuts.cut[qe][ce] - margin);
+            double maybeCut = cuts.cut[qe][ce] + margin;
+            sureCut2[qe][ce] = (float)(sureCut * sureCut * (1.0 - floatRelative));
+            maybeCut2[qe][ce] = (float)(maybeCut * maybeCut * (1.0 + floatRelative));
+        }
+    }
+
+    for (size_t q = 0; q < initial.size(); ++q) {
+        const float px = placed.x[q];
+        const float py = placed.y[q];
+        const float pz = placed.z[q];
+        const int qe = ByElement ? elementCode(initial[q].type) : 0;
+        const double* cut = cuts.cut[qe];
+        const double* cut2 = cuts.cut2[qe];
+        const float* sure2 = sureCut2[qe];
+        const float* maybe2 = maybeCut2[qe];
+        if (cuts.reach[qe] <= 0.0) continue;
+        const double reach = cuts.reach[qe] + margin;
+        int x0 = cellCoord(px - reach, 0), x1 = cellCoord(px + reach, 0);
+        int y0 = cellCoord(py - reach, 1), y1 = cellCoord(py + reach, 1);
+        int z0 = cellCoord(pz - reach, 2), z1 = cellCoord(pz + reach, 2);
+
+        double p[3];
+        bool havePoint = false;
+
+        for (int cz = z0; cz <= z1; ++cz) {
+            for (int cy = y0; cy <= y1; ++cy) {
+                for (int cx = x0; cx <= x1; ++cx) {
+                    int cell = cellId(cx, cy, cz);
+                    for (uint32_t j = cellStart[cell]; j < cellEnd[cell]; ++j) {
+                        float dxf = px - fx[j];
+                        float dyf = py - fy[j];
+                        float dzf = pz - fz[j];
+                        float d2f = dxf*dxf + dyf*dyf + dzf*dzf;
+                        const int ce = ByElement ? element[j] : 0;
+                        if (d2f > maybe2[ce]) continue;
+                        if (d2f < sure2[ce]) {
+                            failureCount++;
+                            continue;
+                        }
+
+                        if (!havePoint) {
+                            transformPoint(t, initial[q].coords, p);
+                            havePoint = true;
+                        }
+                        double dx = p[0] - x[j];
+                        double dy = p[1] - y[j];
+                        double dz = p[2] - z[j];
+                        double d2 = dx*dx + dy*dy + dz*dz;
+                        if (d2 < cut2[ce] && sqrt(d2) < cut[ce]) {
+                            failureCount++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return failureCount;
+}
+
+int CapsidIndex::countFailures(const vector<Atom>& query, const ClashTable& table) const {
+    if (x.empty()) return 0;
+    bool byElement = !PairCuts(table).uniform;
+    if (screening == ScreenInt16) {
+        return byElement ? countFailuresInt16<true>(query, table) : countFailuresInt16<false>(query, table);
+    }
+    return byElement ? countFailuresExact<true>(query, table) : countFailuresExact<false>(query, table);
+}
+
+int CapsidIndex::countFailuresMixed(const Transform& t, const vector<Atom>& initial, const FloatCoords& placed,
+                                    const ClashTable& table) const {
+    if (x.empty()) return 0;
+    return PairCuts(table).uniform ? countFailuresFloat<false>(t, initial, placed, table)
+                                   : countFailuresFloat<true>(t, initial, placed, table);
+}
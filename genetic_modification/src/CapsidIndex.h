@@ -0,0 +1,109 @@
+#ifndef CAPSIDINDEX_H
+#define CAPSIDINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include "PlacementEngine.h"
+
+// Spatial index over the (static) capsid atoms.
+//
+// Atoms are bucketed into a uniform grid and stored in Z-order (Morton) order
+// of their cells, so every cell is one contiguous run and neighbouring cells
+// are usually close in memory. Coordinates are kept as separate x/y/z arrays.
+// originalIndex maps a sorted position back to the index in the input file.
+//
+// The queries return exactly the same values as the brute-force
+// calculateMinimumDistance / countDistanceFailures.
+//
+// In ScreenInt16 mode (experimental) each cell is screened in two passes:
+// a branch-free pass over cell-relative int16 fixed-point copies of the
+// coordinates (6 bytes per atom instead of 24) computes every quantized
+// squared distance and counts the candidates, and only when there are any
+// does a second pass re-verify the flagged pairs in double. The first pass
+// vectorizes at -O3 (or -O2 -fvect-cost-model=dynamic); with about ten
+// atoms per cell it is not yet faster than ScreenExact on cache-resident
+// capsids, so placement_bench keeps timing both.
+//
+// The *Mixed queries take the query as float coordinates placed = t * initial
+// (ScreenFloat32) and screen against float copies of the capsid. Pairs within
+// the float error bound of the cut, or of the best distance so far, are
+// recomputed in double from t and initial, so they too return exactly the
+// values of the all-double queries on applyTransform(t, initial).
+
+class CapsidIndex {
+public:
+    CapsidIndex() : cellSize(0.0), numCells(0), quantStep(0.01), floatError(0.0), screening(ScreenExact) {}
+
+    // cellSize should be a few Angstroms: small enough that a clash query
+    // touches few atoms, large enough that the cell table stays small
+    void build(const std::vector<Atom>& atoms, double cellSize = 6.0);
+
+    int size() const { return (int)x.size(); }
+
+    void setScreening(ScreeningMode mode) { screening = mode; }
+    ScreeningMode getScreening() const { return screening; }
+
+    // Index of sorted atom i in the vector passed to build()
+    int originalIndex(int i) const { return order[i]; }
+
+    // Minimum distance between any query atom and any capsid atom. If
+    // capsidAtom/queryAtom are given they receive the closest pair (capsid
+    // index in original file order).
+    double minDistance(const std::vector<Atom>& query, int* capsidAtom = NULL, int* queryAtom = NULL) const;
+
+    // Number of (capsid, query) pairs closer than threshold, or than the
+    // table's cut-off for the pair's elements
+    int countFailures(const std::vector<Atom>& query, double threshold) const;
+    int countFailures(const std::vector<Atom>& query, const ClashTable& table) const;
+
+    double minDistanceMixed(const Transform& t, const std::vector<Atom>& initial, const FloatCoords& placed,
+                            int* capsidAtom = NULL, int* queryAtom = NULL) const;
+    int countFailuresMixed(const Transform& t, const std::vector<Atom>& initial, const FloatCoords& placed,
+                           double threshold) const;
+    int countFailuresMixed(const Transform& t, const std::vector<Atom>& initial, const FloatCoords& placed,
+                           const ClashTable& table) const;
+
+private:
+    double minDistanceExact(const std::vector<Atom>& query, int& bestCapsid, int& bestQuery) const;
+    double minDistanceInt16(const std::vector<Atom>& query, int& bestCapsid, int& bestQuery) const;
+    // ByElement = false compiles the single-threshold kernels (uniform tables)
+    template <bool ByElement>
+    int countFailuresExact(const std::vector<Atom>& query, const ClashTable& table) const;
+    template <bool ByElement>
+    int countFailuresInt16(const std::vector<Atom>& query, const ClashTable& table) const;
+    template <bool ByElement>
+    int countFailuresFloat(const Transform& t, const std::vector<Atom>& initial, const FloatCoords& placed,
+                           const ClashTable& table) const;
+
+    // Cell coordinate of a point along one axis, clamped to the grid
+    int cellCoord(double value, int axis) const;
+
+    // Bound on |float distance - double distance| for a query placed in float
+    double floatMargin(const FloatCoords& placed) const;
+    int cellId(int cx, int cy, int cz) const { return (cz * dims[1] + cy) * dims[0] + cx; }
+
+    double origin[3];
+    double cellSize;
+    int dims[3];
+    int numCells;
+
+    // Capsid atoms in Morton order
+    std::vector<double> x, y, z;
+    std::vector<int> order;
+    std::vector<uint8_t> element;   // ElementCode of each atom
+
+    // The same atoms as offsets from their cell's lower corner in units of quantStep
+    double quantStep;
+    std::vector<int16_t> qx, qy, qz;
+
+    // The same atoms in float, each within floatError of the double value
+    std::vector<float> fx, fy, fz;
+    double floatError;
+    ScreeningMode screening;
+
+    // Atoms of cell c are [cellStart[c], cellEnd[c]) in the sorted arrays
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellEnd;
+};
+
+#endif // CAPSIDINDEX_H
@@ -0,0 +1,376 @@
+#include "ConformerEnsemble.h"
+#include "PlacementMetrics.h"
+#include "OrientationSampler.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <climits>
+#include <cctype>
+#include <cstdlib>
+
+using namespace std;
+
+// ── Reading ensembles ────────────────────────────────────────────────────────
+
+static bool hasExtension(const string& filename, const string& ext) {
+    if (filename.size() < ext.size()) return false;
+    string tail = filename.substr(filename.size() - ext.size());
+    for (size_t i = 0; i < tail.size(); ++i) tail[i] = (char)tolower((unsigned char)tail[i]);
+    return tail == ext;
+}
+
+// Element letter of an ATOM/HETATM record: columns 77-78, else the first
+// letter of the atom name (columns 13-16)
+static char pdbElement(const string& line) {
+    if (line.size() >= 78) {
+        for (size_t i = 76; i < 78; ++i) {
+            if (isalpha((unsigned char)line[i])) return (char)toupper((unsigned char)line[i]);
+        }
+    }
+    for (size_t i = 12; i < 16 && i < line.size(); ++i) {
+        if (isalpha((unsigned char)line[i])) return (char)toupper((unsigned char)line[i]);
+    }
+    return 'X';
+}
+
+static bool readPdbConformers(const string& filename, vector<vector<Atom> >& conformers) {
+    ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return false;
+    }
+
+    // Atoms outside MODEL/ENDMDL, kept only if the file has no MODEL records
+    vector<Atom> loose;
+    string line;
+    int lineNumber = 0;
+    bool inModel = false, sawModel = false;
+    while (getline(inFile, line)) {
+        lineNumber++;
+        string record = line.substr(0, 6);
+        if (record.compare(0, 5, "MODEL") == 0) {
+            conformers.push_back(vector<Atom>());
+            inModel = sawModel = true;
+            loose.clear();
+        } else if (record == "ENDMDL") {
+            inModel = false;
+        } else if (record == "ATOM  " || record == "HETATM") {
+            if (line.size() < 54) {
+                cerr << "Error: Short coordinate record at " << filename << ":" << lineNumber << endl;
+                return false;
+            }
+            if (!inModel && sawModel) continue;
+            Atom atom;
+            atom.type = pdbElement(line);
+            atom.coords[0] = atof(line.substr(30, 8).c_str());
+            atom.coords[1] = atof(line.substr(38, 8).c_str());
+            atom.coords[2] = atof(line.substr(46, 8).c_str());
+            (inModel ? conformers.back() : loose).push_back(atom);
+        }
+    }
+    // Without MODEL records the whole file is one model
+    if (!sawModel && !loose.empty()) conformers.push_back(loose);
+    return true;
+}
+
+static bool readXyzConformers(const string& filename, vector<vector<Atom> >& conformers) {
+    ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return false;
+    }
+
+    string line;
+    while (getline(inFile, line)) {
+        // Trailing blank lines end the file
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+
+        int numatoms = 0;
+        istringstream countLine(line);
+        if (!(countLine >> numatoms) || numatoms <= 0) {
+            cerr << "Error: Expected an atom count for frame " << conformers.size() + 1
+                 << " of " << filename << endl;
+            return false;
+        }
+        if (!getline(inFile, line)) {
+            cerr << "Error: File ended unexpectedly in the comment line of frame "
+                 << conformers.size() + 1 << endl;
+            return false;
+        }
+
+        vector<Atom> atoms(numatoms);
+        for (int i = 0; i < numatoms; ++i) {
+            if (!getline(inFile, line)) {
+                cerr << "Error: File ended unexpectedly in frame " << conformers.size() + 1 << endl;
+                return false;
+            }
+            istringstream iss(line);
+            iss >> atoms[i].type >> atoms[i].coords[0] >> atoms[i].coords[1] >> atoms[i].coords[2];
+        }
+        conformers.push_back(atoms);
+    }
+    return true;
+}
+
+bool readConformers(const string& filename, vector<vector<Atom> >& conformers) {
+    conformers.clear();
+    bool ok = hasExtension(filename, ".pdb") || hasExtension(filename, ".ent")
+                  ? readPdbConformers(filename, conformers)
+                  : readXyzConformers(filename, conformers);
+    if (!ok) return false;
+
+    if (conformers.empty()) {
+        cerr << "Error: No conformers found in " << filename << endl;
+        return false;
+    }
+    for (size_t c = 0; c < conformers.size(); ++c) {
+        if (conformers[c].empty()) {
+            cerr << "Error: Conformer " << c + 1 << " of " << filename << " has no atoms" << endl;
+            return false;
+        }
+        if (conformers[c].size() != conformers[0].size()) {
+            cerr << "Warning: Conformer " << c + 1 << " has " << conformers[c].size()
+                 << " atoms, conformer 1 has " << conformers[0].size() << endl;
+        }
+    }
+    cout << "Read " << conformers.size() << " conformers from " << filename << endl;
+    return true;
+}
+
+// ── Searching one conformer ──────────────────────────────────────────────────
+
+// What the search of one conformer leaves behind
+struct ConformerSearch {
+    bool ok;
+    bool perfect;
+    int attempts;
+    int distanceChecks;
+    vector<Configuration> best;   // top configurations, unsorted
+};
+
+static bool initSampler(OrientationSampler& sampler, const PlacementRegion& region,
+                        const vector<Atom>& atoms, const double pivot[3]) {
+    switch (region.kind) {
+        case PlacementRegion::OutsideSphere:
+            return sampler.initSphereOutside(atoms, pivot, region.center, region.radius);
+        case PlacementRegion::InsideSphere:
+            return sampler.initSphereInside(atoms, pivot, region.center, region.radius);
+        case PlacementRegion::OutsideCylinder:
+            return sampler.initCylinderOutside(atoms, pivot, region.radius);
+    }
+    return false;
+}
+
+static bool passesRegion(const PlacementRegion& region, const vector<Atom>& placed) {
+    switch (region.kind) {
+        case PlacementRegion::OutsideSphere: return checkAtomsOutsideSphere(placed, region.center, region.radius);
+        case PlacementRegion::InsideSphere: return checkAtomsInsideSphere(placed, region.center, region.radius);
+        case PlacementRegion::OutsideCylinder: return checkAtomsOutsideCylinder(placed, region.radius);
+    }
+    return false;
+}
+
+static bool passesRegionMixed(const PlacementRegion& region, const Transform& t,
+                              const vector<Atom>& initial, const FloatCoords& placed) {
+    switch (region.kind) {
+        case PlacementRegion::OutsideSphere:
+            return checkAtomsOutsideSphereMixed(t, initial, placed, region.center, region.radius);
+        case PlacementRegion::InsideSphere:
+            return checkAtomsInsideSphereMixed(t, initial, placed, region.center, region.radius);
+        case PlacementRegion::OutsideCylinder:
+            return checkAtomsOutsideCylinderMixed(t, initial, placed, region.radius);
+    }
+    return false;
+}
+
+// The rotate_matrix_* attempt loop for one conformer, without the console
+// progress and visualization images
+static void searchConformer(int conformer, const vector<Atom>& initial, const CapsidIndex& index,
+                            const PlacementRegion& region, const ClashTable& clashTable,
+                            const PlacementOptions& options, const EnsembleSettings& settings,
+                            PlacementCounters& counters, ConformerSearch& out) {
+    out.ok = false;
+    out.perfect = false;
+    out.attempts = 0;
+    out.distanceChecks = 0;
+    out.best.assign(settings.topConfigs, Configuration());
+
+    const double pivot[3] = {initial[0].coords[0], initial[0].coords[1], initial[0].coords[2]};
+    OrientationSampler sampler;
+    if (options.sampler == SamplerCap && !initSampler(sampler, region, initial, pivot)) {
+        return;
+    }
+    out.ok = true;
+
+    // Conformer 0 uses the seed of the single-P2 search
+    int idum = -873 - conformer;
+
+    const bool useFloat = options.screening == ScreenFloat32;
+    FloatCoords initialFloat;
+    if (useFloat) toFloatCoords(initial, initialFloat);
+    PlacementWorkspace workspace(initial.size());
+
+    while (out.distanceChecks < settings.maxDistanceChecks && !out.perfect && out.attempts < settings.maxAttempts) {
+        out.attempts++;
+        counters.attempts++;
+        StageTimer timer;
+
+        double rotation[3][3];
+        counters.samplerRejections += sampler.sample(&idum, rotation);
+        Transform transform = pivotRotation(rotation, pivot);
+        if (useFloat) applyTransformFloat(transform, initialFloat, workspace.placedFloat);
+        else applyTransform(transform, initial, workspace.placed);
+        counters.transformSeconds += timer.lap();
+
+        bool passes = useFloat ? passesRegionMixed(region, transform, initial, workspace.placedFloat)
+                               : passesRegion(region, workspace.placed);
+        counters.prefilterSeconds += timer.lap();
+        if (!passes) {
+            counters.prefilterRejections++;
+            continue;
+        }
+
+        out.distanceChecks++;
+        counters.fullChecks++;
+        double mindist;
+        int failureCount;
+        if (useFloat) {
+            mindist = index.minDistanceMixed(transform, initial, workspace.placedFloat);
+            failureCount = index.countFailuresMixed(transform, initial, workspace.placedFloat, clashTable);
+        } else {
+            mindist = index.minDistance(workspace.placed);
+            failureCount = index.countFailures(workspace.placed, clashTable);
+        }
+        counters.clashSeconds += timer.lap();
+        counters.minDistance.add(mindist);
+        counters.failures.add(failureCount);
+
+        // Replace the worst kept configuration if this one is better
+        int worstIndex = 0;
+        for (int i = 1; i < settings.topConfigs; ++i) {
+            if (out.best[i].failureCount > out.best[worstIndex].failureCount) {
+                worstIndex = i;
+            }
+        }
+        if (failureCount < out.best[worstIndex].failureCount) {
+            out.best[worstIndex].failureCount = failureCount;
+            out.best[worstIndex].minDistance = mindist;
+            out.best[worstIndex].transform = transform;
+        }
+        if (failureCount == 0) {
+            out.perfect = true;
+        }
+    }
+}
+
+// Fewest failures first, then the larger minimum distance, then model order
+static bool betterResult(const EnsembleResult& a, const EnsembleResult& b) {
+    if (a.config.failureCount != b.config.failureCount) return a.config.failureCount < b.config.failureCount;
+    if (a.config.minDistance != b.config.minDistance) return a.config.minDistance > b.config.minDistance;
+    return a.conformer < b.conformer;
+}
+
+// ── Driver ───────────────────────────────────────────────────────────────────
+
+int runEnsemblePlacement(const string& ensembleFile, const CapsidIndex& index,
+                         const PlacementRegion& region, const ClashTable& clashTable,
+                         const PlacementOptions& options, const EnsembleSettings& settings) {
+    vector<vector<Atom> > conformers;
+    if (!readConformers(ensembleFile, conformers)) {
+        return 1;
+    }
+
+    int numConformers = (int)conformers.size();
+    int numThreads = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+    numThreads = max(1, min(numThreads, numConformers));
+    cout << "Searching " << numConformers << " conformers on " << numThreads << " threads" << endl;
+
+    // Each thread owns one counter block; the JSON summary is written after
+    // the join (interval lines are not written during an ensemble search)
+    PlacementMetrics metrics(numThreads, options.metricsFile, 0.0, options.progressInterval);
+    vector<ConformerSearch> searches(numConformers);
+    atomic<int> nextConformer(0);
+
+    auto work = [&](int worker) {
+        PlacementCounters& counters = metrics.worker(worker);
+        for (int c = nextConformer++; c < numConformers; c = nextConformer++) {
+            searchConformer(c, conformers[c], index, region, clashTable, options, settings,
+                            counters, searches[c]);
+        }
+    };
+    vector<thread> threads;
+    for (int t = 1; t < numThreads; ++t) {
+        threads.push_back(thread(work, t));
+    }
+    work(0);
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    metrics.writeSummary();
+
+    // Per-conformer summary and the overall ranking
+    vector<EnsembleResult> results;
+    for (int c = 0; c < numConformers; ++c) {
+        const ConformerSearch& s = searches[c];
+        if (!s.ok) {
+            cout << "Conformer " << c + 1 << ": skipped (no rotation satisfies the prefilter)" << endl;
+            continue;
+        }
+        int bestFailures = INT_MAX;
+        double bestDistance = 0.0;
+        for (size_t i = 0; i < s.best.size(); ++i) {
+            if (s.best[i].failureCount == INT_MAX) continue;
+            EnsembleResult result = {c, s.best[i]};
+            results.push_back(result);
+            if (s.best[i].failureCount < bestFailures) {
+                bestFailures = s.best[i].failureCount;
+                bestDistance = s.best[i].minDistance;
+            }
+        }
+        cout << "Conformer " << c + 1 << ": " << s.attempts << " attempts, " << s.distanceChecks
+             << " distance checks";
+        if (bestFailures < INT_MAX) {
+            cout << ", best " << bestFailures << " failures (min distance " << bestDistance << ")"
+                 << (s.perfect ? " PERFECT" : "");
+        }
+        cout << endl;
+    }
+    sort(results.begin(), results.end(), betterResult);
+    if ((int)results.size() > settings.topConfigs) results.resize(settings.topConfigs);
+
+    cout << "\n=== ENSEMBLE RESULTS ===" << endl;
+    if (results.empty()) {
+        cout << "No conformer reached a distance check." << endl;
+        return 1;
+    }
+
+    vector<Atom> atoms;
+    for (size_t k = 0; k < results.size(); ++k) {
+        const EnsembleResult& r = results[k];
+        string filename = "best_" + settings.outputPrefix + "_" + to_string(k + 1) + ".xyz";
+        string transformFile = "transform_" + settings.outputPrefix + "_" + to_string(k + 1) + ".txt";
+        applyTransform(r.config.transform, conformers[r.conformer], atoms);
+        writeXYZ(filename, atoms,
+                 "Conformer " + to_string(r.conformer + 1)
+                 + " - Failures: " + to_string(r.config.failureCount)
+                 + " - Min distance: " + to_string(r.config.minDistance));
+        writeTransform(transformFile, r.config.transform,
+                       "Transform from model " + to_string(r.conformer + 1) + " of " + ensembleFile
+                       + " to " + filename);
+        cout << "Rank " << k + 1 << ": conformer " << r.conformer + 1 << ", " << r.config.failureCount
+             << " failures, min distance = " << r.config.minDistance << " -> saved as " << filename
+             << " (" << transformFile << ")" << endl;
+    }
+    // rotate_protein.py reads the model number and ensemble file from this
+    // header and applies the transform to that model instead of P2.pdb
+    writeTransform("rotation_matrix.txt", results[0].config.transform,
+                   "Transform from model " + to_string(results[0].conformer + 1) + " of " + ensembleFile
+                   + " to best_" + settings.outputPrefix + "_1.xyz");
+    cout << "\nTransform of the best (conformer " << results[0].conformer + 1
+         << ") written to rotation_matrix.txt; rotate_protein.py applies it to model "
+         << results[0].conformer + 1 << " of " << ensembleFile << endl;
+    return 0;
+}
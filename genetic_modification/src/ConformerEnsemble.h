@@ -0,0 +1,53 @@
+#ifndef CONFORMERENSEMBLE_H
+#define CONFORMERENSEMBLE_H
+
+#include <string>
+#include <vector>
+#include "PlacementEngine.h"
+#include "CapsidIndex.h"
+
+// Placement search over an ensemble of P2 conformers (NMR models, AlphaFold
+// samples, MD snapshots). The capsid is read and indexed once; every
+// conformer is searched against that shared index on its own worker thread,
+// with its own ran3 seed, and the best (conformer, transform) pairs of the
+// whole ensemble are reported.
+//
+// Atom 0 of every conformer is the fusion point and pivot, as in P2.xyz.
+
+// Read every model of a PDB (MODEL/ENDMDL; a file without MODEL records is
+// one conformer, and in a file with them atoms outside MODEL/ENDMDL are
+// ignored) or every frame of a multi-frame XYZ file
+bool readConformers(const std::string& filename, std::vector<std::vector<Atom> >& conformers);
+
+// The prefilter region of a rotate main
+struct PlacementRegion {
+    enum Kind { OutsideSphere, InsideSphere, OutsideCylinder };
+
+    Kind kind;
+    double center[3];   // unused for the z-axis cylinder
+    double radius;
+};
+
+struct EnsembleSettings {
+    int maxDistanceChecks;      // per conformer
+    int maxAttempts;            // per conformer
+    int topConfigs;             // kept per conformer and reported overall
+    std::string outputPrefix;   // best_<prefix>_k.xyz, transform_<prefix>_k.txt
+};
+
+// One reported placement
+struct EnsembleResult {
+    int conformer;              // 0-based model/frame index
+    Configuration config;
+};
+
+// Search every conformer in ensembleFile, write best_<prefix>_k.xyz,
+// transform_<prefix>_k.txt and rotation_matrix.txt for the best result, and
+// return the process exit code. rotation_matrix.txt starts with
+// "# Transform from model <k> of <ensembleFile> to ...", which tells
+// rotate_protein.py which model to transform.
+int runEnsemblePlacement(const std::string& ensembleFile, const CapsidIndex& index,
+                         const PlacementRegion& region, const ClashTable& clashTable,
+                         const PlacementOptions& options, const EnsembleSettings& settings);
+
+#endif // CONFORMERENSEMBLE_H
@@ -0,0 +1,267 @@
+#include "OrientationSampler.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+static const double pi = 3.14159265358979;
+
+// Atoms closer than this to the pivot do not move under a pivot rotation
+static const double pivotTolerance = 1e-9;
+
+// Two unit vectors completing n (unit) to a right-handed orthonormal frame
+static void orthonormalBasis(const double n[3], double e1[3], double e2[3]) {
+    // Cross with the coordinate axis least aligned with n
+    double a[3] = {0.0, 0.0, 0.0};
+    if (fabs(n[0]) <= fabs(n[1]) && fabs(n[0]) <= fabs(n[2])) a[0] = 1.0;
+    else if (fabs(n[1]) <= fabs(n[2])) a[1] = 1.0;
+    else a[2] = 1.0;
+
+    e1[0] = n[1] * a[2] - n[2] * a[1];
+    e1[1] = n[2] * a[0] - n[0] * a[2];
+    e1[2] = n[0] * a[1] - n[1] * a[0];
+    double len = sqrt(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]);
+    for (int k = 0; k < 3; ++k) e1[k] /= len;
+
+    e2[0] = n[1] * e1[2] - n[2] * e1[1];
+    e2[1] = n[2] * e1[0] - n[0] * e1[2];
+    e2[2] = n[0] * e1[1] - n[1] * e1[0];
+}
+
+OrientationSampler::OrientationSampler() : active(false), atom(-1), cosMin(-1.0), exhausted(0), exhaustedStreak(0) {
+    for (int k = 0; k < 3; ++k) {
+        axis[k] = 0.0;
+        direction[k] = 0.0;
+    }
+}
+
+const int OrientationSampler::maxRejections;
+const int OrientationSampler::maxExhaustedCalls;
+
+bool OrientationSampler::chooseCaps(const vector<Atom>& atoms, const double pivot[3], const double axisIn[3],
+                                    const vector<double>& threshold, bool exact) {
+    // Atoms whose cap is the whole sphere never constrain anything
+    vector<pair<double, int> > caps;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        if (threshold[i] > -1.0) caps.push_back(make_pair(-threshold[i], (int)i));
+    }
+    sort(caps.begin(), caps.end());
+
+    capX.clear();
+    capY.clear();
+    capZ.clear();
+    capT.clear();
+
+    // No atom constrains the rotation: keep the fallback
+    if (caps.empty()) {
+        active = false;
+        atom = -1;
+        return true;
+    }
+
+    if (-caps[0].first >= 1.0) {
+        cerr << "Error: No rotation about the pivot can place P2 atom " << caps[0].second + 1
+             << " where the prefilter requires" << endl;
+        return false;
+    }
+
+    active = true;
+    exhaustedStreak = 0;
+    atom = caps[0].second;
+    cosMin = -caps[0].first;
+    for (int k = 0; k < 3; ++k) axis[k] = axisIn[k];
+
+    for (size_t c = 0; c < caps.size(); ++c) {
+        const Atom& a = atoms[caps[c].second];
+        double d[3], len = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            d[k] = a.coords[k] - pivot[k];
+            len += d[k] * d[k];
+        }
+        len = sqrt(len);
+        if (c == 0) {
+            for (int k = 0; k < 3; ++k) direction[k] = d[k] / len;
+            if (!exact) break;
+            continue;
+        }
+        capX.push_back(d[0] / len);
+        capY.push_back(d[1] / len);
+        capZ.push_back(d[2] / len);
+        capT.push_back(-caps[c].first);
+    }
+    return true;
+}
+
+// Outside the sphere: |w + L u|^2 > R^2 with w = pivot - center, which is
+// w_hat . u > (R^2 - D^2 - L^2) / (2 L D)
+bool OrientationSampler::initSphereOutside(const vector<Atom>& atoms, const double pivot[3],
+                                           const double center[3], double radius) {
+    double w[3], D = 0.0;
+    for (int k = 0; k < 3; ++k) {
+        w[k] = pivot[k] - center[k];
+        D += w[k] * w[k];
+    }
+    D = sqrt(D);
+    if (D <= radius) {
+        cerr << "Error: The pivot lies inside the exclusion sphere" << endl;
+        return false;
+    }
+    for (int k = 0; k < 3; ++k) w[k] /= D;
+
+    vector<double> threshold(atoms.size(), -3.0);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        double L2 = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            double d = atoms[i].coords[k] - pivot[k];
+            L2 += d * d;
+        }
+        double L = sqrt(L2);
+        if (L < pivotTolerance) continue;
+        threshold[i] = (radius * radius - D * D - L2) / (2.0 * L * D);
+    }
+    return chooseCaps(atoms, pivot, w, threshold, true);
+}
+
+// Inside the sphere: |w + L u|^2 < R^2, which is
+// (-w_hat) . u > (D^2 + L^2 - R^2) / (2 L D)
+bool OrientationSampler::initSphereInside(const vector<Atom>& atoms, const double pivot[3],
+                                          const double center[3], double radius) {
+    double w[3], D = 0.0;
+    for (int k = 0; k < 3; ++k) {
+        w[k] = pivot[k] - center[k];
+        D += w[k] * w[k];
+    }
+    D = sqrt(D);
+    if (D >= radius) {
+        cerr << "Error: The pivot lies outside the confining sphere" << endl;
+        return false;
+    }
+
+    // A pivot at the centre constrains no direction
+    if (D < pivotTolerance) {
+        active = false;
+        atom = -1;
+        for (size_t i = 0; i < atoms.size(); ++i) {
+            double L2 = 0.0;
+            for (int k = 0; k < 3; ++k) {
+                double d = atoms[i].coords[k] - pivot[k];
+                L2 += d * d;
+            }
+            if (L2 >= radius * radius) {
+                cerr << "Error: P2 atom " << i + 1 << " is farther from the pivot than the sphere radius" << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double axisIn[3];
+    for (int k = 0; k < 3; ++k) axisIn[k] = -w[k] / D;
+
+    vector<double> threshold(atoms.size(), -3.0);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        double L2 = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            double d = atoms[i].coords[k] - pivot[k];
+            L2 += d * d;
+        }
+        double L = sqrt(L2);
+        if (L < pivotTolerance) continue;
+        threshold[i] = (D * D + L2 - radius * radius) / (2.0 * L * D);
+    }
+    return chooseCaps(atoms, pivot, axisIn, threshold, true);
+}
+
+// Outside the cylinder: |p_xy + L u_xy| > R. Since |u_xy| <= 1,
+// |p_xy + L u_xy|^2 <= P^2 + L^2 + 2 L P (p_hat . u) with p_hat = (p_x, p_y, 0) / P,
+// so p_hat . u > (R^2 - P^2 - L^2) / (2 L P) is necessary (a superset cap)
+bool OrientationSampler::initCylinderOutside(const vector<Atom>& atoms, const double pivot[3], double radius) {
+    double P = sqrt(pivot[0] * pivot[0] + pivot[1] * pivot[1]);
+    if (P <= radius) {
+        cerr << "Error: The pivot lies inside the exclusion cylinder" << endl;
+        return false;
+    }
+    double axisIn[3] = {pivot[0] / P, pivot[1] / P, 0.0};
+
+    vector<double> threshold(atoms.size(), -3.0);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        double L2 = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            double d = atoms[i].coords[k] - pivot[k];
+            L2 += d * d;
+        }
+        double L = sqrt(L2);
+        if (L < pivotTolerance) continue;
+        threshold[i] = (radius * radius - P * P - L2) / (2.0 * L * P);
+    }
+    return chooseCaps(atoms, pivot, axisIn, threshold, false);
+}
+
+double OrientationSampler::coverage() const {
+    return active ? 0.5 * (1.0 - cosMin) : 1.0;
+}
+
+int OrientationSampler::sample(int* idum, double rotation[3][3]) {
+    if (!active) {
+        randomRotationMatrix(idum, rotation);
+        return 0;
+    }
+
+    // v: uniform over the proposal cap around the tightest atom, kept only
+    // if it also lies inside every other cap
+    double f1[3], f2[3], v[3];
+    orthonormalBasis(direction, f1, f2);
+    int rejected = 0;
+    while (true) {
+        double cosTheta = 1.0 - ran3(idum) * (1.0 - cosMin);
+        double sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+        double phi = 2.0 * pi * ran3(idum);
+        for (int k = 0; k < 3; ++k) {
+            v[k] = cosTheta * direction[k] + sinTheta * (cos(phi) * f1[k] + sin(phi) * f2[k]);
+        }
+
+        bool inside = true;
+        for (size_t c = 0; c < capT.size(); ++c) {
+            if (v[0] * capX[c] + v[1] * capY[c] + v[2] * capZ[c] <= capT[c]) {
+                inside = false;
+                break;
+            }
+        }
+        if (inside) {
+            exhaustedStreak = 0;
+            break;
+        }
+        if (rejected >= maxRejections) {
+            exhausted++;
+            if (++exhaustedStreak >= maxExhaustedCalls) {
+                cerr << "Warning: The orientation sampler found no rotation inside every cap in "
+                     << maxExhaustedCalls << " x " << maxRejections
+                     << " proposals; the feasible region looks empty, drawing over all rotations instead" << endl;
+                active = false;
+                atom = -1;
+            }
+            break;
+        }
+        rejected++;
+    }
+
+    // R maps the frame (v, e1, e2) onto (axis, g1, g2), with g1/g2 spun
+    // uniformly about the axis, so that R^T axis = v
+    double spin = 2.0 * pi * ran3(idum);
+    double e1[3], e2[3], h1[3], h2[3], g1[3], g2[3];
+    orthonormalBasis(v, e1, e2);
+    orthonormalBasis(axis, h1, h2);
+    for (int k = 0; k < 3; ++k) {
+        g1[k] = cos(spin) * h1[k] + sin(spin) * h2[k];
+        g2[k] = -sin(spin) * h1[k] + cos(spin) * h2[k];
+    }
+
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            rotation[r][c] = axis[r] * v[c] + g1[r] * e1[c] + g2[r] * e2[c];
+        }
+    }
+    return rejected;
+}
@@ -0,0 +1,74 @@
+#ifndef ORIENTATIONSAMPLER_H
+#define ORIENTATIONSAMPLER_H
+
+#include <vector>
+#include "PlacementEngine.h"
+
+// Draws pivot rotations for P2 from the part of rotation space that can pass
+// the sphere/cylinder prefilter, instead of rejection-sampling all of it.
+//
+// With the pivot fixed, atom i at distance L_i from the pivot passes a sphere
+// test iff its rotated direction R d_i satisfies axis . R d_i > t_i. Writing
+// v = R^T axis (the sphere normal seen from P2's own frame) this is
+// v . d_i > t_i for every atom, so feasibility depends on v alone and the
+// spin about the axis is free. The sampler draws v uniformly inside the
+// tightest of these caps, accepts it only if it lies inside all of them
+// (dot products, no transform), then adds a uniform spin. The result is the
+// uniform (Haar) distribution restricted to the feasible rotations.
+//
+// The cylinder test is not a function of v alone; there the tightest cap is
+// used as a superset. The prefilter still runs on every sample in all modes
+// (it also absorbs rounding at the cap boundaries).
+//
+// A default-constructed sampler falls back to randomRotationMatrix. So does
+// one whose exact caps reject every proposal of several calls in a row: their
+// intersection is then empty or too small to find, and the prefilter decides.
+
+class OrientationSampler {
+public:
+    OrientationSampler();
+
+    // Every atom outside / inside the sphere. Returns false (after printing
+    // why) if no rotation about the pivot can satisfy the constraint.
+    bool initSphereOutside(const std::vector<Atom>& atoms, const double pivot[3],
+                           const double center[3], double radius);
+    bool initSphereInside(const std::vector<Atom>& atoms, const double pivot[3],
+                          const double center[3], double radius);
+    // Every atom outside the z-axis cylinder; uses a cap that contains the feasible set
+    bool initCylinderOutside(const std::vector<Atom>& atoms, const double pivot[3], double radius);
+
+    // Returns the number of proposals rejected on the way (bounded by
+    // maxRejections, after which the last proposal is returned regardless).
+    // After maxExhaustedCalls such calls in a row it warns and falls back.
+    int sample(int* idum, double rotation[3][3]);
+
+    // Fraction of all rotations inside the proposal cap (1 for the fallback)
+    double coverage() const;
+
+    // P2 atom whose cap is used, or -1 for the fallback
+    int constrainingAtom() const { return atom; }
+
+    // Calls that ran out of proposals
+    int exhaustedCalls() const { return exhausted; }
+
+private:
+    // Keep the caps v . d_i > threshold[i] (tightest first); exact = false keeps only the tightest
+    bool chooseCaps(const std::vector<Atom>& atoms, const double pivot[3], const double axisIn[3],
+                    const std::vector<double>& threshold, bool exact);
+
+    static const int maxRejections = 1000;
+    static const int maxExhaustedCalls = 5;
+
+    bool active;
+    int atom;
+    double axis[3];       // lab-frame axis (unit)
+    double cosMin;        // proposal cap is v . direction > cosMin
+    double direction[3];  // body-frame unit direction of the tightest atom from the pivot
+    int exhausted;        // calls that hit maxRejections
+    int exhaustedStreak;  // ... since the last accepted proposal
+
+    // Remaining caps, tightest first: v . (capX, capY, capZ)[c] > capT[c]
+    std::vector<double> capX, capY, capZ, capT;
+};
+
+#endif // ORIENTATIONSAMPLER_H
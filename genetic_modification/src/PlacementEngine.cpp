@@ -0,0 +1,695 @@
+#include "PlacementEngine.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+const double pi = 3.14159265358979;
+
+#define MBIG 1000000000
+#define MSEED 161803398
+#define MZ 0
+#define FAC (1.0/MBIG)
+
+Configuration::Configuration()
+    : failureCount(INT_MAX), minDistance(0.0), transform(identityTransform()) {}
+
+// Function to read data from a file into a vector of atoms
+bool readData(const string& filename, vector<Atom>& atoms, int& numatoms) {
+    ifstream inFile(filename); // Open the file for reading
+    string line;
+    numatoms = 0;
+
+    // Check if the file opened successfully
+    if (!inFile.is_open()) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return false;
+    }
+
+    // Check if the first line contains the number of atoms
+    if (getline(inFile, line)) {
+        istringstream iss(line);
+        iss >> numatoms;
+        cout << "Number of atoms: " << numatoms << endl;
+        atoms.resize(numatoms); // Allocate exact needed space
+    } else {
+        cerr << "Error: Could not read the number of atoms from the file." << endl;
+        return false;
+    }
+
+    // Skip the second line (e.g., "generated by VMD")
+    if (!getline(inFile, line)) {
+        cerr << "Error: File ended unexpectedly while skipping the second line." << endl;
+        return false;
+    }
+
+    // Loop through each atom and read its details from subsequent lines
+    for (int i = 0; i < numatoms; ++i) {
+        if (getline(inFile, line)) {
+            istringstream iss(line);
+            iss >> atoms[i].type >> atoms[i].coords[0] >> atoms[i].coords[1] >> atoms[i].coords[2];
+        } else {
+            cerr << "Error: File ended unexpectedly while reading atom data." << endl;
+            numatoms = i;
+            atoms.resize(numatoms);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Function to write atoms to an XYZ file
+bool writeXYZ(const string& filename, const vector<Atom>& atoms, const string& comment) {
+    ofstream outFile(filename);
+    if (!outFile.is_open()) {
+        cerr << "Error: Could not open " << filename << " for writing" << endl;
+        return false;
+    }
+
+    outFile << atoms.size() << "\n" << comment << "\n";
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        outFile << atoms[i].type << "   " << atoms[i].coords[0] << "    "
+                << atoms[i].coords[1] << "    " << atoms[i].coords[2] << "\n";
+    }
+    return true;
+}
+
+// Function to generate random numbers using the ran3 algorithm
+float ran3(int *idum) {
+    // State retained between calls, one copy per thread so that concurrent
+    // searches (one seed each) do not share a sequence
+    static thread_local int inext, inextp;
+    static thread_local long ma[56];
+    static thread_local int iff=0;
+    long mj, mk;
+    int i, ii, k;
+
+    // Initialize the random number generator if required
+    if (*idum < 0 || iff == 0) {
+        iff=1;
+        // The loop below never sets ma[34]; clear the state so a reseed gives
+        // the same sequence as a fresh (zeroed) generator
+        for (i=0; i<56; i++) ma[i]=0;
+        mj=MSEED-(*idum < 0 ? -*idum : *idum);
+        mj %= MBIG;
+        ma[55]=mj;
+        mk=1;
+        // Initialize the state vector
+        for (i=1; i<54; i++) {
+            ii=(21*i) % 55;
+            ma[ii]=mk;
+            mk=mj-mk;
+            if (mk < MZ) mk += MBIG;
+            mj=ma[ii];
+        }
+        // Shuffle the state vector
+        for (k=1; k<=4; k++)
+            for (i=1; i<=55; i++) {
+                ma[i] -= ma[1+(i+30) % 55];
+                if (ma[i] < MZ) ma[i] += MBIG;
+            }
+        // Reset pointers and seed
+        inext=0;
+        inextp=31;
+        *idum=1;
+    }
+
+    // Update pointers for the next random number
+    if (++inext == 56) inext=1;
+    if (++inextp == 56) inextp=1;
+    mj=ma[inext]-ma[inextp];
+    if (mj < MZ) mj += MBIG;
+    ma[inext]=mj;
+
+    // Return the random number scaled by a factor
+    return mj*FAC;
+}
+
+void randomRotationMatrix(int* idum, double matrix[3][3]) {
+    // Generate random angles for rotation
+    double alpha = ran3(idum) * 2.0 * pi;
+    double beta = ran3(idum) * 2.0 * pi;
+    double gamma = ran3(idum) * 2.0 * pi;
+
+    matrix[0][0] = cos(beta) * cos(gamma);
+    matrix[0][1] = cos(beta) * sin(gamma);
+    matrix[0][2] = -sin(beta);
+    matrix[1][0] = sin(alpha) * sin(beta) * cos(gamma) - cos(alpha) * sin(gamma);
+    matrix[1][1] = sin(alpha) * sin(beta) * sin(gamma) + cos(alpha) * cos(gamma);
+    matrix[1][2] = sin(alpha) * cos(beta);
+    matrix[2][0] = cos(alpha) * sin(beta) * cos(gamma) + sin(alpha) * sin(gamma);
+    matrix[2][1] = cos(alpha) * sin(beta) * sin(gamma) - sin(alpha) * cos(gamma);
+    matrix[2][2] = cos(alpha) * cos(beta);
+}
+
+Transform identityTransform() {
+    Transform t;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            t.m[i][j] = (i == j) ? 1.0 : 0.0;
+    return t;
+}
+
+Transform pivotRotation(const double rotation[3][3], const double pivot[3]) {
+    Transform t = identityTransform();
+    for (int i = 0; i < 3; ++i) {
+        double rp = 0.0;
+        for (int j = 0; j < 3; ++j) {
+            t.m[i][j] = rotation[i][j];
+            rp += rotation[i][j] * pivot[j];
+        }
+        // p' = R (p - pivot) + pivot = R p + (pivot - R pivot)
+        t.m[i][3] = pivot[i] - rp;
+    }
+    return t;
+}
+
+void applyTransform(const Transform& t, const vector<Atom>& in, vector<Atom>& out) {
+    out.resize(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i].type = in[i].type;
+        transformPoint(t, in[i].coords, out[i].coords);
+    }
+}
+
+static const double floatEpsilon = numeric_limits<float>::epsilon();
+
+void toFloatCoords(const vector<Atom>& atoms, FloatCoords& out) {
+    size_t n = atoms.size();
+    out.x.resize(n);
+    out.y.resize(n);
+    out.z.resize(n);
+    out.maxAbs = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        out.x[i] = (float)atoms[i].coords[0];
+        out.y[i] = (float)atoms[i].coords[1];
+        out.z[i] = (float)atoms[i].coords[2];
+        for (int k = 0; k < 3; ++k) out.maxAbs = max(out.maxAbs, fabs(atoms[i].coords[k]));
+    }
+    // Rounding to nearest is off by at most half an ulp
+    out.error = 0.5 * floatEpsilon * out.maxAbs;
+}
+
+void applyTransformFloat(const Transform& t, const FloatCoords& in, FloatCoords& out) {
+    float m[3][4];
+    double shift = 0.0;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) m[r][c] = (float)t.m[r][c];
+        shift = max(shift, fabs(t.m[r][3]));
+    }
+
+    const size_t n = in.x.size();
+    const float* ix = &in.x[0];
+    const float* iy = &in.y[0];
+    const float* iz = &in.z[0];
+    float* ox = &out.x[0];
+    float* oy = &out.y[0];
+    float* oz = &out.z[0];
+    for (size_t i = 0; i < n; ++i) {
+        const float x = ix[i], y = iy[i], z = iz[i];
+        ox[i] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+        oy[i] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+        oz[i] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+    }
+
+    // Three input errors through a row of norm <= 1, plus rounding of the
+    // matrix and of four products and three sums (a few ulps of each term,
+    // doubled for slack)
+    out.maxAbs = sqrt(3.0) * in.maxAbs + shift;
+    out.error = 3.0 * in.error + 8.0 * floatEpsilon * (3.0 * in.maxAbs + shift);
+}
+
+// Cyclic Jacobi diagonalisation of a symmetric 4x4 matrix.
+// On return a holds the eigenvalues on its diagonal and v the eigenvectors (columns).
+static void jacobiEigen4(double a[4][4], double v[4][4]) {
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            v[i][j] = (i == j) ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        double off = 0.0;
+        for (int p = 0; p < 3; ++p)
+            for (int q = p + 1; q < 4; ++q)
+                off += a[p][q] * a[p][q];
+        if (off < 1e-30) break;
+
+        for (int p = 0; p < 3; ++p) {
+            for (int q = p + 1; q < 4; ++q) {
+                if (fabs(a[p][q]) < 1e-300) continue;
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double tt = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(tt * tt + 1.0);
+                double s = tt * c;
+
+                for (int k = 0; k < 4; ++k) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 4; ++k) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 4; ++k) {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+bool fitTransform(const vector<Atom>& original, const vector<Atom>& transformed,
+                  Transform& result, double& rmsd) {
+    size_t n = original.size();
+    if (n == 0 || n != transformed.size()) {
+        cerr << "Error: Atom count mismatch between structures" << endl;
+        return false;
+    }
+
+    // Calculate centroids
+    double centroidOrig[3] = {0.0, 0.0, 0.0};
+    double centroidTrans[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < n; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            centroidOrig[j] += original[i].coords[j];
+            centroidTrans[j] += transformed[i].coords[j];
+        }
+    }
+    for (int j = 0; j < 3; ++j) {
+        centroidOrig[j] /= n;
+        centroidTrans[j] /= n;
+    }
+
+    // Cross-covariance S = sum(a * b^T) over centred coordinates
+    double S[3][3] = {{0.0}};
+    double sumSq = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double a[3], b[3];
+        for (int j = 0; j < 3; ++j) {
+            a[j] = original[i].coords[j] - centroidOrig[j];
+            b[j] = transformed[i].coords[j] - centroidTrans[j];
+            sumSq += a[j] * a[j] + b[j] * b[j];
+        }
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                S[r][c] += a[r] * b[c];
+    }
+
+    // Horn's symmetric 4x4 matrix; its top eigenvector is the optimal quaternion
+    double N[4][4] = {
+        {S[0][0] + S[1][1] + S[2][2], S[1][2] - S[2][1], S[2][0] - S[0][2], S[0][1] - S[1][0]},
+        {S[1][2] - S[2][1], S[0][0] - S[1][1] - S[2][2], S[0][1] + S[1][0], S[2][0] + S[0][2]},
+        {S[2][0] - S[0][2], S[0][1] + S[1][0], -S[0][0] + S[1][1] - S[2][2], S[1][2] + S[2][1]},
+        {S[0][1] - S[1][0], S[2][0] + S[0][2], S[1][2] + S[2][1], -S[0][0] - S[1][1] + S[2][2]}
+    };
+    double V[4][4];
+    jacobiEigen4(N, V);
+
+    int best = 0;
+    for (int i = 1; i < 4; ++i)
+        if (N[i][i] > N[best][best]) best = i;
+
+    double q0 = V[0][best], q1 = V[1][best], q2 = V[2][best], q3 = V[3][best];
+    double qn = sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 /= qn; q1 /= qn; q2 /= qn; q3 /= qn;
+
+    double R[3][3] = {
+        {q0*q0 + q1*q1 - q2*q2 - q3*q3, 2.0 * (q1*q2 - q0*q3), 2.0 * (q1*q3 + q0*q2)},
+        {2.0 * (q1*q2 + q0*q3), q0*q0 - q1*q1 + q2*q2 - q3*q3, 2.0 * (q2*q3 - q0*q1)},
+        {2.0 * (q1*q3 - q0*q2), 2.0 * (q2*q3 + q0*q1), q0*q0 - q1*q1 - q2*q2 + q3*q3}
+    };
+
+    result = identityTransform();
+    for (int i = 0; i < 3; ++i) {
+        double rc = 0.0;
+        for (int j = 0; j < 3; ++j) {
+            result.m[i][j] = R[i][j];
+            rc += R[i][j] * centroidOrig[j];
+        }
+        result.m[i][3] = centroidTrans[i] - rc;
+    }
+
+    double msd = (sumSq - 2.0 * N[best][best]) / n;
+    rmsd = msd > 0.0 ? sqrt(msd) : 0.0;
+    return true;
+}
+
+bool writeTransform(const string& filename, const Transform& t, const string& comment) {
+    ofstream matrixFile(filename);
+    if (!matrixFile.is_open()) {
+        cerr << "Error: Could not open " << filename << " for writing" << endl;
+        return false;
+    }
+
+    matrixFile << "# " << comment << "\n";
+    matrixFile << "# Format: 4x4 homogeneous transform (row-major), pivot translation included\n";
+    matrixFile << "# Apply as: [x' y' z' 1]^T = M * [x y z 1]^T\n";
+    matrixFile << setprecision(17);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            matrixFile << setw(25) << t.m[i][j];
+            if (j < 3) matrixFile << " ";
+        }
+        matrixFile << "\n";
+    }
+    return true;
+}
+
+double calculateMinimumDistance(const vector<Atom>& atomsA, const vector<Atom>& atomsB) {
+    double mindist = numeric_limits<double>::infinity();
+
+    // Iterate over atoms in set A (capsid)
+    for (const auto& atomA : atomsA) {
+        // Iterate over atoms in set B (protein)
+        for (const auto& atomB : atomsB) {
+            // Calculate squared differences in coordinates
+            double dx = atomB.coords[0] - atomA.coords[0];
+            double dy = atomB.coords[1] - atomA.coords[1];
+            double dz = atomB.coords[2] - atomA.coords[2];
+
+            // Calculate distance between atoms
+            double dist = sqrt(dx*dx + dy*dy + dz*dz);
+
+            // Update minimum distance if the calculated distance is smaller
+            if (dist < mindist) {
+                mindist = dist;
+            }
+        }
+    }
+
+    return mindist; // Return the minimum distance
+}
+
+// Function to count how many atom pairs fail the distance check
+int countDistanceFailures(const vector<Atom>& atomsA, const vector<Atom>& atomsB, double threshold) {
+    int failureCount = 0;
+
+    // Iterate over atoms in set A (capsid)
+    for (const auto& atomA : atomsA) {
+        // Iterate over atoms in set B (protein)
+        for (const auto& atomB : atomsB) {
+            // Calculate distance between atoms
+            double dx = atomB.coords[0] - atomA.coords[0];
+            double dy = atomB.coords[1] - atomA.coords[1];
+            double dz = atomB.coords[2] - atomA.coords[2];
+            double dist = sqrt(dx*dx + dy*dy + dz*dz);
+
+            // Count failures (distances below threshold)
+            if (dist < threshold) {
+                failureCount++;
+            }
+        }
+    }
+
+    return failureCount;
+}
+
+int countDistanceFailures(const vector<Atom>& atomsA, const vector<Atom>& atomsB, const ClashTable& table) {
+    int failureCount = 0;
+
+    for (const auto& atomA : atomsA) {
+        const double* row = table.cutoff[elementCode(atomA.type)];
+        for (const auto& atomB : atomsB) {
+            double dx = atomB.coords[0] - atomA.coords[0];
+            double dy = atomB.coords[1] - atomA.coords[1];
+            double dz = atomB.coords[2] - atomA.coords[2];
+            double dist = sqrt(dx*dx + dy*dy + dz*dz);
+
+            if (dist < row[elementCode(atomB.type)]) {
+                failureCount++;
+            }
+        }
+    }
+
+    return failureCount;
+}
+
+ClashTable uniformClashTable(double threshold) {
+    ClashTable table;
+    for (int a = 0; a < NumElementCodes; ++a) {
+        for (int b = 0; b < NumElementCodes; ++b) table.cutoff[a][b] = threshold;
+    }
+    table.maxCutoff = threshold;
+    return table;
+}
+
+ClashTable vdwClashTable(double overlap) {
+    ClashTable table;
+    table.maxCutoff = 0.0;
+    for (int a = 0; a < NumElementCodes; ++a) {
+        for (int b = 0; b < NumElementCodes; ++b) {
+            double cutoff = vdwRadius[a] + vdwRadius[b] - overlap - hbondAllowance(a, b);
+            table.cutoff[a][b] = max(0.0, cutoff);
+            table.maxCutoff = max(table.maxCutoff, table.cutoff[a][b]);
+        }
+    }
+    return table;
+}
+
+// Function to check if all atoms in a set are OUTSIDE the sphere
+bool checkAtomsOutsideSphere(const vector<Atom>& atoms, const double center[3], double radius) {
+    for (const auto& atom : atoms) {
+        double dx = atom.coords[0] - center[0];
+        double dy = atom.coords[1] - center[1];
+        double dz = atom.coords[2] - center[2];
+        double distanceSquared = dx * dx + dy * dy + dz * dz;
+
+        if (distanceSquared <= radius * radius) {
+            return false; // At least one atom is inside or on the sphere
+        }
+    }
+    return true; // All atoms are outside the sphere
+}
+
+// Function to check if all atoms in a set are INSIDE the sphere
+bool checkAtomsInsideSphere(const vector<Atom>& atoms, const double center[3], double radius) {
+    for (const auto& atom : atoms) {
+        double dx = atom.coords[0] - center[0];
+        double dy = atom.coords[1] - center[1];
+        double dz = atom.coords[2] - center[2];
+        double distanceSquared = dx * dx + dy * dy + dz * dz;
+
+        if (distanceSquared >= radius * radius) {
+            return false; // At least one atom is outside or on the sphere
+        }
+    }
+    return true; // All atoms are inside the sphere
+}
+
+// Function to check if all atoms in a set are OUTSIDE the cylinder
+bool checkAtomsOutsideCylinder(const vector<Atom>& atoms, double radius) {
+    for (const auto& atom : atoms) {
+        // Calculate distance from z-axis (distance in xy-plane)
+        double dx = atom.coords[0];
+        double dy = atom.coords[1];
+        double distanceFromZAxisSquared = dx * dx + dy * dy;
+
+        // No z-coordinate check since cylinder extends infinitely in z-direction
+        if (distanceFromZAxisSquared <= radius * radius) {
+            return false; // At least one atom is inside or on the cylinder
+        }
+    }
+    return true; // All atoms are outside the cylinder
+}
+
+// Squared-distance cuts for a float test of "distance vs radius": below low
+// the atom is certainly inside, above high certainly outside
+static void floatCuts(const FloatCoords& placed, double centerAbs, double radius, float& low, float& high) {
+    // Coordinate error on up to three axes, rounding of the centre, and a
+    // relative allowance for the float subtractions, squares and sums
+    double margin = sqrt(3.0) * (placed.error + floatEpsilon * (centerAbs + placed.maxAbs));
+    double lo = max(0.0, radius - margin);
+    double hi = radius + margin;
+    low = (float)(lo * lo * (1.0 - 1e-5));
+    high = (float)(hi * hi * (1.0 + 1e-5));
+}
+
+// Squared distance of the double-precision placement of one atom from the centre
+static double exactDistanceSquared(const Transform& t, const Atom& atom, const double center[3]) {
+    double p[3];
+    transformPoint(t, atom.coords, p);
+    double dx = p[0] - center[0];
+    double dy = p[1] - center[1];
+    double dz = p[2] - center[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+bool checkAtomsOutsideSphereMixed(const Transform& t, const vector<Atom>& initial,
+                                  const FloatCoords& placed, const double center[3], double radius) {
+    float low, high;
+    floatCuts(placed, max(fabs(center[0]), max(fabs(center[1]), fabs(center[2]))), radius, low, high);
+    const float cx = (float)center[0], cy = (float)center[1], cz = (float)center[2];
+    for (size_t i = 0; i < initial.size(); ++i) {
+        float dx = placed.x[i] - cx;
+        float dy = placed.y[i] - cy;
+        float dz = placed.z[i] - cz;
+        float d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > high) continue;
+        if (d2 < low || exactDistanceSquared(t, initial[i], center) <= radius * radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkAtomsInsideSphereMixed(const Transform& t, const vector<Atom>& initial,
+                                 const FloatCoords& placed, const double center[3], double radius) {
+    float low, high;
+    floatCuts(placed, max(fabs(center[0]), max(fabs(center[1]), fabs(center[2]))), radius, low, high);
+    const float cx = (float)center[0], cy = (float)center[1], cz = (float)center[2];
+    for (size_t i = 0; i < initial.size(); ++i) {
+        float dx = placed.x[i] - cx;
+        float dy = placed.y[i] - cy;
+        float dz = placed.z[i] - cz;
+        float d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 < low) continue;
+        if (d2 > high || exactDistanceSquared(t, initial[i], center) >= radius * radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkAtomsOutsideCylinderMixed(const Transform& t, const vector<Atom>& initial,
+                                    const FloatCoords& placed, double radius) {
+    float low, high;
+    floatCuts(placed, 0.0, radius, low, high);
+    for (size_t i = 0; i < initial.size(); ++i) {
+        float dx = placed.x[i];
+        float dy = placed.y[i];
+        float d2 = dx * dx + dy * dy;
+        if (d2 > high) continue;
+        if (d2 < low) return false;
+
+        double p[3];
+        transformPoint(t, initial[i].coords, p);
+        if (p[0] * p[0] + p[1] * p[1] <= radius * radius) return false;
+    }
+    return true;
+}
+
+bool runFitOption(int argc, char** argv, int& fitExitCode) {
+    if (argc < 2 || strcmp(argv[1], "--fit") != 0) {
+        return false;
+    }
+
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " --fit original.xyz transformed.xyz [rotation_matrix.txt]" << endl;
+        fitExitCode = 1;
+        return true;
+    }
+
+    string originalFile = argv[2];
+    string transformedFile = argv[3];
+    string outputFile = argc > 4 ? argv[4] : "rotation_matrix.txt";
+
+    vector<Atom> originalAtoms, transformedAtoms;
+    int numOriginal, numTransformed;
+    if (!readData(originalFile, originalAtoms, numOriginal) ||
+        !readData(transformedFile, transformedAtoms, numTransformed)) {
+        fitExitCode = 1;
+        return true;
+    }
+
+    Transform t;
+    double rmsd;
+    if (!fitTransform(originalAtoms, transformedAtoms, t, rmsd)) {
+        fitExitCode = 1;
+        return true;
+    }
+
+    cout << "Fitted transform from " << originalFile << " to " << transformedFile
+         << " (RMSD = " << rmsd << " Angstroms)" << endl;
+    fitExitCode = writeTransform(outputFile, t, "Least-squares fit from " + originalFile + " to " + transformedFile) ? 0 : 1;
+    if (fitExitCode == 0) {
+        cout << "Transform written to " << outputFile << endl;
+    }
+    return true;
+}
+
+PlacementOptions::PlacementOptions()
+    : metricsFile("placement_metrics.jsonl"), metricsInterval(5.0), progressInterval(1.0),
+      screening(ScreenExact), sampler(SamplerCap), clash(ClashUniform), clashOverlap(0.4),
+      threads(0) {}
+
+bool parsePlacementOptions(int argc, char** argv, PlacementOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool known = arg == "--metrics-file" || arg == "--metrics-interval" || arg == "--progress-interval"
+                     || arg == "--screening" || arg == "--sampler" || arg == "--clash"
+                     || arg == "--clash-overlap" || arg == "--ensemble" || arg == "--threads";
+        if (known && i + 1 >= argc) {
+            cerr << "Error: Missing value for option " << arg << endl;
+            return false;
+        }
+        if (arg == "--metrics-file") {
+            options.metricsFile = argv[++i];
+        } else if (arg == "--metrics-interval") {
+            options.metricsInterval = atof(argv[++i]);
+        } else if (arg == "--progress-interval") {
+            options.progressInterval = atof(argv[++i]);
+        } else if (arg == "--screening") {
+            string mode = argv[++i];
+            if (mode == "exact") {
+                options.screening = ScreenExact;
+            } else if (mode == "int16") {
+                options.screening = ScreenInt16;
+            } else if (mode == "float32") {
+                options.screening = ScreenFloat32;
+            } else {
+                cerr << "Error: Unknown screening mode " << mode << " (expected exact, int16 or float32)" << endl;
+                return false;
+            }
+        } else if (arg == "--sampler") {
+            string mode = argv[++i];
+            if (mode == "cap") {
+                options.sampler = SamplerCap;
+            } else if (mode == "euler") {
+                options.sampler = SamplerEuler;
+            } else {
+                cerr << "Error: Unknown sampler " << mode << " (expected cap or euler)" << endl;
+                return false;
+            }
+        } else if (arg == "--clash") {
+            string mode = argv[++i];
+            if (mode == "uniform") {
+                options.clash = ClashUniform;
+            } else if (mode == "vdw") {
+                options.clash = ClashVdw;
+            } else {
+                cerr << "Error: Unknown clash model " << mode << " (expected uniform or vdw)" << endl;
+                return false;
+            }
+        } else if (arg == "--clash-overlap") {
+            options.clashOverlap = atof(argv[++i]);
+        } else if (arg == "--ensemble") {
+            options.ensembleFile = argv[++i];
+        } else if (arg == "--threads") {
+            options.threads = atoi(argv[++i]);
+        } else {
+            cerr << "Error: Unknown option " << arg << endl;
+            cerr << "Usage: " << argv[0] << " [--metrics-file path] [--metrics-interval seconds]"
+                 << " [--progress-interval seconds] [--screening exact|int16|float32]"
+                 << " [--sampler cap|euler] [--clash uniform|vdw] [--clash-overlap angstroms]"
+                 << " [--ensemble models.pdb|frames.xyz] [--threads n]" << endl;
+            cerr << "       " << argv[0] << " --fit original.xyz transformed.xyz [rotation_matrix.txt]" << endl;
+            return false;
+        }
+    }
+    return true;
+}
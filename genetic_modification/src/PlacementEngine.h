@@ -0,0 +1,222 @@
+#ifndef PLACEMENTENGINE_H
+#define PLACEMENTENGINE_H
+
+#include <string>
+#include <vector>
+
+// Shared placement engine for the rotate_matrix_* programs.
+//
+// Every candidate placement is described by one rigid-body Transform that
+// maps the initial P2 coordinates onto the placed coordinates, so the exact
+// matrix used during the search can be written out for rotate_protein.py.
+
+struct Atom {
+    char type;
+    double coords[3];
+};
+
+// Homogeneous 4x4 transform (row-major): new = m * [x y z 1]^T.
+// The pivot translation is folded into the last column.
+struct Transform {
+    double m[4][4];
+};
+
+// Structure to store configuration data. Only the transform is kept; the
+// coordinates are regenerated from the initial P2 atoms when written out.
+struct Configuration {
+    int failureCount;
+    double minDistance;
+    Transform transform;
+
+    Configuration();
+};
+
+// Single-precision copy of a set of coordinates, for the float32 screening
+// mode. error bounds |float - double| for every coordinate, so a decision
+// taken in float is only trusted when it holds with that much slack.
+struct FloatCoords {
+    std::vector<float> x, y, z;
+    double maxAbs;   // bound on |coordinate|
+    double error;    // bound on the rounding error of each coordinate
+
+    FloatCoords() : maxAbs(0.0), error(0.0) {}
+    explicit FloatCoords(size_t numAtoms) : x(numAtoms), y(numAtoms), z(numAtoms), maxAbs(0.0), error(0.0) {}
+};
+
+// Per-worker scratch reused by every attempt, so the search loop itself
+// never touches the heap
+struct PlacementWorkspace {
+    std::vector<Atom> placed;   // transformed P2 coordinates
+    FloatCoords placedFloat;    // the same in float (ScreenFloat32 only)
+
+    explicit PlacementWorkspace(size_t numAtoms) : placed(numAtoms), placedFloat(numAtoms) {}
+};
+
+// An example placement kept for visualization and written after the search
+struct StagedImage {
+    Transform transform;
+    int failureCount;
+};
+
+// ── Coordinate files ─────────────────────────────────────────────────────────
+
+// Read an XYZ file (count line, comment line, "type x y z" lines)
+bool readData(const std::string& filename, std::vector<Atom>& atoms, int& numatoms);
+
+// Write an XYZ file with the given comment line
+bool writeXYZ(const std::string& filename, const std::vector<Atom>& atoms, const std::string& comment);
+
+// ── Random rotations ─────────────────────────────────────────────────────────
+
+float ran3(int* idum);
+
+// Rotation matrix from three random Euler angles drawn with ran3
+void randomRotationMatrix(int* idum, double matrix[3][3]);
+
+// ── Transforms ───────────────────────────────────────────────────────────────
+
+Transform identityTransform();
+
+// Rotation about a pivot point: T(pivot) * R * T(-pivot)
+Transform pivotRotation(const double rotation[3][3], const double pivot[3]);
+
+// out = t * in for one point. Every double-precision placement goes through
+// this, so a single atom recomputed later matches applyTransform bit for bit.
+inline void transformPoint(const Transform& t, const double in[3], double out[3]) {
+    const double x = in[0], y = in[1], z = in[2];
+    out[0] = t.m[0][0] * x + t.m[0][1] * y + t.m[0][2] * z + t.m[0][3];
+    out[1] = t.m[1][0] * x + t.m[1][1] * y + t.m[1][2] * z + t.m[1][3];
+    out[2] = t.m[2][0] * x + t.m[2][1] * y + t.m[2][2] * z + t.m[2][3];
+}
+
+// out[i] = t * in[i]; out is resized to match in
+void applyTransform(const Transform& t, const std::vector<Atom>& in, std::vector<Atom>& out);
+
+// Float copy of atoms, and t applied to such a copy in float arithmetic
+// (out must already have in's size). Both fill in maxAbs and error.
+void toFloatCoords(const std::vector<Atom>& atoms, FloatCoords& out);
+void applyTransformFloat(const Transform& t, const FloatCoords& in, FloatCoords& out);
+
+// Least-squares rigid fit (Horn quaternion / Kabsch) mapping original onto
+// transformed. Only needed for structures produced outside the engine.
+bool fitTransform(const std::vector<Atom>& original, const std::vector<Atom>& transformed,
+                  Transform& result, double& rmsd);
+
+// Write a transform as a 4x4 matrix readable by numpy.loadtxt
+bool writeTransform(const std::string& filename, const Transform& t, const std::string& comment);
+
+// ── Clash criteria ───────────────────────────────────────────────────────────
+
+// Interned element codes for Atom::type. The XYZ reader keeps only the first
+// letter of the symbol, so e.g. Cl and Ca count as carbon.
+enum ElementCode {
+    ElementH, ElementC, ElementN, ElementO, ElementS, ElementP, ElementOther,
+    NumElementCodes
+};
+
+inline int elementCode(char type) {
+    switch (type) {
+        case 'H': case 'h': return ElementH;
+        case 'C': case 'c': return ElementC;
+        case 'N': case 'n': return ElementN;
+        case 'O': case 'o': return ElementO;
+        case 'S': case 's': return ElementS;
+        case 'P': case 'p': return ElementP;
+        default: return ElementOther;
+    }
+}
+
+// Bondi van der Waals radii (A), indexed by ElementCode
+constexpr double vdwRadius[NumElementCodes] = {1.20, 1.70, 1.55, 1.52, 1.80, 1.80, 1.70};
+
+// Extra overlap tolerated between hydrogen-bonding partners: polar H to N/O
+// (H...O ~1.9 A) and N/O to N/O (~2.8 A donor-acceptor)
+constexpr bool isPolar(int e) { return e == ElementN || e == ElementO; }
+constexpr double hbondAllowance(int a, int b) {
+    return ((a == ElementH && isPolar(b)) || (b == ElementH && isPolar(a))) ? 0.8
+         : (isPolar(a) && isPolar(b)) ? 0.3 : 0.0;
+}
+
+// Per element-pair clash cut-offs: a capsid/P2 pair of elements (a, b) fails
+// when closer than cutoff[a][b]
+struct ClashTable {
+    double cutoff[NumElementCodes][NumElementCodes];
+    double maxCutoff;
+};
+
+// The same cut-off for every pair (the original 0.5 A criterion)
+ClashTable uniformClashTable(double threshold);
+
+// r_a + r_b - overlap - hbondAllowance(a, b), never below zero
+ClashTable vdwClashTable(double overlap);
+
+// ── Geometry checks ──────────────────────────────────────────────────────────
+
+double calculateMinimumDistance(const std::vector<Atom>& atomsA, const std::vector<Atom>& atomsB);
+int countDistanceFailures(const std::vector<Atom>& atomsA, const std::vector<Atom>& atomsB, double threshold);
+int countDistanceFailures(const std::vector<Atom>& atomsA, const std::vector<Atom>& atomsB, const ClashTable& table);
+
+bool checkAtomsOutsideSphere(const std::vector<Atom>& atoms, const double center[3], double radius);
+bool checkAtomsInsideSphere(const std::vector<Atom>& atoms, const double center[3], double radius);
+// Cylinder is centred on the z-axis and unbounded in z
+bool checkAtomsOutsideCylinder(const std::vector<Atom>& atoms, double radius);
+
+// The same checks on float coordinates placed = t * initial. Atoms too close
+// to the boundary to decide in float are recomputed in double, so the result
+// always equals the double check on applyTransform(t, initial).
+bool checkAtomsOutsideSphereMixed(const Transform& t, const std::vector<Atom>& initial,
+                                  const FloatCoords& placed, const double center[3], double radius);
+bool checkAtomsInsideSphereMixed(const Transform& t, const std::vector<Atom>& initial,
+                                 const FloatCoords& placed, const double center[3], double radius);
+bool checkAtomsOutsideCylinderMixed(const Transform& t, const std::vector<Atom>& initial,
+                                    const FloatCoords& placed, double radius);
+
+// Handle "--fit original.xyz transformed.xyz [output]" for the rotate mains.
+// Returns true if the option was present (the program should then exit with
+// fitExitCode).
+bool runFitOption(int argc, char** argv, int& fitExitCode);
+
+// How the clash kernels screen capsid atoms (see CapsidIndex); every mode
+// gives the same minimum distance and failure count
+enum ScreeningMode {
+    ScreenExact,     // double coordinates only
+    ScreenInt16,     // int16 fixed-point screen, double re-verification (experimental)
+    ScreenFloat32    // float transforms and screen, double re-verification
+};
+
+// Which pairs count as clashes
+enum ClashModel {
+    ClashUniform,    // one distance threshold for every pair
+    ClashVdw         // element-pair cut-offs from van der Waals radii
+};
+
+// How candidate rotations are drawn (see OrientationSampler)
+enum SamplerMode {
+    SamplerEuler,    // three uniform Euler angles over all of rotation space
+    SamplerCap       // uniform rotations restricted to the prefilter's feasible cap
+};
+
+// ── Command-line options ─────────────────────────────────────────────────────
+
+struct PlacementOptions {
+    std::string metricsFile;    // JSON lines output; empty disables it
+    double metricsInterval;     // seconds between interval lines; <= 0 for summary only
+    double progressInterval;    // minimum seconds between console progress lines
+    ScreeningMode screening;    // clash-kernel screening mode
+    SamplerMode sampler;        // rotation sampler
+    ClashModel clash;           // clash criterion
+    double clashOverlap;        // vdW overlap tolerated before a pair clashes (ClashVdw)
+    std::string ensembleFile;   // multi-model PDB / multi-frame XYZ searched instead of P2.xyz
+    int threads;                // ensemble worker threads; 0 = one per core
+
+    PlacementOptions();
+};
+
+// Parse "--metrics-file", "--metrics-interval", "--progress-interval",
+// "--screening exact|int16|float32", "--sampler cap|euler",
+// "--clash uniform|vdw", "--clash-overlap angstroms", "--ensemble path"
+// and "--threads n".
+// Returns false (after printing usage) on an unknown or incomplete option.
+bool parsePlacementOptions(int argc, char** argv, PlacementOptions& options);
+
+#endif // PLACEMENTENGINE_H
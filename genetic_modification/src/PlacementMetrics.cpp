@@ -0,0 +1,228 @@
+#include "PlacementMetrics.h"
+#include <iostream>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+using namespace std;
+
+const int DistanceHistogram::numBins;
+constexpr double DistanceHistogram::binWidth;
+const int FailureHistogram::numBins;
+
+DistanceHistogram::DistanceHistogram() : overflow(0) {
+    memset(counts, 0, sizeof(counts));
+}
+
+void DistanceHistogram::add(double value) {
+    int bin = (int)(value / binWidth);
+    if (bin < 0) bin = 0;
+    if (bin >= numBins) {
+        overflow++;
+    } else {
+        counts[bin]++;
+    }
+}
+
+void DistanceHistogram::merge(const DistanceHistogram& other) {
+    for (int i = 0; i < numBins; ++i) counts[i] += other.counts[i];
+    overflow += other.overflow;
+}
+
+FailureHistogram::FailureHistogram() {
+    memset(counts, 0, sizeof(counts));
+}
+
+void FailureHistogram::add(int value) {
+    int bin = 0;
+    while (value > 0 && bin < numBins - 1) {
+        value >>= 1;
+        bin++;
+    }
+    counts[bin]++;
+}
+
+void FailureHistogram::merge(const FailureHistogram& other) {
+    for (int i = 0; i < numBins; ++i) counts[i] += other.counts[i];
+}
+
+PlacementCounters::PlacementCounters()
+    : attempts(0), prefilterRejections(0), fullChecks(0), samplerRejections(0),
+      transformSeconds(0.0), prefilterSeconds(0.0), clashSeconds(0.0) {}
+
+void PlacementCounters::merge(const PlacementCounters& other) {
+    attempts += other.attempts;
+    prefilterRejections += other.prefilterRejections;
+    fullChecks += other.fullChecks;
+    samplerRejections += other.samplerRejections;
+    transformSeconds += other.transformSeconds;
+    prefilterSeconds += other.prefilterSeconds;
+    clashSeconds += other.clashSeconds;
+    minDistance.merge(other.minDistance);
+    failures.merge(other.failures);
+}
+
+PlacementMetrics::PlacementMetrics(int numWorkers, const string& jsonPath,
+                                   double intervalSeconds, double progressSeconds)
+    : workers(numWorkers > 0 ? numWorkers : 1), jsonFile(NULL),
+      intervalSeconds(intervalSeconds), progressSeconds(progressSeconds),
+      start(chrono::steady_clock::now()), nextReport(intervalSeconds), nextProgress(0.0),
+      loopAllocations(-1), jsonBuffer(1 << 16) {
+    if (!jsonPath.empty()) {
+        jsonFile = fopen(jsonPath.c_str(), "w");
+        if (!jsonFile) {
+            cerr << "Warning: Could not open metrics file " << jsonPath << endl;
+        } else {
+            setvbuf(jsonFile, &jsonBuffer[0], _IOFBF, jsonBuffer.size());
+        }
+    }
+}
+
+PlacementMetrics::~PlacementMetrics() {
+    if (jsonFile) fclose(jsonFile);
+}
+
+double PlacementMetrics::elapsedSeconds() const {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+PlacementCounters PlacementMetrics::totals() const {
+    PlacementCounters total;
+    for (size_t i = 0; i < workers.size(); ++i) total.merge(workers[i]);
+    return total;
+}
+
+void PlacementMetrics::maybeReport() {
+    if (!jsonFile || intervalSeconds <= 0.0) return;
+    double elapsed = elapsedSeconds();
+    if (elapsed < nextReport) return;
+    nextReport = elapsed + intervalSeconds;
+    writeLine("interval", totals(), false);
+}
+
+bool PlacementMetrics::progressDue() {
+    double elapsed = elapsedSeconds();
+    if (elapsed < nextProgress) return false;
+    nextProgress = elapsed + progressSeconds;
+    return true;
+}
+
+// Rates are per attempt; 0 when nothing has been attempted yet
+static double rate(long long count, long long attempts) {
+    return attempts > 0 ? (double)count / (double)attempts : 0.0;
+}
+
+void PlacementMetrics::writeLine(const char* kind, const PlacementCounters& total, bool withHistograms) {
+    double elapsed = elapsedSeconds();
+    fprintf(jsonFile,
+            "{\"type\":\"%s\",\"elapsed_s\":%.6f,\"attempts\":%lld,\"attempts_per_s\":%.3f,"
+            "\"prefilter_rejections\":%lld,\"prefilter_rejection_rate\":%.6f,"
+            "\"full_checks\":%lld,\"full_check_rate\":%.6f,\"sampler_rejections\":%lld,"
+            "\"time_s\":{\"transform\":%.6f,\"prefilter\":%.6f,\"clash\":%.6f},\"workers\":[",
+            kind, elapsed, total.attempts, elapsed > 0.0 ? total.attempts / elapsed : 0.0,
+            total.prefilterRejections, rate(total.prefilterRejections, total.attempts),
+            total.fullChecks, rate(total.fullChecks, total.attempts), total.samplerRejections,
+            total.transformSeconds, total.prefilterSeconds, total.clashSeconds);
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const PlacementCounters& w = workers[i];
+        fprintf(jsonFile, "%s{\"id\":%d,\"attempts\":%lld,\"prefilter_rejections\":%lld,\"full_checks\":%lld}",
+                i ? "," : "", (int)i, w.attempts, w.prefilterRejections, w.fullChecks);
+    }
+    fprintf(jsonFile, "]");
+
+    if (withHistograms && loopAllocations >= 0) {
+        fprintf(jsonFile, ",\"loop_heap_allocations\":%lld", loopAllocations);
+    }
+
+    if (withHistograms) {
+        fprintf(jsonFile, ",\"min_distance_hist\":{\"bin_width\":%g,\"counts\":[", DistanceHistogram::binWidth);
+        for (int i = 0; i < DistanceHistogram::numBins; ++i) {
+            fprintf(jsonFile, "%s%lld", i ? "," : "", total.minDistance.counts[i]);
+        }
+        fprintf(jsonFile, "],\"overflow\":%lld}", total.minDistance.overflow);
+
+        // Trailing empty bins are trimmed; bin k covers [2^(k-1), 2^k)
+        int lastBin = 0;
+        for (int i = 0; i < FailureHistogram::numBins; ++i) {
+            if (total.failures.counts[i]) lastBin = i;
+        }
+        fprintf(jsonFile, ",\"failure_hist\":{\"bins\":\"log2\",\"counts\":[");
+        for (int i = 0; i <= lastBin; ++i) {
+            fprintf(jsonFile, "%s%lld", i ? "," : "", total.failures.counts[i]);
+        }
+        fprintf(jsonFile, "]}");
+    }
+
+    fprintf(jsonFile, "}\n");
+    fflush(jsonFile);
+}
+
+void PlacementMetrics::writeSummary() {
+    PlacementCounters total = totals();
+    if (jsonFile) {
+        writeLine("summary", total, true);
+    }
+
+    double elapsed = elapsedSeconds();
+    cout << "\n=== PLACEMENT METRICS ===" << endl;
+    cout << "Elapsed: " << elapsed << " s, " << (elapsed > 0.0 ? total.attempts / elapsed : 0.0)
+         << " attempts/s" << endl;
+    cout << "Prefilter rejections: " << total.prefilterRejections
+         << " (" << 100.0 * rate(total.prefilterRejections, total.attempts) << "%)" << endl;
+    if (total.samplerRejections > 0) {
+        cout << "Sampler rejections: " << total.samplerRejections << " (dot-product tests, no transform)" << endl;
+    }
+    cout << "Full checks: " << total.fullChecks
+         << " (" << 100.0 * rate(total.fullChecks, total.attempts) << "%)" << endl;
+    cout << "Time split: transform " << total.transformSeconds << " s, prefilter "
+         << total.prefilterSeconds << " s, clash " << total.clashSeconds << " s" << endl;
+    if (loopAllocations >= 0) {
+        cout << "Heap allocations in search loop: " << loopAllocations << endl;
+    }
+}
+
+#ifdef PLACEMENT_COUNT_ALLOCS
+
+static atomic<long long> allocationCount(0);
+
+long long heapAllocationCount() {
+    return allocationCount.load(memory_order_relaxed);
+}
+
+// Counting replacements for the global allocation functions (debug builds only)
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+#else
+
+long long heapAllocationCount() {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef PLACEMENTMETRICS_H
+#define PLACEMENTMETRICS_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+// Telemetry for the placement search: per-worker counters, stage timings and
+// histograms, written as JSON lines at a fixed interval plus a final summary.
+
+// Fixed-bin histogram of minimum distances (Angstroms)
+struct DistanceHistogram {
+    static const int numBins = 40;
+    static constexpr double binWidth = 0.25;
+    long long counts[numBins];
+    long long overflow;
+
+    DistanceHistogram();
+    void add(double value);
+    void merge(const DistanceHistogram& other);
+};
+
+// Power-of-two histogram of failure counts: bin 0 holds 0, bin k holds [2^(k-1), 2^k)
+struct FailureHistogram {
+    static const int numBins = 32;
+    long long counts[numBins];
+
+    FailureHistogram();
+    void add(int value);
+    void merge(const FailureHistogram& other);
+};
+
+// Counters owned by one worker thread; only that thread writes them
+struct PlacementCounters {
+    long long attempts;
+    long long prefilterRejections;   // failed the sphere/cylinder test
+    long long fullChecks;            // went on to the clash kernel
+    long long samplerRejections;     // proposals the orientation sampler discarded
+    double transformSeconds;
+    double prefilterSeconds;
+    double clashSeconds;
+    DistanceHistogram minDistance;
+    FailureHistogram failures;
+
+    PlacementCounters();
+    void merge(const PlacementCounters& other);
+};
+
+// Lap timer for splitting an attempt into stages
+class StageTimer {
+public:
+    StageTimer() : last(std::chrono::steady_clock::now()) {}
+
+    // Seconds since construction or the previous lap
+    double lap() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return seconds;
+    }
+
+private:
+    std::chrono::steady_clock::time_point last;
+};
+
+class PlacementMetrics {
+public:
+    // intervalSeconds <= 0 disables the periodic lines (the summary is still written).
+    // An empty jsonPath disables JSON output entirely.
+    PlacementMetrics(int numWorkers, const std::string& jsonPath,
+                     double intervalSeconds, double progressSeconds);
+    ~PlacementMetrics();
+
+    PlacementCounters& worker(int index) { return workers[index]; }
+    int numWorkers() const { return (int)workers.size(); }
+
+    // Write an interval line if the interval has elapsed
+    void maybeReport();
+
+    // True at most once per progress interval; use to gate console progress lines
+    bool progressDue();
+
+    // Write the final summary line and print a short console summary
+    void writeSummary();
+
+    PlacementCounters totals() const;
+    double elapsedSeconds() const;
+
+    // Heap allocations made by the search loop, reported in the summary (-1 = not counted)
+    void setLoopAllocations(long long count) { loopAllocations = count; }
+
+private:
+    void writeLine(const char* kind, const PlacementCounters& total, bool withHistograms);
+
+    std::vector<PlacementCounters> workers;
+    FILE* jsonFile;
+    double intervalSeconds;
+    double progressSeconds;
+    std::chrono::steady_clock::time_point start;
+    double nextReport;
+    double nextProgress;
+    long long loopAllocations;
+    std::vector<char> jsonBuffer;   // stdio buffer, allocated up front rather than on first write
+};
+
+// Number of operator new calls so far, or -1 unless built with
+// -DPLACEMENT_COUNT_ALLOCS (which replaces the global operator new)
+long long heapAllocationCount();
+
+#endif // PLACEMENTMETRICS_H
@@ -0,0 +1,559 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include "PlacementEngine.h"
+#include "CapsidIndex.h"
+#include "PlacementMetrics.h"
+#include "OrientationSampler.h"
+
+//Run using: g++ -std=c++11 -O2 -o placement_bench placement_bench.cpp PlacementEngine.cpp CapsidIndex.cpp PlacementMetrics.cpp OrientationSampler.cpp
+//           ./placement_bench [--quick] [--capsid-sizes 10000,100000] [--fusion-sizes 1000,5000]
+//                             [--shape sphere|helix|both] [--max-pairs N] [--output placement_bench.jsonl]
+//           Add -DPLACEMENT_COUNT_ALLOCS to also report heap allocations in the search loop.
+//           Exits with 2 if a screening or indexed kernel disagrees with the exact or
+//           brute-force result, if the orientation sampler does not give up on an empty
+//           feasible region, or (with PLACEMENT_COUNT_ALLOCS) if the search loop allocates.
+//
+// Benchmarks every stage of the placement search on synthetic capsids and
+// fusion domains, so results are reproducible offline without VMD or real PDBs.
+// One JSON line is written per (shape, capsid size, fusion size) case.
+
+using namespace std;
+
+const double pi = 3.14159265358979;
+
+// Average heavy-atom number density of a folded protein (atoms per cubic Angstrom)
+const double proteinDensity = 0.05;
+const double shellThickness = 30.0;    // Thickness of the synthetic capsid shell
+const double helixRise = 1.408;        // TMV-like helix: rise per subunit (A)
+const double helixSubunitsPerTurn = 16.33;
+const double helixRadius = 60.0;       // Radius of the subunit centres
+const int helixAtomsPerSubunit = 1200;
+const double mindist_threshold = 0.50;
+const unsigned int benchSeed = 20240611;
+
+struct BenchCase {
+    string shape;        // "sphere" or "helix"
+    int capsidAtoms;
+    int fusionAtoms;
+};
+
+struct StageTiming {
+    int reps;
+    double meanSeconds;
+    double minSeconds;
+};
+
+// Uniform [0,1) from the raw engine output so results do not depend on the
+// standard library's distribution implementation
+static double uniform(mt19937& gen) {
+    return gen() / 4294967296.0;
+}
+
+// Uniform point inside a ball of the given radius
+static void randomInBall(mt19937& gen, double radius, double out[3]) {
+    double r = radius * cbrt(uniform(gen));
+    double cosTheta = 2.0 * uniform(gen) - 1.0;
+    double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+    double phi = 2.0 * pi * uniform(gen);
+    out[0] = r * sinTheta * cos(phi);
+    out[1] = r * sinTheta * sin(phi);
+    out[2] = r * cosTheta;
+}
+
+// Spherical shell centred on the origin; returns the outer radius
+static double makeSphereCapsid(int numAtoms, mt19937& gen, vector<Atom>& atoms) {
+    double inner = sqrt(numAtoms / (4.0 * pi * shellThickness * proteinDensity));
+    if (inner < 40.0) inner = 40.0;
+    double outer = inner + shellThickness;
+    double inner3 = inner * inner * inner;
+    double outer3 = outer * outer * outer;
+
+    atoms.resize(numAtoms);
+    for (int i = 0; i < numAtoms; ++i) {
+        double r = cbrt(inner3 + (outer3 - inner3) * uniform(gen));
+        double cosTheta = 2.0 * uniform(gen) - 1.0;
+        double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+        double phi = 2.0 * pi * uniform(gen);
+        atoms[i].type = "CNOS"[i % 4];
+        atoms[i].coords[0] = r * sinTheta * cos(phi);
+        atoms[i].coords[1] = r * sinTheta * sin(phi);
+        atoms[i].coords[2] = r * cosTheta;
+    }
+    return outer;
+}
+
+// Helical rod along z (TMV-like): globular subunits on a helix; returns the outer radius
+static double makeHelixCapsid(int numAtoms, mt19937& gen, vector<Atom>& atoms) {
+    double blobRadius = cbrt(3.0 * helixAtomsPerSubunit / (4.0 * pi * proteinDensity));
+    int numSubunits = (numAtoms + helixAtomsPerSubunit - 1) / helixAtomsPerSubunit;
+    double zOffset = 0.5 * numSubunits * helixRise;
+
+    atoms.resize(numAtoms);
+    for (int i = 0; i < numAtoms; ++i) {
+        int subunit = i / helixAtomsPerSubunit;
+        double angle = 2.0 * pi * subunit / helixSubunitsPerTurn;
+        double p[3];
+        randomInBall(gen, blobRadius, p);
+        atoms[i].type = "CNOS"[i % 4];
+        atoms[i].coords[0] = helixRadius * cos(angle) + p[0];
+        atoms[i].coords[1] = helixRadius * sin(angle) + p[1];
+        atoms[i].coords[2] = subunit * helixRise - zOffset + p[2];
+    }
+    return helixRadius + blobRadius;
+}
+
+// Compact globular domain tethered to the capsid surface through atom 0 (the pivot)
+static void makeFusionDomain(int numAtoms, double surfaceRadius, mt19937& gen, vector<Atom>& atoms) {
+    double globuleRadius = cbrt(3.0 * numAtoms / (4.0 * pi * proteinDensity));
+    double pivot[3] = {surfaceRadius + 2.0, 0.0, 0.0};
+    double centre[3] = {pivot[0] + globuleRadius + 4.0, 0.0, 0.0};
+
+    atoms.resize(numAtoms);
+    atoms[0].type = 'N';
+    for (int k = 0; k < 3; ++k) atoms[0].coords[k] = pivot[k];
+    for (int i = 1; i < numAtoms; ++i) {
+        double p[3];
+        randomInBall(gen, globuleRadius, p);
+        atoms[i].type = "CNOS"[i % 4];
+        for (int k = 0; k < 3; ++k) atoms[i].coords[k] = centre[k] + p[k];
+    }
+}
+
+// Run f repeatedly until minSeconds have elapsed or maxReps is reached (at least once)
+template <typename F>
+static StageTiming timeStage(F f, int maxReps, double minSeconds) {
+    StageTiming timing;
+    timing.reps = 0;
+    timing.minSeconds = 1e300;
+    double total = 0.0;
+    while (timing.reps < maxReps && (timing.reps == 0 || total < minSeconds)) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        f();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        total += seconds;
+        if (seconds < timing.minSeconds) timing.minSeconds = seconds;
+        timing.reps++;
+    }
+    timing.meanSeconds = total / timing.reps;
+    return timing;
+}
+
+static bool passesPrefilter(const BenchCase& c, const vector<Atom>& atoms, double radius) {
+    const double origin[3] = {0.0, 0.0, 0.0};
+    if (c.shape == "helix") {
+        return checkAtomsOutsideCylinder(atoms, radius);
+    }
+    return checkAtomsOutsideSphere(atoms, origin, radius);
+}
+
+static void writeTiming(ostream& out, const char* name, const StageTiming& t) {
+    out << ",\"" << name << "\":{\"reps\":" << t.reps
+        << ",\"mean_s\":" << t.meanSeconds << ",\"min_s\":" << t.minSeconds << "}";
+}
+
+static void printTiming(const char* name, const StageTiming& t) {
+    printf("  %-14s %12.6f s (min %.6f s, %d reps)\n", name, t.meanSeconds, t.minSeconds, t.reps);
+}
+
+// Parse a comma-separated list of positive integers
+static bool parseSizes(const string& text, vector<int>& sizes) {
+    sizes.clear();
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        int value = atoi(item.c_str());
+        if (value <= 0) {
+            cerr << "Error: Invalid size '" << item << "'" << endl;
+            return false;
+        }
+        sizes.push_back(value);
+    }
+    return !sizes.empty();
+}
+
+// Returns false if a cross-check failed
+static bool runCase(const BenchCase& c, double maxPairs, ostream& json) {
+    mt19937 gen(benchSeed + c.capsidAtoms * 7 + c.fusionAtoms);
+    vector<Atom> capsid, fusion;
+    double surfaceRadius = c.shape == "helix" ? makeHelixCapsid(c.capsidAtoms, gen, capsid)
+                                              : makeSphereCapsid(c.capsidAtoms, gen, capsid);
+    makeFusionDomain(c.fusionAtoms, surfaceRadius, gen, fusion);
+    double prefilterRadius = surfaceRadius;
+
+    printf("\n%s capsid %d atoms, fusion %d atoms\n", c.shape.c_str(), c.capsidAtoms, c.fusionAtoms);
+
+    // Parse: round-trip both structures through XYZ files in the working directory
+    const string capsidFile = "bench_capsid.xyz";
+    const string fusionFile = "bench_fusion.xyz";
+    writeXYZ(capsidFile, capsid, "synthetic capsid");
+    writeXYZ(fusionFile, fusion, "synthetic fusion domain");
+    vector<Atom> parsedCapsid, parsedFusion;
+    StageTiming parse = timeStage([&]() {
+        int n;
+        readData(capsidFile, parsedCapsid, n);
+        readData(fusionFile, parsedFusion, n);
+    }, 3, 0.0);
+    remove(capsidFile.c_str());
+    remove(fusionFile.c_str());
+
+    // A fixed pool of pivot rotations shared by the transform and prefilter stages
+    const int poolSize = 256;
+    int idum = -873;
+    const double pivot[3] = {fusion[0].coords[0], fusion[0].coords[1], fusion[0].coords[2]};
+    vector<Transform> pool(poolSize);
+    for (int i = 0; i < poolSize; ++i) {
+        double rotation[3][3];
+        randomRotationMatrix(&idum, rotation);
+        pool[i] = pivotRotation(rotation, pivot);
+    }
+
+    vector<Atom> placed;
+    int next = 0;
+    StageTiming transform = timeStage([&]() {
+        applyTransform(pool[next++ % poolSize], fusion, placed);
+    }, 100000, 0.2);
+
+    // The same transform in float, as run by --screening float32
+    FloatCoords fusionFloat, placedFloat(fusion.size());
+    toFloatCoords(fusion, fusionFloat);
+    next = 0;
+    StageTiming transformFloat = timeStage([&]() {
+        applyTransformFloat(pool[next++ % poolSize], fusionFloat, placedFloat);
+    }, 100000, 0.2);
+
+    // Prefilter cost depends on how early a rotation fails, so cycle through the pool
+    vector<vector<Atom> > placedPool(poolSize);
+    int passing = -1;
+    for (int i = 0; i < poolSize; ++i) {
+        applyTransform(pool[i], fusion, placedPool[i]);
+        if (passing < 0 && passesPrefilter(c, placedPool[i], prefilterRadius)) passing = i;
+    }
+    int passCount = 0;
+    next = 0;
+    StageTiming prefilter = timeStage([&]() {
+        if (passesPrefilter(c, placedPool[next++ % poolSize], prefilterRadius)) passCount++;
+    }, 1000000, 0.2);
+
+    json << "{\"type\":\"case\",\"shape\":\"" << c.shape << "\",\"capsid_atoms\":" << c.capsidAtoms
+         << ",\"fusion_atoms\":" << c.fusionAtoms << ",\"prefilter_radius\":" << prefilterRadius;
+    writeTiming(json, "parse", parse);
+    writeTiming(json, "transform", transform);
+    writeTiming(json, "transform_float32", transformFloat);
+    writeTiming(json, "prefilter", prefilter);
+    json << ",\"prefilter_pass_rate\":" << (double)passCount / prefilter.reps;
+
+    printTiming("parse", parse);
+    printTiming("transform", transform);
+    printTiming("transform f32", transformFloat);
+    printTiming("prefilter", prefilter);
+
+    CapsidIndex index;
+    StageTiming indexBuild = timeStage([&]() { index.build(capsid); }, 3, 0.0);
+
+    const int candidateIndex = passing >= 0 ? passing : 0;
+    const vector<Atom>& candidate = placedPool[candidateIndex];
+    double mindist = 0.0;
+    int failures = 0;
+    StageTiming minDistance = timeStage([&]() {
+        mindist = index.minDistance(candidate);
+    }, 1000, 0.2);
+    StageTiming failureCount = timeStage([&]() {
+        failures = index.countFailures(candidate, mindist_threshold);
+    }, 1000, 0.2);
+
+    // Element-pair van der Waals cut-offs (--clash vdw) through the same kernel
+    const ClashTable vdwTable = vdwClashTable(0.4);
+    int failuresVdw = 0;
+    StageTiming failureCountVdw = timeStage([&]() {
+        failuresVdw = index.countFailures(candidate, vdwTable);
+    }, 1000, 0.2);
+
+    // Same queries screened through the int16 fixed-point copies
+    double mindistInt16 = 0.0;
+    int failuresInt16 = 0;
+    index.setScreening(ScreenInt16);
+    StageTiming minDistanceInt16 = timeStage([&]() {
+        mindistInt16 = index.minDistance(candidate);
+    }, 1000, 0.2);
+    StageTiming failureCountInt16 = timeStage([&]() {
+        failuresInt16 = index.countFailures(candidate, mindist_threshold);
+    }, 1000, 0.2);
+    index.setScreening(ScreenExact);
+    bool int16Match = mindistInt16 == mindist && failuresInt16 == failures;
+
+    // The same candidate moved far outside the capsid grid, where the edge
+    // cells it is clamped to are tens of thousands of quantization steps away
+    const double farOffsets[] = {300.0, 480.0, 900.0, 5000.0};
+    vector<Atom> far;
+    bool int16FarMatch = true;
+    for (int f = 0; f < 4; ++f) {
+        far = candidate;
+        for (size_t a = 0; a < far.size(); ++a) far[a].coords[0] += farOffsets[f];
+        double farMindist = index.minDistance(far);
+        int farFailures = index.countFailures(far, mindist_threshold);
+        int farFailuresVdw = index.countFailures(far, vdwTable);
+        index.setScreening(ScreenInt16);
+        bool farMatch = index.minDistance(far) == farMindist &&
+                        index.countFailures(far, mindist_threshold) == farFailures &&
+                        index.countFailures(far, vdwTable) == farFailuresVdw;
+        index.setScreening(ScreenExact);
+        if (!farMatch) {
+            printf("  FAILED: int16 screening disagrees with the exact kernels %.0f A outside the capsid\n",
+                   farOffsets[f]);
+            int16FarMatch = false;
+        }
+    }
+
+    // Float transform and screen with double confirmation
+    double mindistFloat = 0.0;
+    int failuresFloat = 0;
+    applyTransformFloat(pool[candidateIndex], fusionFloat, placedFloat);
+    StageTiming minDistanceFloat = timeStage([&]() {
+        mindistFloat = index.minDistanceMixed(pool[candidateIndex], fusion, placedFloat);
+    }, 1000, 0.2);
+    StageTiming failureCountFloat = timeStage([&]() {
+        failuresFloat = index.countFailuresMixed(pool[candidateIndex], fusion, placedFloat, mindist_threshold);
+    }, 1000, 0.2);
+    bool floatMatch = mindistFloat == mindist && failuresFloat == failures;
+
+    // Orientation sampling: time to one placement that passes the prefilter,
+    // Euler angles with rejection versus the cap sampler
+    const double origin[3] = {0.0, 0.0, 0.0};
+    OrientationSampler sampler;
+    bool samplerOk = c.shape == "helix" ? sampler.initCylinderOutside(fusion, pivot, prefilterRadius)
+                                        : sampler.initSphereOutside(fusion, pivot, origin, prefilterRadius);
+    const int maxTries = 100000;
+    int eulerIdum = -873, capIdum = -873;
+    StageTiming eulerSampling = timeStage([&]() {
+        for (int tries = 0; tries < maxTries; ++tries) {
+            double rotation[3][3];
+            randomRotationMatrix(&eulerIdum, rotation);
+            applyTransform(pivotRotation(rotation, pivot), fusion, placed);
+            if (passesPrefilter(c, placed, prefilterRadius)) break;
+        }
+    }, 10000, 0.2);
+    StageTiming capSampling = timeStage([&]() {
+        for (int tries = 0; tries < maxTries; ++tries) {
+            double rotation[3][3];
+            sampler.sample(&capIdum, rotation);
+            applyTransform(pivotRotation(rotation, pivot), fusion, placed);
+            if (passesPrefilter(c, placed, prefilterRadius)) break;
+        }
+    }, 10000, 0.2);
+
+    // Full search: the rotate_matrix_* loop with a small budget of distance checks
+    const int searchDistanceChecks = 3;
+    const int searchMaxAttempts = 100000;
+    int searchAttempts = 0, searchChecks = 0;
+    bool searchPerfect = false;
+    long long allocationsBefore = heapAllocationCount();
+    StageTiming search = timeStage([&]() {
+        int searchIdum = -873;
+        searchAttempts = searchChecks = 0;
+        searchPerfect = false;
+        while (searchChecks < searchDistanceChecks && !searchPerfect && searchAttempts < searchMaxAttempts) {
+            searchAttempts++;
+            double rotation[3][3];
+            sampler.sample(&searchIdum, rotation);
+            applyTransform(pivotRotation(rotation, pivot), fusion, placed);
+            if (!passesPrefilter(c, placed, prefilterRadius)) continue;
+            searchChecks++;
+            index.minDistance(placed);
+            searchPerfect = index.countFailures(placed, mindist_threshold) == 0;
+        }
+    }, 5, 0.5);
+    long long searchAllocations = allocationsBefore >= 0 ? heapAllocationCount() - allocationsBefore : -1;
+
+    writeTiming(json, "index_build", indexBuild);
+    writeTiming(json, "min_distance", minDistance);
+    writeTiming(json, "failure_count", failureCount);
+    writeTiming(json, "failure_count_vdw", failureCountVdw);
+    writeTiming(json, "min_distance_int16", minDistanceInt16);
+    writeTiming(json, "failure_count_int16", failureCountInt16);
+    json << ",\"int16_match\":" << (int16Match && int16FarMatch ? "true" : "false");
+    writeTiming(json, "min_distance_float32", minDistanceFloat);
+    writeTiming(json, "failure_count_float32", failureCountFloat);
+    json << ",\"float32_match\":" << (floatMatch ? "true" : "false");
+    writeTiming(json, "sampling_euler", eulerSampling);
+    writeTiming(json, "sampling_cap", capSampling);
+    json << ",\"sampler_ok\":" << (samplerOk ? "true" : "false") << ",\"sampler_coverage\":" << sampler.coverage();
+    writeTiming(json, "full_search", search);
+    json << ",\"min_distance\":" << mindist << ",\"failures\":" << failures << ",\"failures_vdw\":" << failuresVdw
+         << ",\"search_attempts\":" << searchAttempts << ",\"search_checks\":" << searchChecks
+         << ",\"search_perfect\":" << (searchPerfect ? "true" : "false");
+    if (searchAllocations >= 0) {
+        json << ",\"search_heap_allocations\":" << searchAllocations;
+    }
+
+    printTiming("index_build", indexBuild);
+    printTiming("min_distance", minDistance);
+    printTiming("failure_count", failureCount);
+    printTiming("failures vdw", failureCountVdw);
+    printTiming("min_dist int16", minDistanceInt16);
+    printTiming("failures int16", failureCountInt16);
+    if (!int16Match) {
+        printf("  FAILED: int16 screening disagrees with the exact kernels\n");
+    }
+    printTiming("min_dist f32", minDistanceFloat);
+    printTiming("failures f32", failureCountFloat);
+    if (!floatMatch) {
+        printf("  FAILED: float32 screening disagrees with the exact kernels\n");
+    }
+    printTiming("sampling euler", eulerSampling);
+    printTiming("sampling cap", capSampling);
+    printf("  cap sampler covers %.2f%% of rotations\n", 100.0 * sampler.coverage());
+    printTiming("full_search", search);
+    printf("  search: %d attempts, %d distance checks%s\n", searchAttempts, searchChecks,
+           searchPerfect ? ", perfect placement" : "");
+    if (searchAllocations >= 0) {
+        printf("  search heap allocations: %lld%s\n", searchAllocations,
+               searchAllocations > 0 ? " (FAILED: the search loop must not allocate)" : "");
+    }
+    bool passed = int16Match && int16FarMatch && floatMatch && searchAllocations <= 0;
+
+    // Brute-force reference kernels are quadratic; skip them beyond the pair budget
+    double pairs = (double)c.capsidAtoms * c.fusionAtoms;
+    if (maxPairs > 0.0 && pairs > maxPairs) {
+        printf("  brute-force stages skipped (%.3g pairs > --max-pairs %.3g)\n", pairs, maxPairs);
+        json << ",\"brute_skipped\":true}\n";
+        json.flush();
+        return passed;
+    }
+
+    double bruteMindist = 0.0;
+    int bruteFailures = 0;
+    StageTiming bruteMinDistance = timeStage([&]() {
+        bruteMindist = calculateMinimumDistance(capsid, candidate);
+    }, 20, 0.5);
+    StageTiming bruteFailureCount = timeStage([&]() {
+        bruteFailures = countDistanceFailures(capsid, candidate, mindist_threshold);
+    }, 20, 0.5);
+    int bruteFailuresVdw = countDistanceFailures(capsid, candidate, vdwTable);
+    bool match = bruteMindist == mindist && bruteFailures == failures && bruteFailuresVdw == failuresVdw;
+
+    writeTiming(json, "min_distance_brute", bruteMinDistance);
+    writeTiming(json, "failure_count_brute", bruteFailureCount);
+    json << ",\"brute_match\":" << (match ? "true" : "false") << "}\n";
+    json.flush();
+
+    printTiming("min_dist brute", bruteMinDistance);
+    printTiming("failures brute", bruteFailureCount);
+    if (!match) {
+        printf("  FAILED: indexed kernels disagree with brute force\n");
+    }
+    return passed && match;
+}
+
+// Two P2 atoms 9 A either side of a pivot 5 A off the centre of a 10 A
+// confining sphere: each cap alone is feasible, both together are not. The
+// sampler must give up after a bounded number of proposals and fall back.
+static bool runSamplerExhaustion(ostream& json) {
+    vector<Atom> rod(3);
+    for (int i = 0; i < 3; ++i) {
+        rod[i].type = 'C';
+        rod[i].coords[0] = 5.0 + 9.0 * (i - 1);
+        rod[i].coords[1] = rod[i].coords[2] = 0.0;
+    }
+    const double center[3] = {0.0, 0.0, 0.0};
+    OrientationSampler sampler;
+    bool initOk = sampler.initSphereInside(rod, rod[1].coords, center, 10.0);
+
+    const int calls = 20;
+    int idum = -873;
+    long long rejections = 0, rejectionsAfterFallback = 0;
+    for (int i = 0; i < calls && initOk; ++i) {
+        bool fellBack = sampler.constrainingAtom() < 0;
+        double rotation[3][3];
+        int rejected = sampler.sample(&idum, rotation);
+        rejections += rejected;
+        if (fellBack) rejectionsAfterFallback += rejected;
+    }
+    bool passed = initOk && sampler.constrainingAtom() < 0 && rejectionsAfterFallback == 0 &&
+                  sampler.exhaustedCalls() > 0 && rejections <= 10000LL * sampler.exhaustedCalls();
+
+    json << "{\"type\":\"sampler_exhaustion\",\"calls\":" << calls << ",\"rejections\":" << rejections
+         << ",\"exhausted_calls\":" << sampler.exhaustedCalls()
+         << ",\"fell_back\":" << (sampler.constrainingAtom() < 0 ? "true" : "false")
+         << ",\"passed\":" << (passed ? "true" : "false") << "}\n";
+    cout << "Sampler on an empty feasible region: " << rejections << " rejections in " << calls << " calls, "
+         << (passed ? "fell back" : "FAILED") << endl;
+    return passed;
+}
+
+int main(int argc, char** argv) {
+    vector<int> capsidSizes = {10000, 100000, 500000, 2000000};
+    vector<int> fusionSizes = {1000, 5000, 20000};
+    vector<string> shapes = {"sphere", "helix"};
+    string outputFile = "placement_bench.jsonl";
+    double maxPairs = 2.0e9;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            capsidSizes = {10000, 100000};
+            fusionSizes = {1000, 5000};
+        } else if (arg == "--capsid-sizes" && hasValue) {
+            if (!parseSizes(argv[++i], capsidSizes)) return 1;
+        } else if (arg == "--fusion-sizes" && hasValue) {
+            if (!parseSizes(argv[++i], fusionSizes)) return 1;
+        } else if (arg == "--shape" && hasValue) {
+            string shape = argv[++i];
+            if (shape == "both") {
+                shapes = {"sphere", "helix"};
+            } else if (shape == "sphere" || shape == "helix") {
+                shapes = {shape};
+            } else {
+                cerr << "Error: Unknown shape " << shape << endl;
+                return 1;
+            }
+        } else if (arg == "--max-pairs" && hasValue) {
+            maxPairs = atof(argv[++i]);
+        } else if (arg == "--output" && hasValue) {
+            outputFile = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [--quick] [--capsid-sizes N,N,...] [--fusion-sizes N,N,...]"
+                 << " [--shape sphere|helix|both] [--max-pairs N (0 = no limit)] [--output file]" << endl;
+            return 1;
+        }
+    }
+
+    ofstream json(outputFile);
+    if (!json.is_open()) {
+        cerr << "Error: Could not open " << outputFile << " for writing" << endl;
+        return 1;
+    }
+    json.precision(9);
+
+    // First line describes the machine and build so runs can be compared
+    json << "{\"type\":\"header\",\"compiler\":\"" << __VERSION__ << "\",\"hardware_threads\":"
+         << thread::hardware_concurrency() << ",\"seed\":" << benchSeed
+         << ",\"mindist_threshold\":" << mindist_threshold << "}\n";
+
+    int failedCases = runSamplerExhaustion(json) ? 0 : 1;
+    for (size_t s = 0; s < shapes.size(); ++s) {
+        for (size_t a = 0; a < capsidSizes.size(); ++a) {
+            for (size_t b = 0; b < fusionSizes.size(); ++b) {
+                BenchCase c = {shapes[s], capsidSizes[a], fusionSizes[b]};
+                if (!runCase(c, maxPairs, json)) failedCases++;
+            }
+        }
+    }
+
+    cout << "\nResults written to " << outputFile << endl;
+    if (failedCases > 0) {
+        cerr << "Error: " << failedCases << " case(s) failed their cross-checks" << endl;
+        return 2;
+    }
+    return 0;
+}